@@ -5,7 +5,6 @@
 # SPDX-License-Identifier: LGPL-3.0+
 
 import grpc  # type: ignore
-from google.protobuf import empty_pb2
 from api import prover_pb2  # type: ignore
 from api import prover_pb2_grpc  # type: ignore
 
@@ -21,7 +20,8 @@ class ProverClient:
         with grpc.insecure_channel(self.endpoint) as channel:
             stub = prover_pb2_grpc.ProverStub(channel)  # type: ignore
             print("-------------- Get the verification key --------------")
-            verificationkey = stub.GetVerificationKey(_make_empty_message())
+            verificationkey = stub.GetVerificationKey(
+                prover_pb2.VerificationKeyRequest())
             return verificationkey
 
     def get_proof(
@@ -35,7 +35,3 @@ class ProverClient:
             print("-------------- Get the proof --------------")
             proof = stub.Prove(proof_inputs)
             return proof
-
-
-def _make_empty_message() -> empty_pb2.Empty:
-    return empty_pb2.Empty()
@@ -0,0 +1,531 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+/// Benchmark of the hash gadgets (candidates for HashT and HashTreeT), and of
+/// the PRF and commitment gadgets built on HashT: constraint count,
+/// constraint generation, witness generation and native hash computation.
+
+#include "bench/bench_utils.hpp"
+#include "circuits/blake2s/blake2s_comp.hpp"
+#include "circuits/commitments/commitment.hpp"
+#include "circuits/mimc/mimc_mp.hpp"
+#include "circuits/poseidon/poseidon.hpp"
+#include "circuits/prfs/prf.hpp"
+#include "circuits/sha256/sha256_ethereum.hpp"
+#include "include_libsnark.hpp"
+
+#include <boost/program_options.hpp>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+
+using namespace libzeth;
+namespace po = boost::program_options;
+
+using ppT = libff::default_ec_pp;
+using FieldT = libff::Fr<ppT>;
+
+// -----------------------------------------------------------------------------
+// circuits
+// -----------------------------------------------------------------------------
+
+// Each circuit below holds a protoboard with a single gadget (and its inputs),
+// and exposes:
+//   - a constructor generating the constraints,
+//   - generate_r1cs_witness(rng), assigning random inputs and computing the
+//     witness of the gadget,
+//   - check(), comparing the witness to the native hash where there is one.
+
+static libff::bit_vector random_bit_vector(std::mt19937_64 &rng, size_t size)
+{
+    libff::bit_vector bits(size);
+    for (size_t i = 0; i < size; ++i) {
+        bits[i] = rng() & 1;
+    }
+    return bits;
+}
+
+static FieldT random_field_element(std::mt19937_64 &rng)
+{
+    return FieldT((long)(rng() >> 1));
+}
+
+/// Hash gadget with the HashT interface, on one block
+template<typename HashT> class block_hash_circuit
+{
+public:
+    libsnark::protoboard<FieldT> pb;
+    libsnark::block_variable<FieldT> input;
+    libsnark::digest_variable<FieldT> output;
+    HashT hasher;
+    libff::bit_vector input_bits;
+
+    block_hash_circuit()
+        : input(pb, HashT::get_block_len(), "input")
+        , output(pb, HashT::get_digest_len(), "output")
+        , hasher(pb, input, output, "hasher")
+    {
+        hasher.generate_r1cs_constraints(true);
+    }
+
+    void generate_r1cs_witness(std::mt19937_64 &rng)
+    {
+        input_bits = random_bit_vector(rng, HashT::get_block_len());
+        input.generate_r1cs_witness(input_bits);
+        hasher.generate_r1cs_witness();
+    }
+
+    bool check() const
+    {
+        return output.get_digest() == HashT::get_hash(input_bits);
+    }
+};
+
+/// Hash gadget with the HashTreeT interface
+template<typename HashTreeT> class tree_hash_circuit
+{
+public:
+    libsnark::protoboard<FieldT> pb;
+    libsnark::pb_variable<FieldT> x;
+    libsnark::pb_variable<FieldT> y;
+    std::unique_ptr<HashTreeT> hasher;
+
+    tree_hash_circuit()
+    {
+        x.allocate(pb, "x");
+        y.allocate(pb, "y");
+        hasher.reset(new HashTreeT(pb, x, y, "hasher"));
+        hasher->generate_r1cs_constraints();
+    }
+
+    void generate_r1cs_witness(std::mt19937_64 &rng)
+    {
+        pb.val(x) = random_field_element(rng);
+        pb.val(y) = random_field_element(rng);
+        hasher->generate_r1cs_witness();
+    }
+
+    bool check() const
+    {
+        return pb.val(hasher->result()) ==
+               HashTreeT::get_hash(pb.val(x), pb.val(y));
+    }
+};
+
+/// PRF or commitment gadget, on two bit string inputs `x` and `y`. The gadget
+/// is created by `make_gadget` (some gadgets only use `x`).
+template<typename GadgetT> class bits_gadget_circuit
+{
+public:
+    using make_gadget_fn = std::function<GadgetT *(
+        libsnark::protoboard<FieldT> &pb,
+        libsnark::pb_variable<FieldT> &ZERO,
+        libsnark::pb_variable_array<FieldT> &x,
+        libsnark::pb_variable_array<FieldT> &y,
+        std::shared_ptr<libsnark::digest_variable<FieldT>> result)>;
+
+    libsnark::protoboard<FieldT> pb;
+    libsnark::pb_variable<FieldT> ZERO;
+    libsnark::pb_variable_array<FieldT> x;
+    libsnark::pb_variable_array<FieldT> y;
+    std::shared_ptr<libsnark::digest_variable<FieldT>> result;
+    std::unique_ptr<GadgetT> gadget;
+
+    bits_gadget_circuit(
+        size_t x_size, size_t y_size, const make_gadget_fn &make_gadget)
+    {
+        ZERO.allocate(pb, "zero");
+        x.allocate(pb, x_size, "x");
+        y.allocate(pb, y_size, "y");
+        result.reset(new libsnark::digest_variable<FieldT>(pb, 256, "result"));
+        gadget.reset(make_gadget(pb, ZERO, x, y, result));
+        gadget->generate_r1cs_constraints();
+    }
+
+    void generate_r1cs_witness(std::mt19937_64 &rng)
+    {
+        pb.val(ZERO) = FieldT::zero();
+        x.fill_with_bits(pb, random_bit_vector(rng, x.size()));
+        y.fill_with_bits(pb, random_bit_vector(rng, y.size()));
+        gadget->generate_r1cs_witness();
+    }
+
+    // The PRFs and commitments have no native implementation (they are
+    // computed by the client), and are only checked for satisfiability.
+    bool check() const { return true; }
+};
+
+// -----------------------------------------------------------------------------
+// benchmark
+// -----------------------------------------------------------------------------
+
+/// Time the constraint and witness generation of the circuits created by
+/// `make_circuit`, and check their constraint count against `expected` (0 if
+/// unknown).
+template<typename CircuitT>
+static void bench_circuit(
+    const std::string &gadget,
+    size_t expected,
+    const std::function<CircuitT *()> &make_circuit,
+    size_t iterations,
+    uint64_t seed,
+    bench_results &results)
+{
+    std::cerr << "[INFO] Benchmarking " << gadget << std::endl;
+
+    // A new protoboard is used for each constraint generation, and the last
+    // one is used for the witness generation.
+    bench_timer timer;
+    std::vector<double> constraints_times;
+    std::unique_ptr<CircuitT> circuit;
+    for (size_t i = 0; i < iterations; ++i) {
+        timer.restart();
+        circuit.reset(make_circuit());
+        constraints_times.push_back(timer.elapsed());
+    }
+
+    const size_t num_constraints = circuit->pb.num_constraints();
+    if (expected != 0 && expected != num_constraints) {
+        std::cerr << "[ERROR] " << gadget << ": " << num_constraints
+                  << " constraints (expected " << expected << ")"
+                  << std::endl;
+    }
+
+    std::mt19937_64 rng(seed);
+    std::vector<double> witness_times;
+    for (size_t i = 0; i < iterations; ++i) {
+        timer.restart();
+        circuit->generate_r1cs_witness(rng);
+        witness_times.push_back(timer.elapsed());
+
+        if (i == 0 && (!circuit->pb.is_satisfied() || !circuit->check())) {
+            throw std::runtime_error("invalid witness for " + gadget);
+        }
+    }
+
+    const bench_params params{
+        {"gadget", gadget},
+        {"constraints", std::to_string(num_constraints)},
+        {"expected_constraints",
+         expected ? std::to_string(expected) : std::string("n/a")}};
+    results.add_stage(params, "generate_constraints").samples =
+        constraints_times;
+    results.add_stage(params, "generate_witness").samples = witness_times;
+}
+
+/// Time `hash_fn` (computing a native hash of inputs prepared beforehand), in
+/// batches of `batch_size` calls. The samples are the time per call, so that
+/// the throughput is 1 / mean.
+static void bench_native(
+    const std::string &gadget,
+    size_t iterations,
+    size_t batch_size,
+    const std::function<void(size_t)> &hash_fn,
+    bench_results &results)
+{
+    bench_stage &stage = results.add_stage(
+        {{"gadget", gadget},
+         {"constraints", "n/a"},
+         {"expected_constraints", "n/a"}},
+        "native_hash");
+
+    bench_timer timer;
+    for (size_t i = 0; i < iterations; ++i) {
+        timer.restart();
+        for (size_t j = 0; j < batch_size; ++j) {
+            hash_fn(j);
+        }
+        stage.samples.push_back(timer.elapsed() / batch_size);
+    }
+}
+
+template<typename HashT>
+static void bench_block_hash(
+    const std::string &gadget,
+    size_t iterations,
+    size_t batch_size,
+    uint64_t seed,
+    bench_results &results)
+{
+    bench_circuit<block_hash_circuit<HashT>>(
+        gadget,
+        HashT::expected_constraints(true),
+        []() { return new block_hash_circuit<HashT>(); },
+        iterations,
+        seed,
+        results);
+
+    std::mt19937_64 rng(seed);
+    std::vector<libff::bit_vector> inputs;
+    for (size_t j = 0; j < batch_size; ++j) {
+        inputs.push_back(random_bit_vector(rng, HashT::get_block_len()));
+    }
+    bench_native(
+        gadget,
+        iterations,
+        batch_size,
+        [&inputs](size_t j) { HashT::get_hash(inputs[j]); },
+        results);
+}
+
+template<typename HashTreeT>
+static void bench_tree_hash(
+    const std::string &gadget,
+    size_t iterations,
+    size_t batch_size,
+    uint64_t seed,
+    bench_results &results)
+{
+    bench_circuit<tree_hash_circuit<HashTreeT>>(
+        gadget,
+        HashTreeT::expected_constraints(),
+        []() { return new tree_hash_circuit<HashTreeT>(); },
+        iterations,
+        seed,
+        results);
+
+    std::mt19937_64 rng(seed);
+    std::vector<std::pair<FieldT, FieldT>> inputs;
+    for (size_t j = 0; j < batch_size; ++j) {
+        inputs.emplace_back(
+            random_field_element(rng), random_field_element(rng));
+    }
+    bench_native(
+        gadget,
+        iterations,
+        batch_size,
+        [&inputs](size_t j) {
+            HashTreeT::get_hash(inputs[j].first, inputs[j].second);
+        },
+        results);
+}
+
+template<typename GadgetT>
+static void bench_bits_gadget(
+    const std::string &gadget,
+    size_t x_size,
+    size_t y_size,
+    const typename bits_gadget_circuit<GadgetT>::make_gadget_fn &make_gadget,
+    size_t iterations,
+    uint64_t seed,
+    bench_results &results)
+{
+    bench_circuit<bits_gadget_circuit<GadgetT>>(
+        gadget,
+        0,
+        [&]() {
+            return new bits_gadget_circuit<GadgetT>(
+                x_size, y_size, make_gadget);
+        },
+        iterations,
+        seed,
+        results);
+}
+
+/// PRFs and commitments of the joinsplit circuit, instantiated with HashT
+template<typename HashT>
+static void bench_prfs_and_commitments(
+    const std::string &hash,
+    size_t iterations,
+    uint64_t seed,
+    bench_results &results)
+{
+    using namespace libsnark;
+    using digestT = std::shared_ptr<digest_variable<FieldT>>;
+
+    bench_bits_gadget<PRF_addr_a_pk_gadget<FieldT, HashT>>(
+        "PRF_addr_a_pk<" + hash + ">",
+        256,
+        0,
+        [](protoboard<FieldT> &pb,
+           pb_variable<FieldT> &ZERO,
+           pb_variable_array<FieldT> &a_sk,
+           pb_variable_array<FieldT> &,
+           digestT result) {
+            return new PRF_addr_a_pk_gadget<FieldT, HashT>(
+                pb, ZERO, a_sk, result);
+        },
+        iterations,
+        seed,
+        results);
+    bench_bits_gadget<PRF_nf_gadget<FieldT, HashT>>(
+        "PRF_nf<" + hash + ">",
+        256,
+        256,
+        [](protoboard<FieldT> &pb,
+           pb_variable<FieldT> &ZERO,
+           pb_variable_array<FieldT> &a_sk,
+           pb_variable_array<FieldT> &rho,
+           digestT result) {
+            return new PRF_nf_gadget<FieldT, HashT>(
+                pb, ZERO, a_sk, rho, result);
+        },
+        iterations,
+        seed,
+        results);
+    bench_bits_gadget<PRF_pk_gadget<FieldT, HashT>>(
+        "PRF_pk<" + hash + ">",
+        256,
+        256,
+        [](protoboard<FieldT> &pb,
+           pb_variable<FieldT> &ZERO,
+           pb_variable_array<FieldT> &a_sk,
+           pb_variable_array<FieldT> &h_sig,
+           digestT result) {
+            return new PRF_pk_gadget<FieldT, HashT>(
+                pb, ZERO, a_sk, h_sig, 0, result);
+        },
+        iterations,
+        seed,
+        results);
+    bench_bits_gadget<PRF_rho_gadget<FieldT, HashT>>(
+        "PRF_rho<" + hash + ">",
+        256,
+        256,
+        [](protoboard<FieldT> &pb,
+           pb_variable<FieldT> &ZERO,
+           pb_variable_array<FieldT> &phi,
+           pb_variable_array<FieldT> &h_sig,
+           digestT result) {
+            return new PRF_rho_gadget<FieldT, HashT>(
+                pb, ZERO, phi, h_sig, 0, result);
+        },
+        iterations,
+        seed,
+        results);
+    bench_bits_gadget<COMM_inner_k_gadget<FieldT, HashT>>(
+        "COMM_inner_k<" + hash + ">",
+        256,
+        256,
+        [](protoboard<FieldT> &pb,
+           pb_variable<FieldT> &,
+           pb_variable_array<FieldT> &a_pk,
+           pb_variable_array<FieldT> &rho,
+           digestT result) {
+            return new COMM_inner_k_gadget<FieldT, HashT>(
+                pb, a_pk, rho, result);
+        },
+        iterations,
+        seed,
+        results);
+    bench_bits_gadget<COMM_outer_k_gadget<FieldT, HashT>>(
+        "COMM_outer_k<" + hash + ">",
+        384,
+        256,
+        [](protoboard<FieldT> &pb,
+           pb_variable<FieldT> &,
+           pb_variable_array<FieldT> &trap_r,
+           pb_variable_array<FieldT> &inner_k,
+           digestT result) {
+            return new COMM_outer_k_gadget<FieldT, HashT>(
+                pb, trap_r, inner_k, result);
+        },
+        iterations,
+        seed,
+        results);
+    bench_bits_gadget<COMM_cm_gadget<FieldT, HashT>>(
+        "COMM_cm<" + hash + ">",
+        256,
+        64,
+        [](protoboard<FieldT> &pb,
+           pb_variable<FieldT> &ZERO,
+           pb_variable_array<FieldT> &outer_k,
+           pb_variable_array<FieldT> &value_v,
+           digestT result) {
+            return new COMM_cm_gadget<FieldT, HashT>(
+                pb, ZERO, outer_k, value_v, result);
+        },
+        iterations,
+        seed,
+        results);
+}
+
+// -----------------------------------------------------------------------------
+// main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    po::options_description options("Options");
+    options.add_options()("help,h", "This help")(
+        "iterations,n",
+        po::value<size_t>(),
+        "measurements per gadget and stage (default: 10)")(
+        "batch-size,b",
+        po::value<size_t>(),
+        "native hashes computed per measurement (default: 1000)")(
+        "no-prfs", "Only benchmark the hash gadgets")(
+        "seed", po::value<uint64_t>(), "seed of the inputs (default: 0)")(
+        "format,f", po::value<std::string>(), "json or csv (default: json)")(
+        "output,o", po::value<std::string>(), "output file (default: stdout)");
+
+    size_t iterations = 10;
+    size_t batch_size = 1000;
+    bool prfs = true;
+    uint64_t seed = 0;
+    std::string format = "json";
+    std::string output;
+    try {
+        po::variables_map vm;
+        po::store(
+            po::command_line_parser(argc, argv).options(options).run(), vm);
+        if (vm.count("help")) {
+            std::cout << "Usage:\n  " << argv[0] << " [<options>]\n\n"
+                      << options << std::endl;
+            return 0;
+        }
+        if (vm.count("iterations")) {
+            iterations = vm["iterations"].as<size_t>();
+        }
+        if (vm.count("batch-size")) {
+            batch_size = vm["batch-size"].as<size_t>();
+        }
+        if (iterations == 0 || batch_size == 0) {
+            throw std::invalid_argument("iterations and batch size must be >0");
+        }
+        prfs = !vm.count("no-prfs");
+        if (vm.count("seed")) {
+            seed = vm["seed"].as<uint64_t>();
+        }
+        if (vm.count("format")) {
+            format = vm["format"].as<std::string>();
+        }
+        if (vm.count("output")) {
+            output = vm["output"].as<std::string>();
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        std::cout << options << std::endl;
+        return 1;
+    }
+
+    ppT::init_public_params();
+    libff::inhibit_profiling_counters = true;
+    libff::inhibit_profiling_info = true;
+
+    bench_results results("bench_hash");
+    try {
+        bench_block_hash<BLAKE2s_256_comp<FieldT>>(
+            "BLAKE2s_256_comp", iterations, batch_size, seed, results);
+        bench_block_hash<sha256_ethereum<FieldT>>(
+            "sha256_ethereum", iterations, batch_size, seed, results);
+        bench_tree_hash<MiMC_mp_gadget<FieldT>>(
+            "MiMC_mp_gadget", iterations, batch_size, seed, results);
+        bench_tree_hash<Poseidon_gadget<FieldT>>(
+            "Poseidon_gadget", iterations, batch_size, seed, results);
+        if (prfs) {
+            bench_prfs_and_commitments<BLAKE2s_256_comp<FieldT>>(
+                "BLAKE2s_256_comp", iterations, seed, results);
+            bench_prfs_and_commitments<sha256_ethereum<FieldT>>(
+                "sha256_ethereum", iterations, seed, results);
+        }
+        results.write(format, output);
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,314 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+/// Benchmark of the joinsplit prover: witness generation, proof generation
+/// and verification, for several joinsplit sizes and thread counts.
+
+#include "bench/bench_utils.hpp"
+#include "circuit_types.hpp"
+#include "circuits/joinsplit.tcc"
+#include "snarks_alias.hpp"
+#include "snarks_core_imports.hpp"
+#include "util.hpp"
+
+#include <boost/program_options.hpp>
+#include <random>
+
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
+using namespace libzeth;
+namespace po = boost::program_options;
+
+// -----------------------------------------------------------------------------
+// workload
+// -----------------------------------------------------------------------------
+
+// The workloads are generated from a seeded PRNG, so that all runs (and all
+// machines) prove the same statements. All input notes have a zero value (so
+// their merkle paths are not checked), and the public input vpub_in is split
+// between the output notes.
+
+template<size_t Size> static bits<Size> random_bits(std::mt19937_64 &rng)
+{
+    std::vector<bool> vect(Size);
+    for (size_t i = 0; i < Size; ++i) {
+        vect[i] = rng() & 1;
+    }
+    return bits<Size>::from_vector(vect);
+}
+
+static FieldT random_field_element(std::mt19937_64 &rng)
+{
+    return FieldT((long)(rng() >> 1));
+}
+
+static bits64 value_to_bits64(uint64_t value)
+{
+    std::vector<bool> vect(64);
+    for (size_t i = 0; i < 64; ++i) {
+        vect[i] = (value >> (63 - i)) & 1;
+    }
+    return get_bits64_from_vector(vect);
+}
+
+template<size_t NumInputs, size_t NumOutputs>
+static joinsplit_proof_inputs<FieldT, NumInputs, NumOutputs> make_workload(
+    std::mt19937_64 &rng)
+{
+    joinsplit_proof_inputs<FieldT, NumInputs, NumOutputs> js;
+    js.root = random_field_element(rng);
+
+    for (joinsplit_input<FieldT> &input : js.inputs) {
+        input.witness_merkle_path.resize(ZETH_MERKLE_TREE_DEPTH);
+        for (FieldT &node : input.witness_merkle_path) {
+            node = random_field_element(rng);
+        }
+        input.address_bits = random_bits<ZETH_MERKLE_TREE_DEPTH>(rng);
+        input.note = zeth_note(
+            random_bits<256>(rng),
+            bits64(),
+            random_bits<256>(rng),
+            random_bits<384>(rng));
+        input.spending_key_a_sk = random_bits<256>(rng);
+        input.nullifier = random_bits<256>(rng);
+    }
+
+    uint64_t total = 0;
+    for (zeth_note &output : js.outputs) {
+        const uint64_t value = rng() >> 32;
+        total += value;
+        output = zeth_note(
+            random_bits<256>(rng),
+            value_to_bits64(value),
+            bits256(),
+            random_bits<384>(rng));
+    }
+
+    js.vpub_in = value_to_bits64(total);
+    js.vpub_out = bits64();
+    js.h_sig = random_bits<256>(rng);
+    js.phi = random_bits<256>(rng);
+    return js;
+}
+
+// -----------------------------------------------------------------------------
+// benchmark
+// -----------------------------------------------------------------------------
+
+template<size_t NumInputs, size_t NumOutputs>
+static void bench_joinsplit(
+    const std::vector<int> &threads,
+    size_t iterations,
+    uint64_t seed,
+    bench_results &results)
+{
+    using joinsplitT =
+        joinsplit_gadget<FieldT, HashT, HashTreeT, NumInputs, NumOutputs>;
+
+    const std::string circuit =
+        std::to_string(NumInputs) + "x" + std::to_string(NumOutputs);
+    std::cerr << "[INFO] Benchmarking joinsplit " << circuit << std::endl;
+
+    bench_timer timer;
+    libsnark::protoboard<FieldT> pb;
+    joinsplitT joinsplit(pb);
+    joinsplit.generate_r1cs_constraints();
+    const double constraints_time = timer.elapsed();
+
+    timer.restart();
+    const keyPairT<ppT> keypair = gen_trusted_setup<ppT>(pb);
+    const double setup_time = timer.elapsed();
+
+    // As in the prover server, the verification key is processed once
+    const processed_verification_key<ppT> processed_vk =
+        process_verification_key<ppT>(keypair.vk);
+
+    // The setup is only run once, with the default number of threads
+    const bench_params circuit_params{
+        {"circuit", circuit},
+        {"merkle_depth", std::to_string(ZETH_MERKLE_TREE_DEPTH)},
+        {"constraints", std::to_string(pb.num_constraints())},
+        {"threads", "default"}};
+    results.add_stage(circuit_params, "generate_constraints")
+        .samples.push_back(constraints_time);
+    results.add_stage(circuit_params, "trusted_setup")
+        .samples.push_back(setup_time);
+
+    for (const int num_threads : threads) {
+#ifdef MULTICORE
+        omp_set_num_threads(num_threads);
+#endif
+        bench_params params = circuit_params;
+        params.back().second = std::to_string(num_threads);
+
+        // The same statements are proven for each thread count
+        std::mt19937_64 rng(seed);
+        std::vector<double> witness_times;
+        std::vector<double> proof_times;
+        std::vector<double> verify_times;
+        for (size_t i = 0; i < iterations; ++i) {
+            const joinsplit_proof_inputs<FieldT, NumInputs, NumOutputs> js =
+                make_workload<NumInputs, NumOutputs>(rng);
+
+            timer.restart();
+            joinsplit.generate_r1cs_witness(
+                js.root,
+                js.inputs,
+                js.outputs,
+                js.vpub_in,
+                js.vpub_out,
+                js.h_sig,
+                js.phi);
+            witness_times.push_back(timer.elapsed());
+
+            if (i == 0 && !pb.is_satisfied()) {
+                throw std::runtime_error("unsatisfied benchmark workload");
+            }
+
+            timer.restart();
+            proofT<ppT> proof = gen_proof<ppT>(pb, keypair.pk);
+            proof_times.push_back(timer.elapsed());
+
+            libsnark::r1cs_primary_input<FieldT> primary_input =
+                pb.primary_input();
+            const extended_proof<ppT> ext_proof(proof, primary_input);
+            timer.restart();
+            const bool valid = verify<ppT>(ext_proof, processed_vk);
+            verify_times.push_back(timer.elapsed());
+            if (!valid) {
+                throw std::runtime_error("benchmark proof does not verify");
+            }
+        }
+
+        results.add_stage(params, "witness").samples = witness_times;
+        results.add_stage(params, "prove").samples = proof_times;
+        results.add_stage(params, "verify").samples = verify_times;
+    }
+}
+
+// Dispatch to the joinsplit sizes for which the benchmark is compiled
+static void bench_circuit(
+    const std::string &circuit,
+    const std::vector<int> &threads,
+    size_t iterations,
+    uint64_t seed,
+    bench_results &results)
+{
+    if (circuit == "1x1") {
+        bench_joinsplit<1, 1>(threads, iterations, seed, results);
+    } else if (circuit == "2x2") {
+        bench_joinsplit<2, 2>(threads, iterations, seed, results);
+    } else if (circuit == "4x4") {
+        bench_joinsplit<4, 4>(threads, iterations, seed, results);
+    } else {
+        throw std::invalid_argument("unsupported circuit: " + circuit);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// main
+// -----------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    po::options_description options("Options");
+    options.add_options()("help,h", "This help")(
+        "circuits,c",
+        po::value<std::string>(),
+        "comma-separated joinsplit sizes (<inputs>x<outputs>) among 1x1, 2x2 "
+        "and 4x4 (default: 2x2)")(
+        "threads,t",
+        po::value<std::string>(),
+        "comma-separated thread counts (default: 1)")(
+        "iterations,n",
+        po::value<size_t>(),
+        "proofs generated per configuration (default: 5)")(
+        "seed", po::value<uint64_t>(), "seed of the workload (default: 0)")(
+        "format,f", po::value<std::string>(), "json or csv (default: json)")(
+        "output,o", po::value<std::string>(), "output file (default: stdout)")(
+        "verbose,v", "Show the libsnark profiling output");
+
+    std::vector<std::string> circuits{"2x2"};
+    std::vector<int> threads{1};
+    size_t iterations = 5;
+    uint64_t seed = 0;
+    std::string format = "json";
+    std::string output;
+    bool verbose = false;
+    try {
+        po::variables_map vm;
+        po::store(
+            po::command_line_parser(argc, argv).options(options).run(), vm);
+        if (vm.count("help")) {
+            std::cout << "Usage:\n  " << argv[0] << " [<options>]\n\n"
+                      << options << std::endl;
+            return 0;
+        }
+        if (vm.count("circuits")) {
+            circuits = split_list(vm["circuits"].as<std::string>());
+        }
+        if (vm.count("threads")) {
+            threads.clear();
+            for (const std::string &t :
+                 split_list(vm["threads"].as<std::string>())) {
+                threads.push_back(std::stoi(t));
+            }
+        }
+        if (vm.count("iterations")) {
+            iterations = vm["iterations"].as<size_t>();
+        }
+        if (vm.count("seed")) {
+            seed = vm["seed"].as<uint64_t>();
+        }
+        if (vm.count("format")) {
+            format = vm["format"].as<std::string>();
+        }
+        if (vm.count("output")) {
+            output = vm["output"].as<std::string>();
+        }
+        verbose = vm.count("verbose");
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        std::cout << options << std::endl;
+        return 1;
+    }
+
+#ifndef MULTICORE
+    if (threads.size() != 1 || threads[0] != 1) {
+        std::cerr << "[INFO] Built without MULTICORE, running on 1 thread"
+                  << std::endl;
+        threads = {1};
+    }
+#endif
+
+    ppT::init_public_params();
+    if (!verbose) {
+        libff::inhibit_profiling_counters = true;
+        libff::inhibit_profiling_info = true;
+    }
+
+    // The gadgets write debug information to stdout, which is silenced
+    // unless asked for, so that results can be written to stdout.
+    std::streambuf *const cout_buf = std::cout.rdbuf();
+    if (!verbose) {
+        std::cout.rdbuf(nullptr);
+    }
+
+    bench_results results("bench_prover");
+    try {
+        for (const std::string &circuit : circuits) {
+            bench_circuit(circuit, threads, iterations, seed, results);
+        }
+        std::cout.rdbuf(cout_buf);
+        std::cout.clear();
+        results.write(format, output);
+    } catch (const std::exception &e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
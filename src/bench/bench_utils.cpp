@@ -0,0 +1,137 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "bench/bench_utils.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace libzeth
+{
+
+bench_stage::bench_stage(const bench_params &params, const std::string &name)
+    : params(params), name(name)
+{
+}
+
+double bench_stage::min() const
+{
+    return samples.empty() ? 0
+                           : *std::min_element(samples.begin(), samples.end());
+}
+
+double bench_stage::max() const
+{
+    return samples.empty() ? 0
+                           : *std::max_element(samples.begin(), samples.end());
+}
+
+double bench_stage::mean() const
+{
+    return samples.empty()
+               ? 0
+               : std::accumulate(samples.begin(), samples.end(), 0.0) /
+                     samples.size();
+}
+
+double bench_stage::median() const
+{
+    if (samples.empty()) {
+        return 0;
+    }
+
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    const size_t mid = sorted.size() / 2;
+    return (sorted.size() % 2) ? sorted[mid]
+                               : (sorted[mid - 1] + sorted[mid]) / 2;
+}
+
+bench_results::bench_results(const std::string &benchmark)
+    : benchmark(benchmark)
+{
+}
+
+bench_stage &bench_results::add_stage(
+    const bench_params &params, const std::string &name)
+{
+    stages.emplace_back(params, name);
+    return stages.back();
+}
+
+void bench_results::write_json(std::ostream &out) const
+{
+    out << "{\n  \"benchmark\": \"" << benchmark << "\",\n  \"results\": [";
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const bench_stage &stage = stages[i];
+        out << (i ? ",\n" : "\n") << "    {\"params\": {";
+        for (size_t j = 0; j < stage.params.size(); ++j) {
+            out << (j ? ", " : "") << "\"" << stage.params[j].first
+                << "\": \"" << stage.params[j].second << "\"";
+        }
+        out << "}, \"stage\": \"" << stage.name
+            << "\", \"iterations\": " << stage.samples.size()
+            << ", \"min\": " << stage.min()
+            << ", \"median\": " << stage.median()
+            << ", \"mean\": " << stage.mean() << ", \"max\": " << stage.max()
+            << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void bench_results::write_csv(std::ostream &out) const
+{
+    if (stages.empty()) {
+        return;
+    }
+
+    for (const auto &param : stages[0].params) {
+        out << param.first << ",";
+    }
+    out << "stage,iterations,min,median,mean,max\n";
+    for (const bench_stage &stage : stages) {
+        for (const auto &param : stage.params) {
+            out << param.second << ",";
+        }
+        out << stage.name << "," << stage.samples.size() << ","
+            << stage.min() << "," << stage.median() << "," << stage.mean()
+            << "," << stage.max() << "\n";
+    }
+}
+
+void bench_results::write(
+    const std::string &format, const std::string &filename) const
+{
+    std::ofstream file;
+    if (!filename.empty()) {
+        file.open(filename, std::ios_base::out);
+        if (!file) {
+            throw std::runtime_error("cannot open " + filename);
+        }
+    }
+    std::ostream &out = filename.empty() ? std::cout : file;
+
+    if (format == "json") {
+        write_json(out);
+    } else if (format == "csv") {
+        write_csv(out);
+    } else {
+        throw std::invalid_argument("unknown output format: " + format);
+    }
+}
+
+bench_timer::bench_timer() : start(std::chrono::steady_clock::now()) {}
+
+void bench_timer::restart() { start = std::chrono::steady_clock::now(); }
+
+double bench_timer::elapsed() const
+{
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+} // namespace libzeth
@@ -0,0 +1,79 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_BENCH_BENCH_UTILS_HPP__
+#define __ZETH_BENCH_BENCH_UTILS_HPP__
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Collection and output of benchmark timings, shared by the benchmark
+// executables.
+namespace libzeth
+{
+
+/// Named parameters of a benchmark configuration (circuit, number of threads,
+/// constraint count, ...), in the order in which they are output.
+using bench_params = std::vector<std::pair<std::string, std::string>>;
+
+/// Durations (in seconds) measured for one stage of a benchmark, in a given
+/// configuration.
+class bench_stage
+{
+public:
+    bench_params params;
+    std::string name;
+    std::vector<double> samples;
+
+    bench_stage(const bench_params &params, const std::string &name);
+
+    double min() const;
+    double max() const;
+    double mean() const;
+    double median() const;
+};
+
+class bench_results
+{
+public:
+    explicit bench_results(const std::string &benchmark);
+
+    /// Start the measurements of a stage. The returned reference is valid
+    /// until the next call.
+    bench_stage &add_stage(const bench_params &params, const std::string &name);
+
+    /// Output all stages, as a JSON document.
+    void write_json(std::ostream &out) const;
+
+    /// Output all stages, as CSV with one line per stage. All stages are
+    /// expected to have the same parameter names.
+    void write_csv(std::ostream &out) const;
+
+    /// Write the results to `filename` (or stdout if empty) in `format`
+    /// ("json" or "csv").
+    void write(const std::string &format, const std::string &filename) const;
+
+private:
+    const std::string benchmark;
+    std::vector<bench_stage> stages;
+};
+
+/// Simple stopwatch, returning elapsed times in seconds.
+class bench_timer
+{
+public:
+    bench_timer();
+    void restart();
+    double elapsed() const;
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace libzeth
+
+#endif // __ZETH_BENCH_BENCH_UTILS_HPP__
@@ -7,6 +7,7 @@
 
 #include "circuit_wrapper.hpp"
 #include "circuits/blake2s/blake2s_comp.hpp"
+#include "circuits/poseidon/poseidon.hpp"
 #include "include_libsnark.hpp"
 
 // Types that must be common across all executable, defined once here. Outside
@@ -22,7 +23,14 @@ using FieldT = libff::Fr<ppT>;
 // Hash used for the commitments and PRFs
 using HashT = BLAKE2s_256_comp<FieldT>;
 
-// Hash function to be used in the Merkle Tree
+// Hash function to be used in the Merkle Tree (see ZETH_TREE_HASH in
+// CMakeLists.txt)
+#if defined(ZETH_TREE_HASH_POSEIDON)
+using HashTreeT = Poseidon_gadget<FieldT>;
+#elif defined(ZETH_TREE_HASH_MIMC)
 using HashTreeT = MiMC_mp_gadget<FieldT>;
+#else
+#error "ZETH_TREE_HASH_MIMC or ZETH_TREE_HASH_POSEIDON must be defined"
+#endif
 
 #endif // __ZETH_CIRCUIT_TYPES_HPP__
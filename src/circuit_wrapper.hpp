@@ -7,15 +7,36 @@
 
 #include "circuits/joinsplit.tcc"
 #include "libsnark_helpers/libsnark_helpers.hpp"
+#include "libsnark_helpers/proving_context.hpp"
+#include "types/joinsplit.hpp"
 #include "types/note.hpp"
 
 // zkSNARK specific aliases and imports
 #include "snarks_alias.hpp"
 #include "snarks_core_imports.hpp"
 
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
 namespace libzeth
 {
 
+/// How the witness computed for a proof is checked against the constraint
+/// system, before the (expensive) proof generation starts.
+enum satisfiability_check {
+    // No check, for inputs from a trusted source. A proof generated from an
+    // invalid witness does not verify.
+    satisfiability_check_skip,
+    // Evaluate all constraints, and reject the request if any is not
+    // satisfied
+    satisfiability_check_reject,
+    // Evaluate a random sample of the constraints, and reject the request if
+    // any of them is not satisfied
+    satisfiability_check_sample,
+};
+
 template<
     typename FieldT,
     typename HashT,
@@ -26,13 +47,31 @@ template<
 class circuit_wrapper
 {
 public:
+    using joinsplit_type =
+        joinsplit_gadget<FieldT, HashT, HashTreeT, NumInputs, NumOutputs>;
+
     boost::filesystem::path setup_path;
-    std::shared_ptr<
-        joinsplit_gadget<FieldT, HashT, HashTreeT, NumInputs, NumOutputs>>
-        joinsplit_g;
 
-    circuit_wrapper(const boost::filesystem::path setup_path = "")
-        : setup_path(setup_path){};
+    // Prepared circuit. The protoboard and the joinsplit gadget are allocated,
+    // and the constraint system generated, once at construction time. Each
+    // call to `prove` then only (re)computes the witness.
+    libsnark::protoboard<FieldT> pb;
+    std::shared_ptr<joinsplit_type> joinsplit_g;
+
+    // Check applied to each witness (see `satisfiability_check`), and number
+    // of constraints evaluated with `satisfiability_check_sample`
+    const satisfiability_check sat_check;
+    const size_t sat_check_samples;
+
+    circuit_wrapper(
+        const boost::filesystem::path setup_path = "",
+        satisfiability_check sat_check = satisfiability_check_reject,
+        size_t sat_check_samples = 1024);
+
+    // The joinsplit gadget holds a reference to `pb`, hence the wrapper can
+    // neither be copied nor assigned.
+    circuit_wrapper(const circuit_wrapper &) = delete;
+    circuit_wrapper &operator=(const circuit_wrapper &) = delete;
 
     // Generate the trusted setup
     keyPairT<ppT> generate_trusted_setup() const;
@@ -43,7 +82,9 @@ public:
     void dump_constraint_system(boost::filesystem::path file_path) const;
 #endif
 
-    // Generate a proof and returns an extended proof
+    // Generate a proof and returns an extended proof. The witness is written
+    // on the shared protoboard, so concurrent calls are serialized. Throws
+    // std::invalid_argument if the witness fails the satisfiability check.
     extended_proof<ppT> prove(
         const FieldT &root,
         const std::array<joinsplit_input<FieldT>, NumInputs> &inputs,
@@ -53,6 +94,51 @@ public:
         const bits256 h_sig_in,
         const bits256 phi_in,
         const provingKeyT<ppT> &proving_key) const;
+
+    // Generate the proofs of several joinsplits. The witnesses are computed on
+    // the prepared circuit, and the proofs are then generated together in a
+    // single pass over the proving key (see `gen_proof_batch`). As for
+    // `prove`, concurrent calls are serialized.
+    std::vector<extended_proof<ppT>> prove_batch(
+        const std::vector<
+            joinsplit_proof_inputs<FieldT, NumInputs, NumOutputs>> &batch,
+        const provingKeyT<ppT> &proving_key) const;
+
+private:
+    // Guards the witness assignment of `pb` and `context` during `prove` and
+    // `prove_batch`
+    mutable std::mutex prove_mutex;
+
+    // Witness buffers passed to the prover, reused across requests (each
+    // proving worker owns a circuit_wrapper, hence a context)
+    mutable proving_context<FieldT> context;
+
+    // Copy of the constraint system of `pb` (which is only accessible by
+    // copy), kept for `satisfiability_check_sample`
+    std::unique_ptr<libsnark::r1cs_constraint_system<FieldT>> constraints;
+    mutable std::mt19937_64 sample_rng;
+
+    // Apply `sat_check` to the witness on `pb`. The caller must hold
+    // `prove_mutex`.
+    void check_witness() const;
+
+    // Throw std::invalid_argument, reporting the first unsatisfied constraint
+    // of `cs` among `indices`, if any.
+    static void check_constraints(
+        const libsnark::r1cs_constraint_system<FieldT> &cs,
+        const libsnark::r1cs_variable_assignment<FieldT> &assignment,
+        const std::vector<size_t> &indices);
+
+    // Check the joinsplit balance and compute the witness on `pb`. The caller
+    // must hold `prove_mutex`.
+    void generate_witness(
+        const FieldT &root,
+        const std::array<joinsplit_input<FieldT>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        bits64 vpub_in,
+        bits64 vpub_out,
+        const bits256 h_sig_in,
+        const bits256 phi_in) const;
 };
 
 } // namespace libzeth
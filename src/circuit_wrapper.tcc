@@ -5,11 +5,43 @@
 #ifndef __ZETH_CIRCUIT_WRAPPER_TCC__
 #define __ZETH_CIRCUIT_WRAPPER_TCC__
 
+#include "metrics.hpp"
 #include "zeth.h"
 
+#include <algorithm>
+#include <numeric>
+
 namespace libzeth
 {
 
+template<
+    typename FieldT,
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    size_t NumInputs,
+    size_t NumOutputs>
+circuit_wrapper<FieldT, HashT, HashTreeT, ppT, NumInputs, NumOutputs>::
+    circuit_wrapper(
+        const boost::filesystem::path setup_path,
+        satisfiability_check sat_check,
+        size_t sat_check_samples)
+    : setup_path(setup_path)
+    , sat_check(sat_check)
+    , sat_check_samples(sat_check_samples)
+    , sample_rng(std::random_device()())
+{
+    // The constraint system only depends on NumInputs and NumOutputs, so it is
+    // generated once here and shared by all subsequent proofs
+    joinsplit_g = std::make_shared<joinsplit_type>(pb);
+    joinsplit_g->generate_r1cs_constraints();
+
+    if (sat_check == satisfiability_check_sample) {
+        constraints.reset(new libsnark::r1cs_constraint_system<FieldT>(
+            pb.get_constraint_system()));
+    }
+}
+
 template<
     typename FieldT,
     typename HashT,
@@ -25,10 +57,6 @@ keyPairT<ppT> circuit_wrapper<
     NumInputs,
     NumOutputs>::generate_trusted_setup() const
 {
-    libsnark::protoboard<FieldT> pb;
-    joinsplit_gadget<FieldT, HashT, HashTreeT, NumInputs, NumOutputs> g(pb);
-    g.generate_r1cs_constraints();
-
     // Generate a verification and proving key (trusted setup)
     // and write them in a file
     keyPairT<ppT> keypair = gen_trusted_setup<ppT>(pb);
@@ -48,10 +76,6 @@ template<
 void circuit_wrapper<FieldT, HashT, HashTreeT, ppT, NumInputs, NumOutputs>::
     dump_constraint_system(boost::filesystem::path file_path) const
 {
-    libsnark::protoboard<FieldT> pb;
-    joinsplit_gadget<FieldT, HashT, HashTreeT, NumInputs, NumOutputs> g(pb);
-    g.generate_r1cs_constraints();
-
     // Write the constraint system in the default location
     r1cs_to_json<ppT>(pb, file_path);
 }
@@ -64,22 +88,15 @@ template<
     typename ppT,
     size_t NumInputs,
     size_t NumOutputs>
-extended_proof<ppT> circuit_wrapper<
-    FieldT,
-    HashT,
-    HashTreeT,
-    ppT,
-    NumInputs,
-    NumOutputs>::
-    prove(
+void circuit_wrapper<FieldT, HashT, HashTreeT, ppT, NumInputs, NumOutputs>::
+    generate_witness(
         const FieldT &root,
         const std::array<joinsplit_input<FieldT>, NumInputs> &inputs,
         const std::array<zeth_note, NumOutputs> &outputs,
         bits64 vpub_in,
         bits64 vpub_out,
         const bits256 h_sig_in,
-        const bits256 phi_in,
-        const provingKeyT<ppT> &proving_key) const
+        const bits256 phi_in) const
 {
     // left hand side and right hand side of the joinsplit
     bits64 lhs_value = vpub_in;
@@ -103,29 +120,181 @@ extended_proof<ppT> circuit_wrapper<
         throw std::invalid_argument("invalid joinsplit balance");
     }
 
-    libsnark::protoboard<FieldT> pb;
-    joinsplit_gadget<FieldT, HashT, HashTreeT, NumInputs, NumOutputs> g(pb);
-    g.generate_r1cs_constraints();
-    g.generate_r1cs_witness(
-        root, inputs, outputs, vpub_in, vpub_out, h_sig_in, phi_in);
+    // The constraints have already been generated on `pb` (see constructor),
+    // only the witness needs to be computed for this request
+    {
+        metrics_timer timer("witness_generation");
+        joinsplit_g->generate_r1cs_witness(
+            root, inputs, outputs, vpub_in, vpub_out, h_sig_in, phi_in);
+    }
+
+    check_witness();
+}
+
+template<
+    typename FieldT,
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    size_t NumInputs,
+    size_t NumOutputs>
+void circuit_wrapper<FieldT, HashT, HashTreeT, ppT, NumInputs, NumOutputs>::
+    check_witness() const
+{
+    if (sat_check == satisfiability_check_skip) {
+        return;
+    }
+
+    metrics_timer timer("satisfiability_check");
+    if (sat_check == satisfiability_check_reject) {
+        if (pb.is_satisfied()) {
+            return;
+        }
+
+        // Only copy the constraint system to report the failure
+        const libsnark::r1cs_constraint_system<FieldT> cs =
+            pb.get_constraint_system();
+        std::vector<size_t> indices(cs.num_constraints());
+        std::iota(indices.begin(), indices.end(), 0);
+        check_constraints(cs, pb.full_variable_assignment(), indices);
+        throw std::invalid_argument("unsatisfied constraint system");
+    }
+
+    // satisfiability_check_sample
+    if (constraints->num_constraints() == 0) {
+        return;
+    }
+    std::uniform_int_distribution<size_t> distribution(
+        0, constraints->num_constraints() - 1);
+    std::vector<size_t> indices(sat_check_samples);
+    for (size_t &index : indices) {
+        index = distribution(sample_rng);
+    }
+    std::sort(indices.begin(), indices.end());
+    check_constraints(*constraints, pb.full_variable_assignment(), indices);
+}
+
+template<
+    typename FieldT,
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    size_t NumInputs,
+    size_t NumOutputs>
+void circuit_wrapper<FieldT, HashT, HashTreeT, ppT, NumInputs, NumOutputs>::
+    check_constraints(
+        const libsnark::r1cs_constraint_system<FieldT> &cs,
+        const libsnark::r1cs_variable_assignment<FieldT> &assignment,
+        const std::vector<size_t> &indices)
+{
+    for (const size_t i : indices) {
+        const libsnark::r1cs_constraint<FieldT> &constraint = cs.constraints[i];
+        const FieldT a = constraint.a.evaluate(assignment);
+        const FieldT b = constraint.b.evaluate(assignment);
+        const FieldT c = constraint.c.evaluate(assignment);
+        if (a * b == c) {
+            continue;
+        }
+
+        std::string message = "unsatisfied constraint " + std::to_string(i);
+#ifdef DEBUG
+        // Annotations are only recorded by libsnark in DEBUG builds
+        const auto annotation = cs.constraint_annotations.find(i);
+        if (annotation != cs.constraint_annotations.end()) {
+            message += ": " + annotation->second;
+        }
+#endif
+        throw std::invalid_argument(message);
+    }
+}
 
-    bool is_valid_witness = pb.is_satisfied();
-    std::cout << "******* [DEBUG] Satisfiability result: " << is_valid_witness
-              << " *******" << std::endl;
+template<
+    typename FieldT,
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    size_t NumInputs,
+    size_t NumOutputs>
+extended_proof<ppT> circuit_wrapper<
+    FieldT,
+    HashT,
+    HashTreeT,
+    ppT,
+    NumInputs,
+    NumOutputs>::
+    prove(
+        const FieldT &root,
+        const std::array<joinsplit_input<FieldT>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        bits64 vpub_in,
+        bits64 vpub_out,
+        const bits256 h_sig_in,
+        const bits256 phi_in,
+        const provingKeyT<ppT> &proving_key) const
+{
+    std::lock_guard<std::mutex> lock(prove_mutex);
+    generate_witness(
+        root, inputs, outputs, vpub_in, vpub_out, h_sig_in, phi_in);
 
-    proofT<ppT> proof = libzeth::gen_proof<ppT>(pb, proving_key);
-    libsnark::r1cs_primary_input<libff::Fr<ppT>> primary_input =
-        pb.primary_input();
+    // The witness is copied into the buffers of the previous requests, and
+    // passed by reference to the prover
+    context.reset(1);
+    context.load_witness(pb, 0);
+    proofT<ppT> proof = libzeth::gen_proof_batch<ppT>(
+        context.primary_inputs, context.auxiliary_inputs, proving_key)[0];
 
     // Instantiate an extended_proof from the proof we generated and the given
-    // primary_input
-    extended_proof<ppT> ext_proof = extended_proof<ppT>(proof, primary_input);
+    // primary_input. Callers wishing to keep a record of the proofs can pass
+    // it to a `proof_sink`.
+    return extended_proof<ppT>(proof, context.primary_inputs[0]);
+}
 
-    // Write the extended proof in a file (Default path is taken if not
-    // specified)
-    ext_proof.write_extended_proof();
+template<
+    typename FieldT,
+    typename HashT,
+    typename HashTreeT,
+    typename ppT,
+    size_t NumInputs,
+    size_t NumOutputs>
+std::vector<extended_proof<ppT>> circuit_wrapper<
+    FieldT,
+    HashT,
+    HashTreeT,
+    ppT,
+    NumInputs,
+    NumOutputs>::
+    prove_batch(
+        const std::vector<
+            joinsplit_proof_inputs<FieldT, NumInputs, NumOutputs>> &batch,
+        const provingKeyT<ppT> &proving_key) const
+{
+    // Compute the witnesses on the prepared circuit, keeping a copy of the
+    // assignments (in the reused buffers of `context`) for the batched prover
+    std::lock_guard<std::mutex> lock(prove_mutex);
+    context.reset(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        const auto &js = batch[i];
+        generate_witness(
+            js.root,
+            js.inputs,
+            js.outputs,
+            js.vpub_in,
+            js.vpub_out,
+            js.h_sig,
+            js.phi);
+        context.load_witness(pb, i);
+    }
+
+    std::vector<proofT<ppT>> proofs = libzeth::gen_proof_batch<ppT>(
+        context.primary_inputs, context.auxiliary_inputs, proving_key);
+
+    std::vector<extended_proof<ppT>> ext_proofs;
+    ext_proofs.reserve(proofs.size());
+    for (size_t i = 0; i < proofs.size(); ++i) {
+        ext_proofs.emplace_back(proofs[i], context.primary_inputs[i]);
+    }
 
-    return ext_proof;
+    return ext_proofs;
 }
 
 } // namespace libzeth
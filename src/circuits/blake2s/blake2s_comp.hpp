@@ -5,12 +5,14 @@
 #ifndef __ZETH_CIRCUITS_BLAKE2S_COMP_HPP__
 #define __ZETH_CIRCUITS_BLAKE2S_COMP_HPP__
 
+#include "blake2s_native.hpp"
 #include "circuits/binary_operation.hpp"
 #include "circuits/circuits-utils.hpp"
 #include "g_primitive.hpp"
 #include "types/bits.hpp"
 #include "util.hpp"
 
+#include <algorithm>
 #include <libsnark/gadgetlib1/gadget.hpp>
 #include <libsnark/gadgetlib1/gadgets/basic_gadgets.hpp>
 #include <libsnark/gadgetlib1/gadgets/hashes/hash_io.hpp>
@@ -102,7 +104,13 @@ public:
 
     static size_t get_block_len();
     static size_t get_digest_len();
+    /// Hash of a single block, computed natively (without instantiating the
+    /// gadget). Returns the same digest as the gadget for `input`.
     static libff::bit_vector get_hash(const libff::bit_vector &input);
+    /// Hash of several independent blocks, computed natively over multiple
+    /// lanes (see blake2s_256_compress_native_many).
+    static std::vector<libff::bit_vector> get_hash(
+        const std::vector<libff::bit_vector> &inputs);
 
     static size_t expected_constraints(const bool ensure_output_bitness);
 
@@ -112,6 +120,12 @@ public:
     void setup_counter(size_t len_input_block);
     void setup_v();
     void setup_mixing_gadgets();
+
+private:
+    // Helper functions for the native computation of the hash
+    static uint64_t native_block(
+        const libff::bit_vector &input, uint8_t *block);
+    static libff::bit_vector native_digest(const uint8_t *digest);
 };
 
 } // namespace libzeth
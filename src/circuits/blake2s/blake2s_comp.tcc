@@ -169,19 +169,68 @@ template<typename FieldT>
 libff::bit_vector BLAKE2s_256_comp<FieldT>::get_hash(
     const libff::bit_vector &input)
 {
-    libsnark::protoboard<FieldT> pb;
+    uint8_t block[BLAKE2s_block_bytes];
+    uint8_t digest[BLAKE2s_digest_bytes];
+    const uint64_t byte_len = native_block(input, block);
+    blake2s_256_compress_native(block, byte_len, digest);
+    return native_digest(digest);
+}
+
+template<typename FieldT>
+std::vector<libff::bit_vector> BLAKE2s_256_comp<FieldT>::get_hash(
+    const std::vector<libff::bit_vector> &inputs)
+{
+    const size_t num_blocks = inputs.size();
+    std::vector<uint8_t> blocks(num_blocks * BLAKE2s_block_bytes);
+    std::vector<uint64_t> byte_lens(num_blocks);
+    std::vector<uint8_t> digests(num_blocks * BLAKE2s_digest_bytes);
+
+    for (size_t i = 0; i < num_blocks; i++) {
+        byte_lens[i] =
+            native_block(inputs[i], blocks.data() + i * BLAKE2s_block_bytes);
+    }
 
-    libsnark::block_variable<FieldT> input_block(
-        pb, BLAKE2s_block_size, "input_block");
-    libsnark::digest_variable<FieldT> output_variable(
-        pb, BLAKE2s_digest_size, "output_variable");
-    BLAKE2s_256_comp<FieldT> blake2s_hasher(
-        pb, input_block, output_variable, "blake2s_hasher_gadget");
+    blake2s_256_compress_native_many(
+        blocks.data(), byte_lens.data(), num_blocks, digests.data());
 
-    input_block.generate_r1cs_witness(input);
-    blake2s_hasher.generate_r1cs_witness();
+    std::vector<libff::bit_vector> outputs;
+    outputs.reserve(num_blocks);
+    for (size_t i = 0; i < num_blocks; i++) {
+        outputs.push_back(
+            native_digest(digests.data() + i * BLAKE2s_digest_bytes));
+    }
+    return outputs;
+}
 
-    return output_variable.get_digest();
+// Pack the (big endian) input bits into a zero-padded block of bytes, and
+// return the value of the offset counter. As in generate_r1cs_witness, the
+// counter is the number of full bytes of the input.
+template<typename FieldT>
+uint64_t BLAKE2s_256_comp<FieldT>::native_block(
+    const libff::bit_vector &input, uint8_t *block)
+{
+    if (input.size() > BLAKE2s_block_size) {
+        throw std::length_error("input exceeds the BLAKE2s block size");
+    }
+
+    std::fill(block, block + BLAKE2s_block_bytes, 0);
+    for (size_t i = 0; i < input.size(); i++) {
+        if (input[i]) {
+            block[i / 8] |= uint8_t(0x80 >> (i % 8));
+        }
+    }
+
+    return input.size() / 8;
+}
+
+template<typename FieldT>
+libff::bit_vector BLAKE2s_256_comp<FieldT>::native_digest(const uint8_t *digest)
+{
+    libff::bit_vector output(BLAKE2s_digest_size);
+    for (size_t i = 0; i < BLAKE2s_digest_size; i++) {
+        output[i] = (digest[i / 8] >> (7 - (i % 8))) & 1;
+    }
+    return output;
 }
 
 } // namespace libzeth
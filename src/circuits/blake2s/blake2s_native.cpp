@@ -0,0 +1,286 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "circuits/blake2s/blake2s_native.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace libzeth
+{
+
+namespace
+{
+
+// See: Appendix A.2 of https://blake2.net/blake2.pdf
+const uint32_t blake2s_iv[8] = {0x6A09E667,
+                                0xBB67AE85,
+                                0x3C6EF372,
+                                0xA54FF53A,
+                                0x510E527F,
+                                0x9B05688C,
+                                0x1F83D9AB,
+                                0x5BE0CD19};
+
+// See: Appendix A.1 of https://blake2.net/blake2.pdf
+const uint8_t blake2s_sigma[10][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0}};
+
+// Parameter block word 0, as set by BLAKE2s_256_comp::setup_h: digest length
+// 32 bytes, no key, fanout 1, depth 1
+const uint32_t blake2s_param_0 = 0x01010020;
+
+inline uint32_t load_u32_le(const uint8_t *src)
+{
+    return uint32_t(src[0]) | (uint32_t(src[1]) << 8) |
+           (uint32_t(src[2]) << 16) | (uint32_t(src[3]) << 24);
+}
+
+inline void store_u32_le(uint8_t *dst, uint32_t w)
+{
+    dst[0] = uint8_t(w);
+    dst[1] = uint8_t(w >> 8);
+    dst[2] = uint8_t(w >> 16);
+    dst[3] = uint8_t(w >> 24);
+}
+
+// Word operations used by the compression function. Each "word" holds the
+// same state word for every lane, so that the rounds below are written once
+// for the scalar and vectorized versions.
+struct scalar_ops {
+    typedef uint32_t word;
+    static const size_t lanes = 1;
+
+    static word load(const uint32_t *src) { return *src; }
+    static void store(uint32_t *dst, word w) { *dst = w; }
+    static word set1(uint32_t w) { return w; }
+    static word add(word a, word b) { return a + b; }
+    static word xor_(word a, word b) { return a ^ b; }
+    template<int n> static word rotr(word a)
+    {
+        return (a >> n) | (a << (32 - n));
+    }
+};
+
+#if defined(__AVX2__)
+
+struct avx2_ops {
+    typedef __m256i word;
+    static const size_t lanes = 8;
+
+    static word load(const uint32_t *src)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+    }
+    static void store(uint32_t *dst, word w)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), w);
+    }
+    static word set1(uint32_t w) { return _mm256_set1_epi32(int(w)); }
+    static word add(word a, word b) { return _mm256_add_epi32(a, b); }
+    static word xor_(word a, word b) { return _mm256_xor_si256(a, b); }
+    template<int n> static word rotr(word a)
+    {
+        return _mm256_or_si256(
+            _mm256_srli_epi32(a, n), _mm256_slli_epi32(a, 32 - n));
+    }
+};
+
+typedef avx2_ops lane_ops;
+
+#elif defined(__SSE2__)
+
+struct sse2_ops {
+    typedef __m128i word;
+    static const size_t lanes = 4;
+
+    static word load(const uint32_t *src)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    }
+    static void store(uint32_t *dst, word w)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), w);
+    }
+    static word set1(uint32_t w) { return _mm_set1_epi32(int(w)); }
+    static word add(word a, word b) { return _mm_add_epi32(a, b); }
+    static word xor_(word a, word b) { return _mm_xor_si128(a, b); }
+    template<int n> static word rotr(word a)
+    {
+        return _mm_or_si128(_mm_srli_epi32(a, n), _mm_slli_epi32(a, 32 - n));
+    }
+};
+
+typedef sse2_ops lane_ops;
+
+#else
+
+typedef scalar_ops lane_ops;
+
+#endif
+
+// Mixing function G. See: Section 3.1 of https://tools.ietf.org/html/rfc7693
+template<typename Ops>
+inline void g(
+    typename Ops::word *v,
+    size_t a,
+    size_t b,
+    size_t c,
+    size_t d,
+    typename Ops::word x,
+    typename Ops::word y)
+{
+    v[a] = Ops::add(Ops::add(v[a], v[b]), x);
+    v[d] = Ops::template rotr<16>(Ops::xor_(v[d], v[a]));
+    v[c] = Ops::add(v[c], v[d]);
+    v[b] = Ops::template rotr<12>(Ops::xor_(v[b], v[c]));
+    v[a] = Ops::add(Ops::add(v[a], v[b]), y);
+    v[d] = Ops::template rotr<8>(Ops::xor_(v[d], v[a]));
+    v[c] = Ops::add(v[c], v[d]);
+    v[b] = Ops::template rotr<7>(Ops::xor_(v[b], v[c]));
+}
+
+// Compress Ops::lanes blocks at once. Inputs are given word-major: m[i] holds
+// the i-th message word of each lane (and similarly for t0, t1, h_out).
+template<typename Ops>
+void compress_lanes(
+    const uint32_t (*m)[Ops::lanes],
+    const uint32_t *t0,
+    const uint32_t *t1,
+    uint32_t (*h_out)[Ops::lanes])
+{
+    typedef typename Ops::word word;
+
+    word msg[16];
+    for (size_t i = 0; i < 16; i++) {
+        msg[i] = Ops::load(m[i]);
+    }
+
+    word h[8];
+    for (size_t i = 0; i < 8; i++) {
+        h[i] = Ops::set1(blake2s_iv[i]);
+    }
+    h[0] = Ops::set1(blake2s_iv[0] ^ blake2s_param_0);
+
+    // Initialize the state. See: Section 3.2 of
+    // https://tools.ietf.org/html/rfc7693
+    word v[16];
+    for (size_t i = 0; i < 8; i++) {
+        v[i] = h[i];
+        v[i + 8] = Ops::set1(blake2s_iv[i]);
+    }
+    v[12] = Ops::xor_(v[12], Ops::load(t0));
+    v[13] = Ops::xor_(v[13], Ops::load(t1));
+    // Single block: the first block is the last (f0 = 0xFFFFFFFF, f1 = 0)
+    v[14] = Ops::xor_(v[14], Ops::set1(0xFFFFFFFF));
+
+    for (size_t r = 0; r < 10; r++) {
+        const uint8_t *s = blake2s_sigma[r];
+        g<Ops>(v, 0, 4, 8, 12, msg[s[0]], msg[s[1]]);
+        g<Ops>(v, 1, 5, 9, 13, msg[s[2]], msg[s[3]]);
+        g<Ops>(v, 2, 6, 10, 14, msg[s[4]], msg[s[5]]);
+        g<Ops>(v, 3, 7, 11, 15, msg[s[6]], msg[s[7]]);
+        g<Ops>(v, 0, 5, 10, 15, msg[s[8]], msg[s[9]]);
+        g<Ops>(v, 1, 6, 11, 12, msg[s[10]], msg[s[11]]);
+        g<Ops>(v, 2, 7, 8, 13, msg[s[12]], msg[s[13]]);
+        g<Ops>(v, 3, 4, 9, 14, msg[s[14]], msg[s[15]]);
+    }
+
+    for (size_t i = 0; i < 8; i++) {
+        Ops::store(h_out[i], Ops::xor_(h[i], Ops::xor_(v[i], v[i + 8])));
+    }
+}
+
+// Transpose `num_blocks` (<= Ops::lanes) blocks into lanes, compress them and
+// write back the digests. Unused lanes are left zeroed and their output is
+// discarded.
+template<typename Ops>
+void compress_blocks(
+    const uint8_t *blocks,
+    const uint64_t *byte_lens,
+    size_t num_blocks,
+    uint8_t *digests)
+{
+    uint32_t m[16][Ops::lanes] = {};
+    uint32_t t0[Ops::lanes] = {};
+    uint32_t t1[Ops::lanes] = {};
+    uint32_t h[8][Ops::lanes];
+
+    for (size_t lane = 0; lane < num_blocks; lane++) {
+        const uint8_t *block = blocks + lane * BLAKE2s_block_bytes;
+        for (size_t i = 0; i < 16; i++) {
+            m[i][lane] = load_u32_le(block + 4 * i);
+        }
+        t0[lane] = uint32_t(byte_lens[lane]);
+        t1[lane] = uint32_t(byte_lens[lane] >> 32);
+    }
+
+    compress_lanes<Ops>(m, t0, t1, h);
+
+    for (size_t lane = 0; lane < num_blocks; lane++) {
+        uint8_t *digest = digests + lane * BLAKE2s_digest_bytes;
+        for (size_t i = 0; i < 8; i++) {
+            store_u32_le(digest + 4 * i, h[i][lane]);
+        }
+    }
+}
+
+} // namespace
+
+void blake2s_256_compress_native(
+    const uint8_t *block, uint64_t byte_len, uint8_t *digest)
+{
+    compress_blocks<scalar_ops>(block, &byte_len, 1, digest);
+}
+
+void blake2s_256_compress_native_many(
+    const uint8_t *blocks,
+    const uint64_t *byte_lens,
+    size_t num_blocks,
+    uint8_t *digests)
+{
+    const size_t lanes = lane_ops::lanes;
+    size_t i = 0;
+
+    // Full groups of lanes first, then a single (possibly partial) group for
+    // the remaining blocks, unless it is a lone block.
+    for (; i + lanes <= num_blocks; i += lanes) {
+        compress_blocks<lane_ops>(
+            blocks + i * BLAKE2s_block_bytes,
+            byte_lens + i,
+            lanes,
+            digests + i * BLAKE2s_digest_bytes);
+    }
+
+    const size_t remaining = num_blocks - i;
+    if (remaining > 1) {
+        compress_blocks<lane_ops>(
+            blocks + i * BLAKE2s_block_bytes,
+            byte_lens + i,
+            remaining,
+            digests + i * BLAKE2s_digest_bytes);
+    } else if (remaining == 1) {
+        compress_blocks<scalar_ops>(
+            blocks + i * BLAKE2s_block_bytes,
+            byte_lens + i,
+            1,
+            digests + i * BLAKE2s_digest_bytes);
+    }
+}
+
+size_t blake2s_native_lanes() { return lane_ops::lanes; }
+
+} // namespace libzeth
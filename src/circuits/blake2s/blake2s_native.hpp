@@ -0,0 +1,43 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CIRCUITS_BLAKE2S_NATIVE_HPP__
+#define __ZETH_CIRCUITS_BLAKE2S_NATIVE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace libzeth
+{
+
+/// Byte-length of a BLAKE2s input block
+const size_t BLAKE2s_block_bytes = 64;
+/// Byte-length of a BLAKE2s-256 digest
+const size_t BLAKE2s_digest_bytes = 32;
+
+/// Native (out-of-circuit) implementation of the single block BLAKE2s-256
+/// compression computed by BLAKE2s_256_comp. The block is hashed as the first
+/// and last block of the message (f0 = 0xFFFFFFFF), with the offset counter
+/// set to `byte_len`. `block` must hold BLAKE2s_block_bytes bytes, zero-padded
+/// after the message, and `digest` receives BLAKE2s_digest_bytes bytes.
+void blake2s_256_compress_native(
+    const uint8_t *block, uint64_t byte_len, uint8_t *digest);
+
+/// Hash `num_blocks` independent blocks, laid out contiguously in `blocks`
+/// (BLAKE2s_block_bytes each), with offset counters `byte_lens`. Digests are
+/// written contiguously to `digests`. When compiled with SSE2 or AVX2
+/// support, blake2s_native_lanes() blocks are compressed at once.
+void blake2s_256_compress_native_many(
+    const uint8_t *blocks,
+    const uint64_t *byte_lens,
+    size_t num_blocks,
+    uint8_t *digests);
+
+/// Number of blocks processed in parallel by blake2s_256_compress_native_many
+/// (8 with AVX2, 4 with SSE2, 1 otherwise)
+size_t blake2s_native_lanes();
+
+} // namespace libzeth
+
+#endif // __ZETH_CIRCUITS_BLAKE2S_NATIVE_HPP__
@@ -4,19 +4,19 @@
 
 #include "circuits-utils.hpp"
 
+#include <exception>
+
 namespace libzeth
 {
 
-void insert_bits256(std::vector<bool> &into, bits256 from)
+void insert_bits256(std::vector<bool> &into, const bits256 &from)
 {
-    std::vector<bool> blob = get_vector_from_bits256(from);
-    into.insert(into.end(), blob.begin(), blob.end());
+    from.append_to_vector(into);
 };
 
-void insert_bits64(std::vector<bool> &into, bits64 from)
+void insert_bits64(std::vector<bool> &into, const bits64 &from)
 {
-    std::vector<bool> num = get_vector_from_bits64(from);
-    into.insert(into.end(), num.begin(), num.end());
+    from.append_to_vector(into);
 };
 
 std::vector<unsigned long> bit_list_to_ints(
@@ -37,4 +37,30 @@ std::vector<unsigned long> bit_list_to_ints(
     return res;
 }
 
+void generate_witnesses_concurrently(
+    const std::vector<std::function<void()>> &tasks)
+{
+    // Exceptions must not leave the parallel region
+    std::vector<std::exception_ptr> errors(tasks.size());
+
+    // The tasks may have very different costs, hence are handed out one at a
+    // time
+#ifdef MULTICORE
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        try {
+            tasks[i]();
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    }
+
+    for (const std::exception_ptr &error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
 } // namespace libzeth
@@ -7,7 +7,9 @@
 
 #include "types/bits.hpp"
 
+#include <functional>
 #include <libsnark/gadgetlib1/pb_variable.hpp>
+#include <vector>
 
 namespace libzeth
 {
@@ -27,11 +29,18 @@ template<typename FieldT, size_t BitLen>
 std::array<FieldT, BitLen> binary_field_xor(
     std::array<FieldT, BitLen> A, std::array<FieldT, BitLen> B);
 template<typename FieldT> std::vector<FieldT> convert_to_binary(size_t n);
-void insert_bits256(std::vector<bool> &into, bits256 from);
-void insert_bits64(std::vector<bool> &into, bits64 from);
+void insert_bits256(std::vector<bool> &into, const bits256 &from);
+void insert_bits64(std::vector<bool> &into, const bits64 &from);
 std::vector<unsigned long> bit_list_to_ints(
     std::vector<bool> bit_list, const size_t wordsize);
 
+/// Run the witness generation `tasks`, concurrently if built with MULTICORE.
+/// The tasks must write to disjoint sets of protoboard variables, and only
+/// read variables assigned before the call. If tasks throw, the exception of
+/// the first one (in the order of `tasks`) is rethrown once all have run.
+void generate_witnesses_concurrently(
+    const std::vector<std::function<void()>> &tasks);
+
 } // namespace libzeth
 #include "circuits/circuits-utils.tcc"
 
@@ -12,6 +12,7 @@
 #include "zeth.h"
 
 #include <boost/static_assert.hpp>
+#include <functional>
 #include <src/types/merkle_tree_field.hpp>
 
 using namespace libzeth;
@@ -525,22 +526,36 @@ public:
                 this->pb, get_vector_from_bits64(left_side_acc));
         }
 
-        // Witness the JoinSplit inputs and the h_is
+        // Witness the JoinSplit inputs, the h_is and the JoinSplit outputs.
+        //
+        // Each of these gadgets writes to its own variables, and only reads
+        // the variables assigned above (the merkle root, a_sks, h_sig and
+        // phi), so they are run concurrently. The only dependency among them
+        // is that the output note i commits to the rho_i computed by
+        // rho_i_gadgets[i]. The input notes (each with a Merkle path and
+        // several BLAKE2s compressions) are the most expensive tasks, hence
+        // come first.
+        std::vector<std::function<void()>> tasks;
+        tasks.reserve(NumInputs + NumOutputs + NumInputs);
         for (size_t i = 0; i < NumInputs; i++) {
-            std::vector<FieldT> merkle_path = inputs[i].witness_merkle_path;
-            libff::bit_vector address_bits =
-                get_vector_from_bits_addr(inputs[i].address_bits);
-            input_notes[i]->generate_r1cs_witness(
-                merkle_path, address_bits, inputs[i].note);
-
-            h_i_gadgets[i]->generate_r1cs_witness();
+            tasks.emplace_back([this, &inputs, i]() {
+                input_notes[i]->generate_r1cs_witness(
+                    inputs[i].witness_merkle_path,
+                    get_vector_from_bits_addr(inputs[i].address_bits),
+                    inputs[i].note);
+            });
         }
-
-        // Witness the JoinSplit outputs
         for (size_t i = 0; i < NumOutputs; i++) {
-            rho_i_gadgets[i]->generate_r1cs_witness();
-            output_notes[i]->generate_r1cs_witness(outputs[i]);
+            tasks.emplace_back([this, &outputs, i]() {
+                rho_i_gadgets[i]->generate_r1cs_witness();
+                output_notes[i]->generate_r1cs_witness(outputs[i]);
+            });
+        }
+        for (size_t i = 0; i < NumInputs; i++) {
+            tasks.emplace_back(
+                [this, i]() { h_i_gadgets[i]->generate_r1cs_witness(); });
         }
+        generate_witnesses_concurrently(tasks);
 
         // This happens last, because only by now are all the
         // verifier inputs resolved.
@@ -20,8 +20,8 @@ class MiMCe7_permutation_gadget : public libsnark::gadget<FieldT>
 private:
     // Vector of MiMC round_gadgets
     std::vector<MiMCe7_round_gadget<FieldT>> round_gadgets;
-    // Vector of round constants
-    std::vector<FieldT> round_constants;
+    // Vector of round constants (shared by all instances)
+    const std::vector<FieldT> &round_constants;
     // Permutation key
     const libsnark::pb_variable<FieldT> k;
 
@@ -42,6 +42,10 @@ public:
 
     const libsnark::pb_variable<FieldT> &result() const;
 
+    // Native (out-of-circuit) computation of the permutation of `x` with key
+    // `k`. Returns the value of `result()` after witness generation.
+    static FieldT permute(const FieldT &x, const FieldT &k);
+
     // Utils functions
     //
     // MiMC round gadgets initialization
@@ -49,7 +53,9 @@ public:
         const libsnark::pb_variable<FieldT> x,
         const libsnark::pb_variable<FieldT> k);
     // Constants vector initialization
-    void setup_sha3_constants();
+    static void setup_sha3_constants(std::vector<FieldT> &round_constants);
+    // Round constants, computed once on first use
+    static const std::vector<FieldT> &get_round_constants();
 };
 
 } // namespace libzeth
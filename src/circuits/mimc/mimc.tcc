@@ -14,12 +14,11 @@ MiMCe7_permutation_gadget<FieldT>::MiMCe7_permutation_gadget(
     const libsnark::pb_variable<FieldT> x,
     const libsnark::pb_variable<FieldT> k,
     const std::string &annotation_prefix)
-    : libsnark::gadget<FieldT>(pb, annotation_prefix), k(k)
+    : libsnark::gadget<FieldT>(pb, annotation_prefix)
+    , round_constants(get_round_constants())
+    , k(k)
 {
-    // First we initialize the round constants
-    setup_sha3_constants();
-
-    // Then we initialize the round gadgets
+    // Initialize the round gadgets
     setup_gadgets(x, k);
 };
 
@@ -50,6 +49,39 @@ const libsnark::pb_variable<FieldT> &MiMCe7_permutation_gadget<FieldT>::result()
     return round_gadgets.back().result();
 };
 
+template<typename FieldT>
+FieldT MiMCe7_permutation_gadget<FieldT>::permute(
+    const FieldT &x, const FieldT &k)
+{
+    const std::vector<FieldT> &constants = get_round_constants();
+
+    // Same computation as the witness generation of the round gadgets, where
+    // the output of each round is the message of the next one
+    FieldT result = x;
+    for (size_t i = 0; i < ROUNDS; i++) {
+        const FieldT t = result + k + constants[i];
+        const FieldT t2 = t * t;
+        const FieldT t4 = t2 * t2;
+        result = t4 * t2 * t;
+    }
+
+    // The key is added to the result of the last round
+    return result + k;
+}
+
+template<typename FieldT>
+const std::vector<FieldT> &MiMCe7_permutation_gadget<
+    FieldT>::get_round_constants()
+{
+    // Initialized on first use, so that the field parameters have been set
+    static const std::vector<FieldT> constants = []() {
+        std::vector<FieldT> round_constants;
+        setup_sha3_constants(round_constants);
+        return round_constants;
+    }();
+    return constants;
+}
+
 template<typename FieldT>
 void MiMCe7_permutation_gadget<FieldT>::setup_gadgets(
     const libsnark::pb_variable<FieldT> x,
@@ -77,7 +109,8 @@ void MiMCe7_permutation_gadget<FieldT>::setup_gadgets(
 // hash function over the initial seed "clearmatics_mt_seed". See:
 // pyClient/zethCodeConstantsGeneration.py for more details
 template<typename FieldT>
-void MiMCe7_permutation_gadget<FieldT>::setup_sha3_constants()
+void MiMCe7_permutation_gadget<FieldT>::setup_sha3_constants(
+    std::vector<FieldT> &round_constants)
 {
     round_constants.reserve(ROUNDS);
 
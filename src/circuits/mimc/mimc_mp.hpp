@@ -43,6 +43,9 @@ public:
 
     // Returns the hash (field element)
     static FieldT get_hash(const FieldT x, FieldT y);
+
+    // Returns the number of constraints added by generate_r1cs_constraints
+    static size_t expected_constraints();
 };
 
 } // namespace libzeth
@@ -59,30 +59,20 @@ const libsnark::pb_variable<FieldT> &MiMC_mp_gadget<FieldT>::result() const
     return output;
 }
 
-// Returns the hash of two elements
+// Returns the hash of two elements. The hash is computed natively (without
+// instantiating the gadget on a protoboard), following the Miyaguchi-Preneel
+// equation enforced by the gadget: out = k + E_k(m) + m, where m = x, k = y.
 template<typename FieldT>
 FieldT MiMC_mp_gadget<FieldT>::get_hash(const FieldT x, FieldT y)
 {
-    libsnark::protoboard<FieldT> pb;
-
-    libsnark::pb_variable<FieldT> pb_x;
-    libsnark::pb_variable<FieldT> pb_y;
-
-    // Allocates and fill with the x and y
-    pb_x.allocate(pb, " x");
-    pb.val(pb_x) = x;
-
-    pb_y.allocate(pb, " y");
-    pb.val(pb_y) = y;
-
-    // Initialize the Hash
-    MiMC_mp_gadget<FieldT> mimc_hasher(pb, pb_x, pb_y, " mimc_hash");
-
-    // Computes the hash
-    mimc_hasher.generate_r1cs_witness();
+    return MiMCe7_permutation_gadget<FieldT>::permute(x, y) + x + y;
+}
 
-    // Returns the hash
-    return pb.val(mimc_hasher.result());
+// 4 constraints per round of the permutation (t^2, t^4, t^6, t^7), and 1 for
+// the Miyaguchi-Preneel equation
+template<typename FieldT> size_t MiMC_mp_gadget<FieldT>::expected_constraints()
+{
+    return 4 * MiMCe7_permutation_gadget<FieldT>::ROUNDS + 1;
 }
 
 } // namespace libzeth
@@ -0,0 +1,116 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_CIRCUITS_POSEIDON_HPP__
+#define __ZETH_CIRCUITS_POSEIDON_HPP__
+
+#include "circuits/circuits-utils.hpp"
+
+#include <array>
+#include <libsnark/gadgetlib1/gadget.hpp>
+#include <libsnark/gadgetlib1/pb_variable.hpp>
+#include <vector>
+
+// This gadget implements the interface of the HashTreeT template
+//
+// Poseidon_gadget enforces correct computation of the Poseidon hash (see:
+// https://eprint.iacr.org/2019/458.pdf) of two field elements. The permutation
+// has width 3 (the two inputs, and a capacity element set to 0), S-box x^5, 8
+// full rounds and 57 partial rounds, for 128 bits of security on the scalar
+// field of alt_bn128. The hash is the first element of the permuted state.
+// These are the parameters (and the hash) of the Poseidon hash of 2 inputs of
+// circomlib.
+//
+// Each S-box costs 3 constraints (x^2, x^4, x^5), and partial rounds only
+// apply one S-box, so that the gadget adds 3 * (8 * 3 + 57) + 1 = 244
+// constraints (against 365 for MiMC_mp_gadget). The rest of the state is kept
+// as linear combinations, and does not use any variable.
+//
+// The round constants and the MDS matrix are those of the reference
+// implementation of the paper (drawn from a Grain LFSR seeded with the
+// parameters of the instance, the matrix being checked against invariant
+// subspaces), for the scalar field of alt_bn128 only. They are generated by
+// poseidonConstantsGeneration.py.
+
+namespace libzeth
+{
+
+template<typename FieldT>
+class Poseidon_gadget : public libsnark::gadget<FieldT>
+{
+public:
+    // Number of field elements in the state
+    static const size_t WIDTH = 3;
+    // Number of rounds applying the S-box to the whole state (half of them
+    // before the partial rounds, half after)
+    static const size_t FULL_ROUNDS = 8;
+    // Number of rounds applying the S-box to the first element of the state
+    static const size_t PARTIAL_ROUNDS = 57;
+
+    using state = std::array<FieldT, WIDTH>;
+    using matrix = std::array<state, WIDTH>;
+
+private:
+    // First input
+    libsnark::pb_variable<FieldT> x;
+    // Second input
+    libsnark::pb_variable<FieldT> y;
+    // Intermediary variables of the S-boxes (x^2, x^4, x^5), in the order in
+    // which the S-boxes are applied
+    libsnark::pb_variable_array<FieldT> sbox_x2;
+    libsnark::pb_variable_array<FieldT> sbox_x4;
+    libsnark::pb_variable_array<FieldT> sbox_x5;
+    // Output variable
+    libsnark::pb_variable<FieldT> output;
+
+public:
+    Poseidon_gadget(
+        libsnark::protoboard<FieldT> &pb,
+        const libsnark::pb_variable<FieldT> x,
+        const libsnark::pb_variable<FieldT> y,
+        const std::string &annotation_prefix = "Poseidon_gadget");
+
+    void generate_r1cs_constraints();
+    void generate_r1cs_witness() const;
+
+    // Returns the hash computed
+    const libsnark::pb_variable<FieldT> &result() const;
+
+    // Returns the hash (field element)
+    static FieldT get_hash(const FieldT x, FieldT y);
+
+    // Native (out-of-circuit) computation of the permutation
+    static state permute(const state &s);
+
+    // Returns the number of constraints added by generate_r1cs_constraints
+    static size_t expected_constraints();
+
+    // Utils functions
+    //
+    // Constants initialization
+    static void setup_round_constants(std::vector<FieldT> &round_constants);
+    static void setup_mds_matrix(matrix &mds);
+    // Round constants (WIDTH per round), computed once on first use
+    static const std::vector<FieldT> &get_round_constants();
+    // MDS matrix of the linear layer, computed once on first use
+    static const matrix &get_mds_matrix();
+
+private:
+    static bool is_full_round(size_t round);
+    // Number of S-boxes applied by the permutation
+    static size_t num_sboxes();
+
+    // Add the round constants of round `round` to `s`, which holds field
+    // elements or linear combinations
+    template<typename T>
+    static void add_round_constants(std::array<T, WIDTH> &s, size_t round);
+    // Apply the linear layer to `s`
+    template<typename T>
+    static std::array<T, WIDTH> mix(const std::array<T, WIDTH> &s);
+};
+
+} // namespace libzeth
+#include "circuits/poseidon/poseidon.tcc"
+
+#endif // __ZETH_CIRCUITS_POSEIDON_HPP__
@@ -0,0 +1,206 @@
+# Generation of the Poseidon parameters (round constants and MDS matrix) for
+# Poseidon_gadget (see src/circuits/poseidon/poseidon.hpp), following the
+# reference implementation of the Poseidon paper:
+#   https://extgit.iaik.tugraz.at/krypto/hadeshash
+#   (code/generate_parameters_grain.sage)
+# with the parameters of the scalar field of alt_bn128 (BN254), t = 3, x^5,
+# 8 full rounds and 57 partial rounds. These are the parameters of the
+# Poseidon hash of 2 inputs of circomlib.
+#
+# With `--test-vectors`, prints the hash of the values used in
+# src/test/poseidon_test.cpp instead of the C++ code of the constants.
+
+import sys
+
+# Scalar field of alt_bn128
+FIELD_ORDER = 21888242871839275222246405745257275088548364400416034343698204186575808495617
+
+FIELD = 1  # Prime field
+SBOX = 0  # x^alpha
+FIELD_SIZE = FIELD_ORDER.bit_length()
+WIDTH = 3
+FULL_ROUNDS = 8
+PARTIAL_ROUNDS = 57
+EXPONENT = 5
+
+
+class grain_lfsr:
+    """
+    80-bit Grain LFSR, in self-shrinking mode, initialized with the parameters
+    of the instance
+    """
+
+    def __init__(self):
+        def bits(value, size):
+            return [int(b) for b in bin(value)[2:].zfill(size)]
+
+        self.state = bits(FIELD, 2) + bits(SBOX, 4) + bits(FIELD_SIZE, 12) + \
+            bits(WIDTH, 12) + bits(FULL_ROUNDS, 10) + \
+            bits(PARTIAL_ROUNDS, 10) + [1] * 30
+        assert len(self.state) == 80
+        for _ in range(160):
+            self._next_bit()
+
+    def _next_bit(self):
+        s = self.state
+        new_bit = s[62] ^ s[51] ^ s[38] ^ s[23] ^ s[13] ^ s[0]
+        s.pop(0)
+        s.append(new_bit)
+        return new_bit
+
+    def bit(self):
+        # Bits are taken in pairs: the second bit is output if the first one
+        # is 1, and the pair is discarded otherwise
+        while self._next_bit() == 0:
+            self._next_bit()
+        return self._next_bit()
+
+    def integer(self, num_bits):
+        value = 0
+        for _ in range(num_bits):
+            value = (value << 1) | self.bit()
+        return value
+
+
+def inverse(x):
+    return pow(x, FIELD_ORDER - 2, FIELD_ORDER)
+
+
+def mat_mul(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(WIDTH)) % FIELD_ORDER
+             for j in range(WIDTH)] for i in range(WIDTH)]
+
+
+def poly_mulmod(a, b, f):
+    # Product of polynomials a and b (lists of coefficients, lowest degree
+    # first) modulo the monic polynomial f
+    prod = [0] * (len(a) + len(b) - 1)
+    for i, x in enumerate(a):
+        for j, y in enumerate(b):
+            prod[i + j] = (prod[i + j] + x * y) % FIELD_ORDER
+    d = len(f) - 1
+    for k in range(len(prod) - 1, d - 1, -1):
+        c = prod[k]
+        if c:
+            for i in range(d + 1):
+                prod[k - d + i] = (prod[k - d + i] - c * f[i]) % FIELD_ORDER
+    return (prod[:d] + [0] * d)[:d]
+
+
+def poly_gcd_is_one(a, b):
+    def trim(p):
+        while p and p[-1] == 0:
+            p = p[:-1]
+        return p
+    a, b = trim(a), trim(b)
+    while b:
+        inv = inverse(b[-1])
+        while len(a) >= len(b) and a:
+            c = a[-1] * inv % FIELD_ORDER
+            shift = len(a) - len(b)
+            for i in range(len(b)):
+                a[shift + i] = (a[shift + i] - c * b[i]) % FIELD_ORDER
+            a = trim(a)
+        a, b = b, a
+    return len(a) == 1
+
+
+def charpoly_is_irreducible(m):
+    # Characteristic polynomial x^3 - tr x^2 + c1 x - det (monic, lowest
+    # degree first). A cubic is irreducible iff it has no root, i.e. iff it is
+    # coprime with x^p - x.
+    assert WIDTH == 3
+    tr = (m[0][0] + m[1][1] + m[2][2]) % FIELD_ORDER
+    c1 = (m[0][0] * m[1][1] - m[0][1] * m[1][0] +
+          m[0][0] * m[2][2] - m[0][2] * m[2][0] +
+          m[1][1] * m[2][2] - m[1][2] * m[2][1]) % FIELD_ORDER
+    det = (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+           m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+           m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) % FIELD_ORDER
+    f = [(-det) % FIELD_ORDER, c1, (-tr) % FIELD_ORDER, 1]
+
+    # x^p mod f
+    result, base, e = [1, 0, 0], [0, 1, 0], FIELD_ORDER
+    while e:
+        if e & 1:
+            result = poly_mulmod(result, base, f)
+        base = poly_mulmod(base, base, f)
+        e >>= 1
+    result[1] = (result[1] - 1) % FIELD_ORDER
+    return poly_gcd_is_one(f, result)
+
+
+def mds_is_secure(m):
+    # Algorithm 1 of the reference implementation: the minimal polynomials of
+    # the powers of M are irreducible (and of maximal degree), so that M (and
+    # its powers) has no invariant subspace. Algorithms 2 and 3 of the
+    # reference only need to be run when this check fails.
+    power = m
+    for _ in range(2 * WIDTH):
+        if not charpoly_is_irreducible(power):
+            return False
+        power = mat_mul(power, m)
+    return True
+
+
+def generate_parameters():
+    lfsr = grain_lfsr()
+
+    round_constants = []
+    for _ in range((FULL_ROUNDS + PARTIAL_ROUNDS) * WIDTH):
+        c = lfsr.integer(FIELD_SIZE)
+        while c >= FIELD_ORDER:
+            c = lfsr.integer(FIELD_SIZE)
+        round_constants.append(c)
+
+    # Cauchy matrix 1 / (x_i + y_j), with distinct x_i, y_j drawn from the
+    # LFSR, drawn again until it passes the security checks
+    while True:
+        values = [lfsr.integer(FIELD_SIZE) % FIELD_ORDER
+                  for _ in range(2 * WIDTH)]
+        while len(set(values)) != len(values):
+            values = [lfsr.integer(FIELD_SIZE) % FIELD_ORDER
+                      for _ in range(2 * WIDTH)]
+        xs, ys = values[:WIDTH], values[WIDTH:]
+        if any((x + y) % FIELD_ORDER == 0 for x in xs for y in ys):
+            continue
+        mds = [[inverse((x + y) % FIELD_ORDER) for y in ys] for x in xs]
+        if mds_is_secure(mds):
+            return round_constants, mds
+
+
+def permute(state, round_constants, mds):
+    state = list(state)
+    for r in range(FULL_ROUNDS + PARTIAL_ROUNDS):
+        state = [(s + round_constants[r * WIDTH + i]) % FIELD_ORDER
+                 for i, s in enumerate(state)]
+        full = r < FULL_ROUNDS // 2 or r >= FULL_ROUNDS // 2 + PARTIAL_ROUNDS
+        for i in range(WIDTH if full else 1):
+            state[i] = pow(state[i], EXPONENT, FIELD_ORDER)
+        state = [sum(m * s for m, s in zip(row, state)) % FIELD_ORDER
+                 for row in mds]
+    return state
+
+
+def main():
+    assert (FIELD_ORDER - 1) % EXPONENT != 0
+    round_constants, mds = generate_parameters()
+
+    if len(sys.argv) > 1 and sys.argv[1] == "--test-vectors":
+        print(permute([0, 1, 2], round_constants, mds))
+        print(permute([0, 0, 0], round_constants, mds)[0])
+        return 0
+
+    # Bodies of setup_round_constants and setup_mds_matrix
+    for c in round_constants:
+        print("    round_constants.push_back(FieldT(\n        \"" + str(c) +
+              "\"));")
+    print()
+    for i, row in enumerate(mds):
+        for j, m in enumerate(row):
+            print("    mds[%d][%d] = FieldT(\n        \"%d\");" % (i, j, m))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
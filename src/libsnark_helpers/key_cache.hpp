@@ -0,0 +1,86 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_KEY_CACHE_HPP__
+#define __ZETH_KEY_CACHE_HPP__
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace libzeth
+{
+
+/// Keys (typically proving keys, of several circuits) identified by name, and
+/// held in memory up to a size limit. Missing keys are loaded on first use,
+/// and the least recently used keys are evicted to make room for new ones.
+///
+/// Keys are handed out as shared pointers, so that a key evicted while in use
+/// remains valid for its current users (the limit is then exceeded until they
+/// release it). A single key larger than the limit is kept until another key
+/// is needed. All methods are thread-safe.
+template<typename keyT> class key_cache
+{
+public:
+    using key_loader = std::function<keyT()>;
+    using key_sizer = std::function<size_t(const keyT &)>;
+
+    /// Hold at most `max_bytes` of keys (0 for no limit), the size of each key
+    /// being given by `key_size`.
+    key_cache(size_t max_bytes, key_sizer key_size);
+
+    /// Return the key `name`, calling `load` if it is not in the cache.
+    /// Concurrent calls for the same missing key load it once. If `load`
+    /// throws, the exception is propagated and nothing is cached.
+    std::shared_ptr<const keyT> get(
+        const std::string &name, const key_loader &load);
+
+    /// Add (or replace) the key `name`, evicting other keys if needed.
+    std::shared_ptr<const keyT> insert(const std::string &name, keyT &&key);
+
+    bool contains(const std::string &name) const;
+
+    /// Total size of the cached keys
+    size_t size_in_bytes() const;
+
+    size_t num_keys() const;
+
+private:
+    class entry
+    {
+    public:
+        std::shared_ptr<const keyT> key;
+        size_t size;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    const size_t max_bytes;
+    const key_sizer key_size;
+
+    mutable std::mutex mutex;
+    std::map<std::string, entry> entries;
+    // Names of the cached keys, most recently used first
+    std::list<std::string> lru;
+    size_t total_bytes;
+
+    // Held while the key of the same name is loaded. Entries are never
+    // removed, so that the mutexes outlive the loads.
+    std::map<std::string, std::unique_ptr<std::mutex>> load_mutexes;
+
+    // Return the cached key `name` (marked as most recently used), or null.
+    // The caller must hold `mutex`.
+    std::shared_ptr<const keyT> find_locked(const std::string &name);
+
+    // The caller must hold `mutex`
+    std::shared_ptr<const keyT> insert_locked(
+        const std::string &name, std::shared_ptr<const keyT> key);
+};
+
+} // namespace libzeth
+#include "libsnark_helpers/key_cache.tcc"
+
+#endif // __ZETH_KEY_CACHE_HPP__
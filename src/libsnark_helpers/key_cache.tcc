@@ -0,0 +1,136 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_KEY_CACHE_TCC__
+#define __ZETH_KEY_CACHE_TCC__
+
+#include "metrics.hpp"
+
+#include <iostream>
+
+namespace libzeth
+{
+
+template<typename keyT>
+key_cache<keyT>::key_cache(size_t max_bytes, key_sizer key_size)
+    : max_bytes(max_bytes), key_size(key_size), total_bytes(0)
+{
+}
+
+template<typename keyT>
+std::shared_ptr<const keyT> key_cache<keyT>::get(
+    const std::string &name, const key_loader &load)
+{
+    std::mutex *load_mutex;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<const keyT> key = find_locked(name);
+        if (key) {
+            metrics::global().increment("key_cache_hits");
+            return key;
+        }
+
+        std::unique_ptr<std::mutex> &m = load_mutexes[name];
+        if (!m) {
+            m.reset(new std::mutex());
+        }
+        load_mutex = m.get();
+    }
+
+    // The key may have been loaded by another thread while waiting
+    std::lock_guard<std::mutex> load_lock(*load_mutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::shared_ptr<const keyT> key = find_locked(name);
+        if (key) {
+            metrics::global().increment("key_cache_hits");
+            return key;
+        }
+    }
+
+    // Other keys remain available while this one is loaded
+    metrics::global().increment("key_cache_misses");
+    std::shared_ptr<const keyT> key = std::make_shared<const keyT>(load());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return insert_locked(name, key);
+}
+
+template<typename keyT>
+std::shared_ptr<const keyT> key_cache<keyT>::insert(
+    const std::string &name, keyT &&key)
+{
+    std::shared_ptr<const keyT> shared_key =
+        std::make_shared<const keyT>(std::move(key));
+    std::lock_guard<std::mutex> lock(mutex);
+    return insert_locked(name, shared_key);
+}
+
+template<typename keyT>
+bool key_cache<keyT>::contains(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.count(name) != 0;
+}
+
+template<typename keyT> size_t key_cache<keyT>::size_in_bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return total_bytes;
+}
+
+template<typename keyT> size_t key_cache<keyT>::num_keys() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+template<typename keyT>
+std::shared_ptr<const keyT> key_cache<keyT>::find_locked(
+    const std::string &name)
+{
+    typename std::map<std::string, entry>::iterator it = entries.find(name);
+    if (it == entries.end()) {
+        return nullptr;
+    }
+
+    lru.splice(lru.begin(), lru, it->second.lru_position);
+    return it->second.key;
+}
+
+template<typename keyT>
+std::shared_ptr<const keyT> key_cache<keyT>::insert_locked(
+    const std::string &name, std::shared_ptr<const keyT> key)
+{
+    typename std::map<std::string, entry>::iterator it = entries.find(name);
+    if (it != entries.end()) {
+        total_bytes -= it->second.size;
+        lru.erase(it->second.lru_position);
+        entries.erase(it);
+    }
+
+    lru.push_front(name);
+    entry &e = entries[name];
+    e.key = key;
+    e.size = key_size(*key);
+    e.lru_position = lru.begin();
+    total_bytes += e.size;
+
+    // Evict the least recently used keys, other than the one just inserted
+    while (max_bytes != 0 && total_bytes > max_bytes && lru.size() > 1) {
+        const std::string &evicted = lru.back();
+        std::cout << "[INFO] Evicting key " << evicted << " from the cache"
+                  << std::endl;
+        total_bytes -= entries[evicted].size;
+        entries.erase(evicted);
+        lru.pop_back();
+        metrics::global().increment("key_cache_evictions");
+    }
+
+    return key;
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_KEY_CACHE_TCC__
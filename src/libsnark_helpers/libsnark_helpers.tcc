@@ -34,25 +34,15 @@ void write_to_file(boost::filesystem::path path, serializableT &obj)
 template<typename serializableT>
 serializableT load_from_file(boost::filesystem::path path)
 {
-    // Convert the boost path into char*
-    const char *str_path = path.string().c_str();
-
-    std::stringstream ss;
-
-    // ifstream: Stream class to read from files (opened in binary mode)
-    std::ifstream fh(str_path, std::ios::binary);
+    // ifstream: Stream class to read from files (opened in binary mode). The
+    // object is parsed directly from the file, without first copying the
+    // whole content into memory.
+    std::ifstream fh(path.string(), std::ios::binary);
     assert(fh.is_open());
 
-    // Get a stream buffer from the ifstream and "dump" its content to the
-    // stringstream
-    ss << fh.rdbuf();
-    fh.close();
-
-    // Set internal position pointer to absolute position 0
-    ss.rdbuf()->pubseekpos(0, std::ios_base::in);
-
     serializableT obj;
-    ss >> obj;
+    fh >> obj;
+    fh.close();
 
     return obj;
 };
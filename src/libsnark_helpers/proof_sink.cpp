@@ -0,0 +1,26 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libsnark_helpers/proof_sink.hpp"
+
+#include <ctime>
+#include <unistd.h>
+
+namespace libzeth
+{
+
+std::string proof_sink_run_id()
+{
+    // Computed on first use (when the first sink is created)
+    static const std::string run_id = []() -> std::string {
+        const std::time_t now = std::time(nullptr);
+        char timestamp[32];
+        std::strftime(
+            timestamp, sizeof(timestamp), "%Y%m%dT%H%M%S", std::gmtime(&now));
+        return std::string(timestamp) + "_" + std::to_string(getpid());
+    }();
+    return run_id;
+}
+
+} // namespace libzeth
@@ -0,0 +1,120 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_PROOF_SINK_HPP__
+#define __ZETH_PROOF_SINK_HPP__
+
+#include "libsnark_helpers/extended_proof.hpp"
+
+#include <boost/filesystem.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace libzeth
+{
+
+/// Identifier of the current run of the process (start time and pid), used
+/// in the names of the files written by the sinks, so that a restarted server
+/// does not overwrite the proofs of the previous runs.
+std::string proof_sink_run_id();
+
+/// Destination of the proofs generated by the prover, kept for debugging and
+/// inspection. `push` is called on the proving path once each proof has been
+/// generated, so implementations must return quickly and be safe to call from
+/// several threads.
+template<typename ppT> class proof_sink
+{
+public:
+    virtual ~proof_sink(){};
+    virtual void push(const extended_proof<ppT> &ext_proof) = 0;
+};
+
+/// Discards all proofs.
+template<typename ppT> class null_proof_sink : public proof_sink<ppT>
+{
+public:
+    void push(const extended_proof<ppT> &ext_proof) override;
+};
+
+/// Writes each proof (with its primary inputs) to its own json file
+/// `proof_and_inputs_<run id>_<n>.json` in a directory, from a background
+/// thread. Proofs pushed while `max_pending` proofs are waiting to be written
+/// are dropped rather than delaying the prover, and counted (also in the
+/// `dropped_proofs` metric).
+template<typename ppT> class file_proof_sink : public proof_sink<ppT>
+{
+public:
+    /// If `directory` is empty, the debug directory is used.
+    file_proof_sink(
+        const boost::filesystem::path &directory = "",
+        size_t max_pending = 64);
+
+    // Writes all pending proofs before returning
+    ~file_proof_sink();
+
+    void push(const extended_proof<ppT> &ext_proof) override;
+
+    /// Number of proofs dropped because the writer could not keep up
+    size_t num_dropped() const;
+
+private:
+    const boost::filesystem::path directory;
+    const size_t max_pending;
+    const std::string file_prefix;
+
+    std::deque<extended_proof<ppT>> pending;
+    size_t next_index;
+    size_t dropped;
+    bool stopping;
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::thread writer;
+
+    void writer_loop();
+};
+
+/// Keeps the `capacity` most recent proofs in memory, to be inspected by the
+/// owner of the sink, or written on demand to json files (the prover server
+/// does so on SIGUSR1).
+template<typename ppT> class ring_buffer_proof_sink : public proof_sink<ppT>
+{
+public:
+    /// If `directory` is empty, the debug directory is used.
+    ring_buffer_proof_sink(
+        size_t capacity, const boost::filesystem::path &directory = "");
+
+    void push(const extended_proof<ppT> &ext_proof) override;
+
+    /// Copy of the retained proofs, oldest first
+    std::vector<extended_proof<ppT>> recent_proofs() const;
+
+    /// Total number of proofs pushed to the sink
+    size_t num_pushed() const;
+
+    /// Write the retained proofs to `recent_proof_<run id>_<n>.json` in the
+    /// directory, where n is the number of proofs pushed before each one (so
+    /// that successive dumps only overwrite files with identical content).
+    /// Returns the number of proofs written.
+    size_t write_recent_proofs() const;
+
+private:
+    const size_t capacity;
+    const boost::filesystem::path directory;
+    std::vector<extended_proof<ppT>> proofs;
+    size_t total;
+    mutable std::mutex mutex;
+
+    // The caller must hold `mutex`
+    std::vector<extended_proof<ppT>> recent_proofs_locked() const;
+};
+
+} // namespace libzeth
+
+#include "libsnark_helpers/proof_sink.tcc"
+
+#endif // __ZETH_PROOF_SINK_HPP__
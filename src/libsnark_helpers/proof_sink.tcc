@@ -0,0 +1,178 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_PROOF_SINK_TCC__
+#define __ZETH_PROOF_SINK_TCC__
+
+#include "libsnark_helpers/debug_helpers.hpp"
+#include "metrics.hpp"
+
+namespace libzeth
+{
+
+template<typename ppT>
+void null_proof_sink<ppT>::push(const extended_proof<ppT> &ext_proof)
+{
+    (void)ext_proof;
+}
+
+template<typename ppT>
+file_proof_sink<ppT>::file_proof_sink(
+    const boost::filesystem::path &directory, size_t max_pending)
+    : directory(
+          directory.empty() ? get_path_to_debug_directory() : directory)
+    , max_pending(max_pending)
+    , file_prefix("proof_and_inputs_" + proof_sink_run_id() + "_")
+    , next_index(0)
+    , dropped(0)
+    , stopping(false)
+{
+    writer = std::thread(&file_proof_sink<ppT>::writer_loop, this);
+}
+
+template<typename ppT> file_proof_sink<ppT>::~file_proof_sink()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    writer.join();
+}
+
+template<typename ppT>
+void file_proof_sink<ppT>::push(const extended_proof<ppT> &ext_proof)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pending.size() >= max_pending) {
+            ++dropped;
+            metrics::global().increment("dropped_proofs");
+            return;
+        }
+        // Copying an extended_proof only copies shared pointers
+        pending.push_back(ext_proof);
+    }
+    cv.notify_one();
+}
+
+template<typename ppT> size_t file_proof_sink<ppT>::num_dropped() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropped;
+}
+
+template<typename ppT> void file_proof_sink<ppT>::writer_loop()
+{
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (pending.empty()) {
+            // Only reached when stopping, once all proofs have been written
+            return;
+        }
+
+        extended_proof<ppT> ext_proof = pending.front();
+        pending.pop_front();
+        const size_t index = next_index++;
+        lock.unlock();
+
+        // Each proof gets its own file, so that proofs generated concurrently
+        // do not overwrite each other.
+        const boost::filesystem::path path =
+            directory / (file_prefix + std::to_string(index) + ".json");
+        try {
+            ext_proof.write_extended_proof(path);
+        } catch (const std::exception &e) {
+            std::cout << "[ERROR] Failed to write " << path << ": " << e.what()
+                      << std::endl;
+        }
+    }
+}
+
+template<typename ppT>
+ring_buffer_proof_sink<ppT>::ring_buffer_proof_sink(
+    size_t capacity, const boost::filesystem::path &directory)
+    : capacity(capacity)
+    , directory(
+          directory.empty() ? get_path_to_debug_directory() : directory)
+    , total(0)
+{
+    if (capacity == 0) {
+        throw std::invalid_argument("ring buffer capacity must be non-zero");
+    }
+    proofs.reserve(capacity);
+}
+
+template<typename ppT>
+void ring_buffer_proof_sink<ppT>::push(const extended_proof<ppT> &ext_proof)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (proofs.size() < capacity) {
+        proofs.push_back(ext_proof);
+    } else {
+        proofs[total % capacity] = ext_proof;
+    }
+    ++total;
+}
+
+template<typename ppT>
+std::vector<extended_proof<ppT>> ring_buffer_proof_sink<ppT>::recent_proofs()
+    const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return recent_proofs_locked();
+}
+
+template<typename ppT>
+std::vector<extended_proof<ppT>> ring_buffer_proof_sink<
+    ppT>::recent_proofs_locked() const
+{
+    if (proofs.size() < capacity) {
+        return proofs;
+    }
+
+    // The buffer is full, and the oldest proof is the next to be replaced
+    const size_t oldest = total % capacity;
+    std::vector<extended_proof<ppT>> ordered;
+    ordered.reserve(capacity);
+    ordered.insert(ordered.end(), proofs.begin() + oldest, proofs.end());
+    ordered.insert(ordered.end(), proofs.begin(), proofs.begin() + oldest);
+    return ordered;
+}
+
+template<typename ppT> size_t ring_buffer_proof_sink<ppT>::num_pushed() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return total;
+}
+
+template<typename ppT>
+size_t ring_buffer_proof_sink<ppT>::write_recent_proofs() const
+{
+    // The proofs are copied under the lock, and written without it, so that
+    // the prover is not blocked by the writes
+    size_t first_index;
+    std::vector<extended_proof<ppT>> recent;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        first_index = total - proofs.size();
+        recent = recent_proofs_locked();
+    }
+
+    const std::string file_prefix =
+        "recent_proof_" + proof_sink_run_id() + "_";
+    for (size_t i = 0; i < recent.size(); ++i) {
+        const boost::filesystem::path path =
+            directory /
+            (file_prefix + std::to_string(first_index + i) + ".json");
+        recent[i].write_extended_proof(path);
+    }
+
+    return recent.size();
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_PROOF_SINK_TCC__
@@ -0,0 +1,37 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_PROVING_CONTEXT_HPP__
+#define __ZETH_PROVING_CONTEXT_HPP__
+
+#include <libsnark/gadgetlib1/protoboard.hpp>
+#include <vector>
+
+namespace libzeth
+{
+
+/// Witness buffers handed to the prover (see `gen_proof_batch`), reused from
+/// one request to the next so that the assignment vectors (several MB for the
+/// joinsplit circuit) are not reallocated for each proof. A context belongs
+/// to a single proving worker, and is not thread-safe.
+template<typename FieldT> class proving_context
+{
+public:
+    std::vector<libsnark::r1cs_primary_input<FieldT>> primary_inputs;
+    std::vector<libsnark::r1cs_auxiliary_input<FieldT>> auxiliary_inputs;
+
+    /// Prepare the buffers for a request of `num_witnesses` proofs. The
+    /// buffers of previous requests are kept, and their storage reused.
+    void reset(size_t num_witnesses);
+
+    /// Copy the assignment of `pb` into the buffers of witness `index`.
+    /// Once the buffers have reached the size of the circuit, this does not
+    /// allocate.
+    void load_witness(const libsnark::protoboard<FieldT> &pb, size_t index);
+};
+
+} // namespace libzeth
+#include "libsnark_helpers/proving_context.tcc"
+
+#endif // __ZETH_PROVING_CONTEXT_HPP__
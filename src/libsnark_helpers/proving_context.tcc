@@ -0,0 +1,51 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_PROVING_CONTEXT_TCC__
+#define __ZETH_PROVING_CONTEXT_TCC__
+
+#include <stdexcept>
+
+namespace libzeth
+{
+
+template<typename FieldT>
+void proving_context<FieldT>::reset(size_t num_witnesses)
+{
+    primary_inputs.resize(num_witnesses);
+    auxiliary_inputs.resize(num_witnesses);
+}
+
+template<typename FieldT>
+void proving_context<FieldT>::load_witness(
+    const libsnark::protoboard<FieldT> &pb, size_t index)
+{
+    if (index >= primary_inputs.size()) {
+        throw std::out_of_range("invalid witness index (proving_context)");
+    }
+
+    // `protoboard::primary_input` and `protoboard::auxiliary_input` return
+    // new vectors. Instead, the values are copied one by one into the
+    // existing buffers. Variable 0 is the constant 1, and is not part of the
+    // assignment.
+    const size_t num_inputs = pb.num_inputs();
+    const size_t num_variables = pb.num_variables();
+
+    libsnark::r1cs_primary_input<FieldT> &primary = primary_inputs[index];
+    primary.resize(num_inputs);
+    for (size_t i = 0; i < num_inputs; ++i) {
+        primary[i] = pb.val(libsnark::pb_variable<FieldT>(i + 1));
+    }
+
+    libsnark::r1cs_auxiliary_input<FieldT> &auxiliary = auxiliary_inputs[index];
+    auxiliary.resize(num_variables - num_inputs);
+    for (size_t i = 0; i < num_variables - num_inputs; ++i) {
+        auxiliary[i] =
+            pb.val(libsnark::pb_variable<FieldT>(num_inputs + 1 + i));
+    }
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_PROVING_CONTEXT_TCC__
@@ -0,0 +1,143 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "metrics.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace libzeth
+{
+
+const std::array<double, 15> metrics_histogram::bucket_bounds = {
+    0.001,
+    0.0025,
+    0.005,
+    0.01,
+    0.025,
+    0.05,
+    0.1,
+    0.25,
+    0.5,
+    1.0,
+    2.5,
+    5.0,
+    10.0,
+    25.0,
+    60.0};
+
+metrics_histogram::metrics_histogram() : num_observations(0), sum_seconds(0)
+{
+    counts.fill(0);
+}
+
+void metrics_histogram::observe(double seconds)
+{
+    size_t bucket = 0;
+    while (bucket < bucket_bounds.size() && seconds > bucket_bounds[bucket]) {
+        ++bucket;
+    }
+
+    ++counts[bucket];
+    ++num_observations;
+    sum_seconds += seconds;
+}
+
+std::array<uint64_t, 16> metrics_histogram::cumulative_counts() const
+{
+    std::array<uint64_t, 16> cumulative;
+    uint64_t total = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        total += counts[i];
+        cumulative[i] = total;
+    }
+
+    return cumulative;
+}
+
+metrics &metrics::global()
+{
+    static metrics registry;
+    return registry;
+}
+
+void metrics::observe(const std::string &stage, double seconds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    stages[stage].observe(seconds);
+}
+
+void metrics::increment(const std::string &name, uint64_t value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    counters[name] += value;
+}
+
+void metrics::write(std::ostream &out) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    out << "# HELP zeth_stage_seconds Time spent in each proving stage.\n";
+    out << "# TYPE zeth_stage_seconds histogram\n";
+    for (const auto &entry : stages) {
+        const std::string &stage = entry.first;
+        const metrics_histogram &histogram = entry.second;
+        const std::array<uint64_t, 16> cumulative =
+            histogram.cumulative_counts();
+        for (size_t i = 0; i < metrics_histogram::bucket_bounds.size(); ++i) {
+            out << "zeth_stage_seconds_bucket{stage=\"" << stage << "\",le=\""
+                << metrics_histogram::bucket_bounds[i]
+                << "\"} " << cumulative[i] << "\n";
+        }
+        out << "zeth_stage_seconds_bucket{stage=\"" << stage
+            << "\",le=\"+Inf\"} " << histogram.count() << "\n";
+        out << "zeth_stage_seconds_sum{stage=\"" << stage << "\"} "
+            << histogram.sum() << "\n";
+        out << "zeth_stage_seconds_count{stage=\"" << stage << "\"} "
+            << histogram.count() << "\n";
+    }
+
+    for (const auto &entry : counters) {
+        out << "# TYPE zeth_" << entry.first << "_total counter\n";
+        out << "zeth_" << entry.first << "_total " << entry.second << "\n";
+    }
+}
+
+void metrics::write_file(const std::string &filename) const
+{
+    const std::string tmp_filename = filename + ".tmp";
+    {
+        std::ofstream out(tmp_filename, std::ios_base::out);
+        if (!out) {
+            throw std::runtime_error("cannot write metrics to " + filename);
+        }
+        write(out);
+    }
+
+    if (0 != std::rename(tmp_filename.c_str(), filename.c_str())) {
+        throw std::runtime_error("cannot write metrics to " + filename);
+    }
+}
+
+metrics_timer::metrics_timer(const char *stage)
+    : stage(stage), start(std::chrono::steady_clock::now()), stopped(false)
+{
+}
+
+metrics_timer::~metrics_timer() { stop(); }
+
+void metrics_timer::stop()
+{
+    if (stopped) {
+        return;
+    }
+
+    stopped = true;
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    metrics::global().observe(stage, elapsed.count());
+}
+
+} // namespace libzeth
@@ -0,0 +1,95 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_METRICS_HPP__
+#define __ZETH_METRICS_HPP__
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Timings of the proving stages and event counters.
+//
+// Metrics are recorded in a process-wide registry, and exported in the
+// Prometheus text format (for instance to a file read by the textfile
+// collector of the node exporter). Recording an observation takes a lock, and
+// is only meant for coarse-grained stages (parsing a request, generating a
+// witness, computing a multi-exponentiation), not for inner loops.
+namespace libzeth
+{
+
+/// Distribution of durations (in seconds), over fixed buckets.
+class metrics_histogram
+{
+public:
+    /// Upper bounds of the buckets (the last bucket, +Inf, is implicit)
+    static const std::array<double, 15> bucket_bounds;
+
+    metrics_histogram();
+    void observe(double seconds);
+
+    // Number of observations less than or equal to each bound (the last
+    // entry is the total count).
+    std::array<uint64_t, 16> cumulative_counts() const;
+    uint64_t count() const { return num_observations; }
+    double sum() const { return sum_seconds; }
+
+private:
+    std::array<uint64_t, 16> counts;
+    uint64_t num_observations;
+    double sum_seconds;
+};
+
+class metrics
+{
+public:
+    /// The registry shared by the whole process
+    static metrics &global();
+
+    /// Record a duration for `stage`
+    void observe(const std::string &stage, double seconds);
+
+    /// Add `value` to the counter `name`
+    void increment(const std::string &name, uint64_t value = 1);
+
+    /// Write all metrics in the Prometheus text format
+    void write(std::ostream &out) const;
+
+    /// Write all metrics to `filename`. The file is replaced atomically, so
+    /// that a reader never sees a partial write.
+    void write_file(const std::string &filename) const;
+
+private:
+    mutable std::mutex mutex;
+    std::map<std::string, metrics_histogram> stages;
+    std::map<std::string, uint64_t> counters;
+};
+
+/// Records the time spent in a scope as a stage of the global registry. The
+/// time is recorded when the timer is destroyed, or by an explicit call to
+/// `stop`.
+class metrics_timer
+{
+public:
+    explicit metrics_timer(const char *stage);
+    ~metrics_timer();
+
+    void stop();
+
+    metrics_timer(const metrics_timer &) = delete;
+    metrics_timer &operator=(const metrics_timer &) = delete;
+
+private:
+    const char *stage;
+    const std::chrono::steady_clock::time_point start;
+    bool stopped;
+};
+
+} // namespace libzeth
+
+#endif // __ZETH_METRICS_HPP__
@@ -6,6 +6,7 @@
 // This comment preserves include order under clang-format.
 #include "circuits/blake2s/blake2s_comp.hpp"
 #include "mpc_common.hpp"
+#include "snarks/groth16/mpc/mapped_keypair.hpp"
 #include "snarks/groth16/mpc/mpc_utils.hpp"
 #include "snarks/groth16/mpc/powersoftau_utils.hpp"
 #include "util.hpp"
@@ -28,6 +29,7 @@ namespace
 // Options:
 //  -h,--help           This message
 //  --pot-degree        powersoftau degree (assumed to match linear comb)
+//  --mapped            write the keypair in the mapped (binary) format
 class mpc_create_keypair : public subcommand
 {
 private:
@@ -36,6 +38,7 @@ private:
     std::string phase2_challenge_file;
     std::string keypair_out_file;
     size_t powersoftau_degree;
+    bool mapped;
 
 public:
     mpc_create_keypair()
@@ -45,6 +48,7 @@ public:
         , phase2_challenge_file()
         , keypair_out_file()
         , powersoftau_degree(0)
+        , mapped(false)
     {
     }
 
@@ -58,6 +62,8 @@ private:
             "pot-degree",
             po::value<size_t>(),
             "powersoftau degree (assumed to match linear comb)");
+        options.add_options()(
+            "mapped", "write the keypair in the mapped (binary) format");
         all_options.add(options).add_options()(
             "powersoftau_file", po::value<std::string>(), "powersoftau file")(
             "linear_combination_file",
@@ -96,6 +102,7 @@ private:
         keypair_out_file = vm["keypair_out_file"].as<std::string>();
         powersoftau_degree =
             vm.count("pot-degree") ? vm["pot-degree"].as<size_t>() : 0;
+        mapped = (bool)vm.count("mapped");
     }
 
     void subcommand_usage() override
@@ -114,6 +121,7 @@ private:
                       << "phase2_challenge_file: " << phase2_challenge_file
                       << "\n"
                       << "powersoftau_degree: " << powersoftau_degree << "\n"
+                      << "mapped: " << mapped << "\n"
                       << "out_file: " << keypair_out_file << std::endl;
         }
 
@@ -171,7 +179,9 @@ private:
             libff::print_indent();
             std::cout << keypair_out_file << std::endl;
         }
-        {
+        if (mapped) {
+            mapped_keypair_write(keypair, keypair_out_file);
+        } else {
             std::ofstream out(
                 keypair_out_file, std::ios_base::binary | std::ios_base::out);
             mpc_write_keypair(out, keypair);
@@ -1,12 +1,19 @@
 #include "circuit_types.hpp"
+#include "libsnark_helpers/key_cache.hpp"
 #include "libsnark_helpers/libsnark_helpers.hpp"
+#include "libsnark_helpers/proof_sink.hpp"
+#include "metrics.hpp"
 #include "snarks_alias.hpp"
 #include "util.hpp"
 #include "util_api.hpp"
 #include "zeth.h"
 #include "zethConfig.h"
 
+#include <algorithm>
 #include <boost/program_options.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <grpc/grpc.h>
 #include <grpcpp/security/server_credentials.h>
@@ -15,8 +22,16 @@
 #include <grpcpp/server_context.h>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <signal.h>
 #include <stdio.h>
 #include <string>
+#include <thread>
+#include <vector>
+
+#ifdef MULTICORE
+#include <omp.h>
+#endif
 
 // Necessary header to parse the data
 #include <libsnark/common/data_structures/merkle_tree.hpp>
@@ -33,232 +48,1435 @@
 namespace proto = google::protobuf;
 namespace po = boost::program_options;
 
-/// The prover_server class inherits from the Prover service
-/// defined in the proto files, and provides an implementation
-/// of the service.
-class prover_server final : public prover_proto::Prover::Service
+static std::string get_server_version()
+{
+    char buffer[100];
+    int n;
+    // Defined in the zethConfig file
+    n = snprintf(
+        buffer, 100, "Version %d.%d", ZETH_VERSION_MAJOR, ZETH_VERSION_MINOR);
+    if (n < 0) {
+        return "Version <Not specified>";
+    }
+    std::string version(buffer);
+    return version;
+}
+
+static void display_server_start_message()
+{
+    std::string copyright =
+        "Copyright (c) 2015-2019 Clearmatics Technologies Ltd";
+    std::string license = "SPDX-License-Identifier: LGPL-3.0+";
+    std::string project =
+        "R&D Department: PoC for Zerocash on Ethereum/Autonity";
+    std::string version = get_server_version();
+    std::string warning = "**WARNING:** This code is a research-quality proof "
+                          "of concept, DO NOT use in production!";
+
+    std::cout << "\n=====================================================\n";
+    std::cout << copyright << "\n";
+    std::cout << license << "\n";
+    std::cout << project << "\n";
+    std::cout << version << "\n";
+    std::cout << warning << "\n";
+    std::cout << "=====================================================\n"
+              << std::endl;
+}
+
+using proof_sinkT = libzeth::proof_sink<ppT>;
+using ring_proof_sinkT = libzeth::ring_buffer_proof_sink<ppT>;
+
+template<size_t NumInputs, size_t NumOutputs>
+using proof_inputsT =
+    libzeth::joinsplit_proof_inputs<FieldT, NumInputs, NumOutputs>;
+
+// Throw if the server cannot encode its responses with `encoding`
+static void check_encoding(const prover_proto::Encoding encoding)
+{
+#ifndef ZKSNARK_GROTH16
+    if (encoding == prover_proto::ENCODING_BINARY) {
+        throw std::invalid_argument(
+            "Binary encoding is only supported with GROTH16");
+    }
+#else
+    (void)encoding;
+#endif
+}
+
+// Parse the binary form of the proof inputs (throws if the message is invalid)
+template<size_t NumInputs, size_t NumOutputs>
+static proof_inputsT<NumInputs, NumOutputs> parse_proof_inputs_binary(
+    const prover_proto::ProofInputsBinary &proof_inputs)
+{
+    FieldT root = libzeth::bytes_to_field<FieldT>(proof_inputs.mk_root());
+    libzeth::bits64 vpub_in =
+        libzeth::bytes_value_to_bits64(proof_inputs.pub_in_value());
+    libzeth::bits64 vpub_out =
+        libzeth::bytes_value_to_bits64(proof_inputs.pub_out_value());
+    libzeth::bits256 h_sig_in =
+        libzeth::bytes_digest_to_bits256(proof_inputs.h_sig());
+    libzeth::bits256 phi_in =
+        libzeth::bytes_digest_to_bits256(proof_inputs.phi());
+
+    if (NumInputs != (size_t)proof_inputs.js_inputs_size()) {
+        throw std::invalid_argument("Invalid number of JS inputs");
+    }
+    if (NumOutputs != (size_t)proof_inputs.js_outputs_size()) {
+        throw std::invalid_argument("Invalid number of JS outputs");
+    }
+
+    std::array<libzeth::joinsplit_input<FieldT>, NumInputs> joinsplit_inputs;
+    for (size_t i = 0; i < NumInputs; i++) {
+        joinsplit_inputs[i] =
+            parse_joinsplit_input<FieldT>(proof_inputs.js_inputs(i));
+    }
+
+    std::array<libzeth::zeth_note, NumOutputs> joinsplit_outputs;
+    for (size_t i = 0; i < NumOutputs; i++) {
+        joinsplit_outputs[i] = parse_zeth_note(proof_inputs.js_outputs(i));
+    }
+
+    return proof_inputsT<NumInputs, NumOutputs>(
+        root,
+        joinsplit_inputs,
+        joinsplit_outputs,
+        vpub_in,
+        vpub_out,
+        h_sig_in,
+        phi_in);
+}
+
+// Parse a received ProofInputs message (throws if the message is invalid)
+template<size_t NumInputs, size_t NumOutputs>
+static proof_inputsT<NumInputs, NumOutputs> parse_proof_inputs(
+    const prover_proto::ProofInputs &proof_inputs)
+{
+    check_encoding(proof_inputs.proof_encoding());
+    if (proof_inputs.has_binary_inputs()) {
+        return parse_proof_inputs_binary<NumInputs, NumOutputs>(
+            proof_inputs.binary_inputs());
+    }
+
+    FieldT root = libzeth::string_to_field<FieldT>(proof_inputs.mk_root());
+    libzeth::bits64 vpub_in =
+        libzeth::hex_value_to_bits64(proof_inputs.pub_in_value());
+    libzeth::bits64 vpub_out =
+        libzeth::hex_value_to_bits64(proof_inputs.pub_out_value());
+    libzeth::bits256 h_sig_in =
+        libzeth::hex_digest_to_bits256(proof_inputs.h_sig());
+    libzeth::bits256 phi_in =
+        libzeth::hex_digest_to_bits256(proof_inputs.phi());
+
+    if (NumInputs != (size_t)proof_inputs.js_inputs_size()) {
+        throw std::invalid_argument("Invalid number of JS inputs");
+    }
+    if (NumOutputs != (size_t)proof_inputs.js_outputs_size()) {
+        throw std::invalid_argument("Invalid number of JS outputs");
+    }
+
+    std::array<libzeth::joinsplit_input<FieldT>, NumInputs> joinsplit_inputs;
+    for (size_t i = 0; i < NumInputs; i++) {
+        prover_proto::JoinsplitInput received_input = proof_inputs.js_inputs(i);
+        libzeth::joinsplit_input<FieldT> parsed_input =
+            parse_joinsplit_input<FieldT>(received_input);
+        joinsplit_inputs[i] = parsed_input;
+    }
+
+    std::array<libzeth::zeth_note, NumOutputs> joinsplit_outputs;
+    for (size_t i = 0; i < NumOutputs; i++) {
+        prover_proto::ZethNote received_output = proof_inputs.js_outputs(i);
+        libzeth::zeth_note parsed_output = parse_zeth_note(received_output);
+        joinsplit_outputs[i] = parsed_output;
+    }
+
+    return proof_inputsT<NumInputs, NumOutputs>(
+        root,
+        joinsplit_inputs,
+        joinsplit_outputs,
+        vpub_in,
+        vpub_out,
+        h_sig_in,
+        phi_in);
+}
+
+// Fill the response message, in the encoding requested by the client
+static void prepare_response(
+    extended_proof<ppT> &ext_proof,
+    const prover_proto::Encoding encoding,
+    prover_proto::ExtendedProof *proof)
+{
+#ifdef ZKSNARK_GROTH16
+    if (encoding == prover_proto::ENCODING_BINARY) {
+        prepare_proof_response_binary<ppT>(ext_proof, proof);
+        return;
+    }
+#else
+    (void)encoding;
+#endif
+    prepare_proof_response<ppT>(ext_proof, proof);
+}
+
+/// Prepared joinsplit circuit, of one of the sizes (number of inputs and
+/// outputs) served by the server. The size is a template parameter of the
+/// circuit, hence the operations which depend on it are behind this interface.
+class joinsplit_circuit
+{
+public:
+    virtual ~joinsplit_circuit(){};
+
+    virtual size_t num_constraints() const = 0;
+
+    // Generate a new keypair, written to the setup directory of the circuit
+    virtual keyPairT<ppT> generate_trusted_setup() const = 0;
+
+#ifdef ZKSNARK_GROTH16
+    // Read a keypair from `keypair_file` (stream or mapped format)
+    virtual keyPairT<ppT> load_keypair(
+        const std::string &keypair_file) const = 0;
+#endif
+
+#ifdef DEBUG
+    virtual void dump_constraint_system(
+        boost::filesystem::path file_path) const = 0;
+#endif
+
+    // Parse the received message and generate its proof (throws if the
+    // message is invalid)
+    virtual extended_proof<ppT> prove(
+        const prover_proto::ProofInputs &proof_inputs,
+        const provingKeyT<ppT> &proving_key) const = 0;
+
+    // Parse the received messages and generate their proofs in a batch
+    virtual std::vector<extended_proof<ppT>> prove_batch(
+        const std::vector<const prover_proto::ProofInputs *> &proof_inputs,
+        const provingKeyT<ppT> &proving_key) const = 0;
+};
+
+template<size_t NumInputs, size_t NumOutputs>
+class joinsplit_circuit_impl final : public joinsplit_circuit
 {
 private:
-    libzeth::circuit_wrapper<
-        FieldT,
-        HashT,
-        HashTreeT,
-        ppT,
-        ZETH_NUM_JS_INPUTS,
-        ZETH_NUM_JS_OUTPUTS>
-        prover;
-
-    // The keypair is the result of the setup
-    keyPairT<ppT> keypair;
+    const libzeth::
+        circuit_wrapper<FieldT, HashT, HashTreeT, ppT, NumInputs, NumOutputs>
+            wrapper;
 
 public:
-    explicit prover_server(
-        libzeth::circuit_wrapper<
-            FieldT,
-            HashT,
-            HashTreeT,
-            ppT,
-            ZETH_NUM_JS_INPUTS,
-            ZETH_NUM_JS_OUTPUTS> &prover,
-        keyPairT<ppT> &keypair)
-        : prover(prover), keypair(keypair)
+    joinsplit_circuit_impl(
+        const boost::filesystem::path &setup_path,
+        libzeth::satisfiability_check sat_check,
+        size_t sat_check_samples)
+        : wrapper(setup_path, sat_check, sat_check_samples)
+    {
+    }
+
+    size_t num_constraints() const override
     {
+        return wrapper.pb.num_constraints();
     }
 
-    grpc::Status GetVerificationKey(
-        grpc::ServerContext *,
-        const proto::Empty *,
-        prover_proto::VerificationKey *response) override
+    keyPairT<ppT> generate_trusted_setup() const override
+    {
+        return wrapper.generate_trusted_setup();
+    }
+
+#ifdef ZKSNARK_GROTH16
+    keyPairT<ppT> load_keypair(const std::string &keypair_file) const override
     {
+        // Keypairs in the mapped format are copied from the file in bulk. The
+        // constraint system is taken from the circuit rather than parsed.
+        if (libzeth::mapped_keypair_is_mapped_file(keypair_file)) {
+            return libzeth::mapped_keypair_read<ppT>(
+                keypair_file, wrapper.pb.get_constraint_system());
+        }
+
+        std::ifstream in(
+            keypair_file, std::ios_base::in | std::ios_base::binary);
+        in.exceptions(
+            std::ios_base::eofbit | std::ios_base::badbit |
+            std::ios_base::failbit);
+        return libzeth::mpc_read_keypair<ppT>(in);
+    }
+#endif
+
+#ifdef DEBUG
+    void dump_constraint_system(
+        boost::filesystem::path file_path) const override
+    {
+        wrapper.dump_constraint_system(file_path);
+    }
+#endif
+
+    extended_proof<ppT> prove(
+        const prover_proto::ProofInputs &proof_inputs,
+        const provingKeyT<ppT> &proving_key) const override
+    {
+        libzeth::metrics_timer parse_timer("parse_request");
+        const proof_inputsT<NumInputs, NumOutputs> js =
+            parse_proof_inputs<NumInputs, NumOutputs>(proof_inputs);
+        parse_timer.stop();
+
+        return wrapper.prove(
+            js.root,
+            js.inputs,
+            js.outputs,
+            js.vpub_in,
+            js.vpub_out,
+            js.h_sig,
+            js.phi,
+            proving_key);
+    }
+
+    std::vector<extended_proof<ppT>> prove_batch(
+        const std::vector<const prover_proto::ProofInputs *> &proof_inputs,
+        const provingKeyT<ppT> &proving_key) const override
+    {
+        libzeth::metrics_timer parse_timer("parse_request");
+        std::vector<proof_inputsT<NumInputs, NumOutputs>> batch;
+        batch.reserve(proof_inputs.size());
+        for (const prover_proto::ProofInputs *inputs : proof_inputs) {
+            batch.push_back(parse_proof_inputs<NumInputs, NumOutputs>(*inputs));
+        }
+        parse_timer.stop();
+
+        return wrapper.prove_batch(batch, proving_key);
+    }
+};
+
+// Name of the circuit of a joinsplit size, "<inputs>x<outputs>"
+static std::string circuit_name(size_t num_inputs, size_t num_outputs)
+{
+    return std::to_string(num_inputs) + "x" + std::to_string(num_outputs);
+}
+
+// Prepare a circuit of the given size. Each size is a separate instantiation
+// of the joinsplit gadget, so only the sizes listed here can be served.
+static std::unique_ptr<joinsplit_circuit> make_circuit(
+    size_t num_inputs,
+    size_t num_outputs,
+    const boost::filesystem::path &setup_path,
+    libzeth::satisfiability_check sat_check,
+    size_t sat_check_samples)
+{
+    joinsplit_circuit *circuit = nullptr;
+    if (num_inputs == ZETH_NUM_JS_INPUTS &&
+        num_outputs == ZETH_NUM_JS_OUTPUTS) {
+        circuit =
+            new joinsplit_circuit_impl<ZETH_NUM_JS_INPUTS, ZETH_NUM_JS_OUTPUTS>(
+                setup_path, sat_check, sat_check_samples);
+    } else if (num_inputs == 1 && num_outputs == 1) {
+        circuit = new joinsplit_circuit_impl<1, 1>(
+            setup_path, sat_check, sat_check_samples);
+    } else if (num_inputs == 1 && num_outputs == 2) {
+        circuit = new joinsplit_circuit_impl<1, 2>(
+            setup_path, sat_check, sat_check_samples);
+    } else if (num_inputs == 2 && num_outputs == 1) {
+        circuit = new joinsplit_circuit_impl<2, 1>(
+            setup_path, sat_check, sat_check_samples);
+    } else if (num_inputs == 2 && num_outputs == 2) {
+        circuit = new joinsplit_circuit_impl<2, 2>(
+            setup_path, sat_check, sat_check_samples);
+    } else if (num_inputs == 4 && num_outputs == 4) {
+        circuit = new joinsplit_circuit_impl<4, 4>(
+            setup_path, sat_check, sat_check_samples);
+    } else {
+        throw std::invalid_argument(
+            "unsupported circuit size: " +
+            circuit_name(num_inputs, num_outputs));
+    }
+
+    return std::unique_ptr<joinsplit_circuit>(circuit);
+}
+
+// Number of inputs and outputs of the joinsplit of a ProofInputs message
+static std::pair<size_t, size_t> proof_inputs_size(
+    const prover_proto::ProofInputs &proof_inputs)
+{
+    if (proof_inputs.has_binary_inputs()) {
+        return std::pair<size_t, size_t>(
+            proof_inputs.binary_inputs().js_inputs_size(),
+            proof_inputs.binary_inputs().js_outputs_size());
+    }
+    return std::pair<size_t, size_t>(
+        proof_inputs.js_inputs_size(), proof_inputs.js_outputs_size());
+}
+
+/// Circuit served by the server, as given on the command line
+class circuit_spec
+{
+public:
+    size_t num_inputs;
+    size_t num_outputs;
+    // File to load the keypair from. If empty, the keypair is generated.
+    std::string keypair_file;
+};
+
+/// The prover_server class implements the Prover service defined in the
+/// proto files as an *asynchronous* service.
+///
+/// A single thread drives the gRPC completion queue. `Prove`, `ProveBatch` and
+/// `VerifyBatch` requests are pushed onto a bounded queue (requests received
+/// while the queue is full are rejected with RESOURCE_EXHAUSTED) and served by
+/// a fixed pool of proving workers. The cores are split between the workers,
+/// so that concurrent proofs do not oversubscribe the machine.
+///
+/// Several joinsplit sizes may be served, each by its own circuit and keys,
+/// so that small joinsplits do not pay for the constraints of a larger
+/// circuit. Each worker prepares the circuits it needs on first use, and the
+/// proving keys are held in a cache with a memory limit, from which they are
+/// evicted (and reloaded on demand) least recently used first.
+class prover_server final
+{
+private:
+    // Base class of the state machines handling the RPCs. The address of the
+    // object is used as tag on the completion queue.
+    class call_data
+    {
+    public:
+        virtual ~call_data(){};
+
+        // Called by the completion queue thread when an operation tagged with
+        // this object completes. `ok` is false if the call has been cancelled
+        // or the server is shutting down.
+        virtual void proceed(bool ok) = 0;
+    };
+
+    // Proving requests waiting in the queue
+    class proving_job
+    {
+    public:
+        virtual ~proving_job(){};
+
+        // Called by the proving worker `worker_idx`
+        virtual void process(size_t worker_idx) = 0;
+
+        // Time at which the job entered the queue
+        std::chrono::steady_clock::time_point enqueue_time;
+    };
+
+    // A joinsplit size served by the server
+    class circuit_entry
+    {
+    public:
+        size_t num_inputs;
+        size_t num_outputs;
+        // "<inputs>x<outputs>", also the name of the proving key in the cache
+        std::string name;
+        // Directory of the generated keypair
+        boost::filesystem::path setup_path;
+        // Empty if the keypair was generated (and written to `setup_path`)
+        std::string keypair_file;
+        size_t num_constraints;
+
+        verificationKeyT<ppT> vk;
+        // Verification key with its pairing data precomputed, built once at
+        // startup and shared by all verifications
+        std::unique_ptr<const libzeth::processed_verification_key<ppT>>
+            processed_vk;
+
+        // Prepared circuit of each proving worker (each worker writes its
+        // witnesses on its own protoboards), created on first use
+        std::vector<std::unique_ptr<joinsplit_circuit>> worker_circuits;
+    };
+
+    class get_verification_key_call;
+    class prove_call;
+    class prove_batch_call;
+    class verify_batch_call;
+
+    prover_proto::Prover::AsyncService service;
+    std::unique_ptr<grpc::ServerCompletionQueue> cq;
+    std::unique_ptr<grpc::Server> server;
+
+    // Served circuits, and the one used by requests that do not specify a
+    // size
+    std::vector<std::unique_ptr<circuit_entry>> circuits;
+    size_t default_circuit;
+    const libzeth::satisfiability_check sat_check;
+    const size_t sat_check_samples;
+
+    // Proving keys of the circuits, by circuit name
+    libzeth::key_cache<provingKeyT<ppT>> proving_keys;
+
+    const size_t num_workers;
+    std::vector<std::thread> workers;
+
+    // Receives every generated proof
+    proof_sinkT &sink;
+
+    // Bounded queue of pending proving requests
+    const size_t max_queue_size;
+    // Maximum time a request may wait before its proof is started (0 for no
+    // limit). The deadline set by the client, if any, is also honored.
+    const std::chrono::milliseconds request_timeout;
+    std::deque<proving_job *> prove_queue;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+
+    // Returns false if the queue is full
+    bool enqueue_proving_job(proving_job *job);
+    void worker_loop(size_t worker_idx, int num_threads);
+
+    // Index of the circuit serving joinsplits of the given size. Throws
+    // std::invalid_argument if the size is not served.
+    size_t select_circuit(size_t num_inputs, size_t num_outputs) const;
+
+    // Prepared circuit of the proving worker `worker_idx`. Only this worker
+    // accesses its circuits, so no lock is needed.
+    joinsplit_circuit &worker_circuit(circuit_entry &entry, size_t worker_idx);
+
+    // Load or generate the keypair of a circuit at startup
+    keyPairT<ppT> setup_keypair(
+        const circuit_entry &entry, const joinsplit_circuit &circuit);
+
+    // Proving key of a circuit, reloaded if it has been evicted from the
+    // cache. `circuit` is the circuit of the calling worker.
+    std::shared_ptr<const provingKeyT<ppT>> proving_key(
+        const circuit_entry &entry, const joinsplit_circuit &circuit);
+
+    // Parse the received message, generate the proof on a circuit of the
+    // proving worker `worker_idx` and fill the response message.
+    grpc::Status prove_request(
+        size_t worker_idx,
+        const prover_proto::ProofInputs &proof_inputs,
+        prover_proto::ExtendedProof *proof);
+
+    // Parse the received messages, generate all proofs in batches (one per
+    // circuit) and fill the response messages (in the same order).
+    grpc::Status prove_batch_request(
+        size_t worker_idx,
+        const std::vector<prover_proto::ProofInputs> &proof_inputs,
+        std::vector<prover_proto::ExtendedProof> &proofs);
+
+    // Parse the received proofs, check them against the (processed)
+    // verification keys and fill the response message.
+    grpc::Status verify_batch_request(
+        const prover_proto::VerifyBatchRequest &request,
+        prover_proto::VerifyBatchResponse *response) const;
+
+public:
+    // Prepare the circuits of `specs`, loading or generating their keypairs.
+    // The proving keys are held in a cache of at most `key_cache_size` bytes
+    // (0 for no limit).
+    prover_server(
+        const std::vector<circuit_spec> &specs,
+        libzeth::satisfiability_check sat_check,
+        size_t sat_check_samples,
+        size_t key_cache_size,
+        proof_sinkT &sink,
+        size_t num_workers,
+        size_t max_queue_size,
+        std::chrono::milliseconds request_timeout);
+
+#ifdef DEBUG
+    // Export the constraint system of the default circuit in json format
+    void dump_constraint_system(boost::filesystem::path file_path) const;
+#endif
+
+    // Start the server on the given address and handle the RPCs. As with
+    // the synchronous server, this call only returns if the completion queue
+    // is shut down.
+    void run(const std::string &server_address);
+};
+
+class prover_server::get_verification_key_call
+    : public prover_server::call_data
+{
+private:
+    prover_server &srv;
+    grpc::ServerContext context;
+    prover_proto::VerificationKeyRequest request;
+    prover_proto::VerificationKey response;
+    grpc::ServerAsyncResponseWriter<prover_proto::VerificationKey> responder;
+    bool finished;
+
+public:
+    explicit get_verification_key_call(prover_server &srv)
+        : srv(srv), responder(&context), finished(false)
+    {
+        srv.service.RequestGetVerificationKey(
+            &context, &request, &responder, srv.cq.get(), srv.cq.get(), this);
+    }
+
+    void proceed(bool ok) override
+    {
+        if (finished || !ok) {
+            delete this;
+            return;
+        }
+
+        // Be ready to serve the next request while this one is processed
+        new get_verification_key_call(srv);
+
         std::cout << "[ACK] Received the request to get the verification key"
                   << std::endl;
         std::cout << "[DEBUG] Preparing verification key for response..."
                   << std::endl;
+        grpc::Status status = grpc::Status::OK;
         try {
-            prepare_verification_key_response<ppT>(this->keypair.vk, response);
+            check_encoding(request.encoding());
+            const size_t circuit_idx =
+                (request.num_inputs() == 0 && request.num_outputs() == 0)
+                    ? srv.default_circuit
+                    : srv.select_circuit(
+                          request.num_inputs(), request.num_outputs());
+            verificationKeyT<ppT> &vk = srv.circuits[circuit_idx]->vk;
+#ifdef ZKSNARK_GROTH16
+            if (request.encoding() == prover_proto::ENCODING_BINARY) {
+                prepare_verification_key_response_binary<ppT>(vk, &response);
+            } else {
+                prepare_verification_key_response<ppT>(vk, &response);
+            }
+#else
+            prepare_verification_key_response<ppT>(vk, &response);
+#endif
         } catch (const std::exception &e) {
             std::cout << "[ERROR] " << e.what() << std::endl;
-            return grpc::Status(
+            status = grpc::Status(
                 grpc::StatusCode::INVALID_ARGUMENT, grpc::string(e.what()));
         } catch (...) {
             std::cout << "[ERROR] In catch all" << std::endl;
-            return grpc::Status(grpc::StatusCode::UNKNOWN, "");
+            status = grpc::Status(grpc::StatusCode::UNKNOWN, "");
         }
 
-        return grpc::Status::OK;
+        finished = true;
+        responder.Finish(response, status, this);
     }
+};
+
+class prover_server::prove_call
+    : public prover_server::call_data
+    , public prover_server::proving_job
+{
+private:
+    prover_server &srv;
+    grpc::ServerContext context;
+    prover_proto::ProofInputs request;
+    prover_proto::ExtendedProof response;
+    grpc::ServerAsyncResponseWriter<prover_proto::ExtendedProof> responder;
+    std::chrono::system_clock::time_point deadline;
+    bool finished;
 
-    grpc::Status Prove(
-        grpc::ServerContext *,
-        const prover_proto::ProofInputs *proof_inputs,
-        prover_proto::ExtendedProof *proof) override
+public:
+    explicit prove_call(prover_server &srv)
+        : srv(srv), responder(&context), finished(false)
+    {
+        srv.service.RequestProve(
+            &context, &request, &responder, srv.cq.get(), srv.cq.get(), this);
+    }
+
+    void proceed(bool ok) override
     {
+        if (finished || !ok) {
+            delete this;
+            return;
+        }
+
+        // Be ready to serve the next request while this one is processed
+        new prove_call(srv);
+
         std::cout << "[ACK] Received the request to generate a proof"
                   << std::endl;
-        std::cout << "[DEBUG] Parse received message to compute proof..."
-                  << std::endl;
 
-        // Parse received message to feed to the prover
-        try {
-            FieldT root =
-                libzeth::string_to_field<FieldT>(proof_inputs->mk_root());
-            libzeth::bits64 vpub_in =
-                libzeth::hex_value_to_bits64(proof_inputs->pub_in_value());
-            libzeth::bits64 vpub_out =
-                libzeth::hex_value_to_bits64(proof_inputs->pub_out_value());
-            libzeth::bits256 h_sig_in =
-                libzeth::hex_digest_to_bits256(proof_inputs->h_sig());
-            libzeth::bits256 phi_in =
-                libzeth::hex_digest_to_bits256(proof_inputs->phi());
-
-            if (ZETH_NUM_JS_INPUTS != proof_inputs->js_inputs_size()) {
-                throw std::invalid_argument("Invalid number of JS inputs");
-            }
-            if (ZETH_NUM_JS_OUTPUTS != proof_inputs->js_outputs_size()) {
-                throw std::invalid_argument("Invalid number of JS outputs");
-            }
+        // The client deadline is infinite if none was set
+        deadline = context.deadline();
+        if (srv.request_timeout.count() > 0) {
+            const std::chrono::system_clock::time_point server_deadline =
+                std::chrono::system_clock::now() + srv.request_timeout;
+            deadline = std::min(deadline, server_deadline);
+        }
 
-            std::cout << "[DEBUG] Process every inputs of the JoinSplit"
+        if (!srv.enqueue_proving_job(this)) {
+            std::cout << "[ERROR] Proving queue full, rejecting request"
                       << std::endl;
-            std::array<libzeth::joinsplit_input<FieldT>, ZETH_NUM_JS_INPUTS>
-                joinsplit_inputs;
-            for (int i = 0; i < ZETH_NUM_JS_INPUTS; i++) {
-                prover_proto::JoinsplitInput received_input =
-                    proof_inputs->js_inputs(i);
-                libzeth::joinsplit_input<FieldT> parsed_input =
-                    parse_joinsplit_input<FieldT>(received_input);
-                joinsplit_inputs[i] = parsed_input;
+            finished = true;
+            responder.FinishWithError(
+                grpc::Status(
+                    grpc::StatusCode::RESOURCE_EXHAUSTED,
+                    "proving queue is full"),
+                this);
+        }
+    }
+
+    void process(size_t worker_idx) override
+    {
+        grpc::Status status;
+        if (std::chrono::system_clock::now() > deadline) {
+            std::cout << "[ERROR] Deadline exceeded before proving"
+                      << std::endl;
+            libzeth::metrics::global().increment("expired_requests");
+            status = grpc::Status(
+                grpc::StatusCode::DEADLINE_EXCEEDED,
+                "deadline exceeded while queued");
+        } else {
+            status = srv.prove_request(worker_idx, request, &response);
+        }
+
+        finished = true;
+        if (status.ok()) {
+            responder.Finish(response, status, this);
+        } else {
+            responder.FinishWithError(status, this);
+        }
+    }
+};
+
+class prover_server::prove_batch_call
+    : public prover_server::call_data
+    , public prover_server::proving_job
+{
+private:
+    enum call_state { REQUEST, READ, PROCESS, WRITE, FINISH };
+
+    prover_server &srv;
+    grpc::ServerContext context;
+    grpc::ServerAsyncReaderWriter<
+        prover_proto::ExtendedProof,
+        prover_proto::ProofInputs>
+        stream;
+    prover_proto::ProofInputs next_request;
+    std::vector<prover_proto::ProofInputs> requests;
+    std::vector<prover_proto::ExtendedProof> responses;
+    size_t num_written;
+    std::chrono::system_clock::time_point deadline;
+    call_state state;
+
+    void finish(const grpc::Status &status)
+    {
+        state = FINISH;
+        stream.Finish(status, this);
+    }
+
+    // Write the next response, or finish the call if all have been written
+    void write_next()
+    {
+        if (num_written < responses.size()) {
+            stream.Write(responses[num_written++], this);
+        } else {
+            finish(grpc::Status::OK);
+        }
+    }
+
+public:
+    explicit prove_batch_call(prover_server &srv)
+        : srv(srv), stream(&context), num_written(0), state(REQUEST)
+    {
+        srv.service.RequestProveBatch(
+            &context, &stream, srv.cq.get(), srv.cq.get(), this);
+    }
+
+    void proceed(bool ok) override
+    {
+        switch (state) {
+        case REQUEST:
+            if (!ok) {
+                delete this;
+                return;
             }
 
-            std::cout << "[DEBUG] Process every outputs of the JoinSplit"
+            // Be ready to serve the next request while this one is processed
+            new prove_batch_call(srv);
+
+            std::cout << "[ACK] Received the request to generate a batch of "
+                         "proofs"
                       << std::endl;
-            std::array<libzeth::zeth_note, ZETH_NUM_JS_OUTPUTS>
-                joinsplit_outputs;
-            for (int i = 0; i < ZETH_NUM_JS_OUTPUTS; i++) {
-                prover_proto::ZethNote received_output =
-                    proof_inputs->js_outputs(i);
-                libzeth::zeth_note parsed_output =
-                    parse_zeth_note(received_output);
-                joinsplit_outputs[i] = parsed_output;
+            deadline = context.deadline();
+            state = READ;
+            stream.Read(&next_request, this);
+            break;
+
+        case READ:
+            if (ok) {
+                requests.push_back(next_request);
+                stream.Read(&next_request, this);
+                break;
             }
 
-            std::cout << "[DEBUG] Data parsed successfully" << std::endl;
-            std::cout << "[DEBUG] Generating the proof..." << std::endl;
-            extended_proof<ppT> ext_proof = this->prover.prove(
-                root,
-                joinsplit_inputs,
-                joinsplit_outputs,
-                vpub_in,
-                vpub_out,
-                h_sig_in,
-                phi_in,
-                this->keypair.pk);
-
-            std::cout << "[DEBUG] Displaying the extended proof" << std::endl;
-            ext_proof.dump_proof();
-            ext_proof.dump_primary_inputs();
-
-            std::cout << "[DEBUG] Preparing response..." << std::endl;
-            prepare_proof_response<ppT>(ext_proof, proof);
+            // The client is done sending inputs. The queueing timeout starts
+            // now, once the whole batch has been received.
+            if (requests.empty()) {
+                finish(grpc::Status::OK);
+                break;
+            }
+            if (srv.request_timeout.count() > 0) {
+                const std::chrono::system_clock::time_point server_deadline =
+                    std::chrono::system_clock::now() + srv.request_timeout;
+                deadline = std::min(deadline, server_deadline);
+            }
 
-        } catch (const std::exception &e) {
-            std::cout << "[ERROR] " << e.what() << std::endl;
-            return grpc::Status(
-                grpc::StatusCode::INVALID_ARGUMENT, grpc::string(e.what()));
-        } catch (...) {
-            std::cout << "[ERROR] In catch all" << std::endl;
-            return grpc::Status(grpc::StatusCode::UNKNOWN, "");
+            state = PROCESS;
+            if (!srv.enqueue_proving_job(this)) {
+                std::cout << "[ERROR] Proving queue full, rejecting request"
+                          << std::endl;
+                finish(grpc::Status(
+                    grpc::StatusCode::RESOURCE_EXHAUSTED,
+                    "proving queue is full"));
+            }
+            break;
+
+        case WRITE:
+            if (!ok) {
+                // The stream is broken, no further response can be sent
+                finish(grpc::Status(
+                    grpc::StatusCode::CANCELLED, "failed to send proof"));
+                break;
+            }
+            write_next();
+            break;
+
+        case PROCESS:
+        case FINISH:
+            delete this;
+            break;
         }
+    }
 
-        return grpc::Status::OK;
+    void process(size_t worker_idx) override
+    {
+        if (std::chrono::system_clock::now() > deadline) {
+            std::cout << "[ERROR] Deadline exceeded before proving"
+                      << std::endl;
+            libzeth::metrics::global().increment("expired_requests");
+            finish(grpc::Status(
+                grpc::StatusCode::DEADLINE_EXCEEDED,
+                "deadline exceeded while queued"));
+            return;
+        }
+
+        grpc::Status status =
+            srv.prove_batch_request(worker_idx, requests, responses);
+        if (!status.ok()) {
+            finish(status);
+            return;
+        }
+
+        state = WRITE;
+        write_next();
     }
 };
 
-std::string get_server_version()
+class prover_server::verify_batch_call
+    : public prover_server::call_data
+    , public prover_server::proving_job
 {
-    char buffer[100];
-    int n;
-    // Defined in the zethConfig file
-    n = snprintf(
-        buffer, 100, "Version %d.%d", ZETH_VERSION_MAJOR, ZETH_VERSION_MINOR);
-    if (n < 0) {
-        return "Version <Not specified>";
+private:
+    prover_server &srv;
+    grpc::ServerContext context;
+    prover_proto::VerifyBatchRequest request;
+    prover_proto::VerifyBatchResponse response;
+    grpc::ServerAsyncResponseWriter<prover_proto::VerifyBatchResponse>
+        responder;
+    std::chrono::system_clock::time_point deadline;
+    bool finished;
+
+public:
+    explicit verify_batch_call(prover_server &srv)
+        : srv(srv), responder(&context), finished(false)
+    {
+        srv.service.RequestVerifyBatch(
+            &context, &request, &responder, srv.cq.get(), srv.cq.get(), this);
+    }
+
+    void proceed(bool ok) override
+    {
+        if (finished || !ok) {
+            delete this;
+            return;
+        }
+
+        // Be ready to serve the next request while this one is processed
+        new verify_batch_call(srv);
+
+        std::cout << "[ACK] Received the request to verify a batch of proofs"
+                  << std::endl;
+
+        // The client deadline is infinite if none was set
+        deadline = context.deadline();
+        if (srv.request_timeout.count() > 0) {
+            const std::chrono::system_clock::time_point server_deadline =
+                std::chrono::system_clock::now() + srv.request_timeout;
+            deadline = std::min(deadline, server_deadline);
+        }
+
+        // The pairings are computed by a worker (with its share of the cores),
+        // rather than on the completion queue thread
+        if (!srv.enqueue_proving_job(this)) {
+            std::cout << "[ERROR] Proving queue full, rejecting request"
+                      << std::endl;
+            finished = true;
+            responder.FinishWithError(
+                grpc::Status(
+                    grpc::StatusCode::RESOURCE_EXHAUSTED,
+                    "proving queue is full"),
+                this);
+        }
+    }
+
+    void process(size_t worker_idx) override
+    {
+        (void)worker_idx;
+        grpc::Status status;
+        if (std::chrono::system_clock::now() > deadline) {
+            std::cout << "[ERROR] Deadline exceeded before verifying"
+                      << std::endl;
+            libzeth::metrics::global().increment("expired_requests");
+            status = grpc::Status(
+                grpc::StatusCode::DEADLINE_EXCEEDED,
+                "deadline exceeded while queued");
+        } else {
+            status = srv.verify_batch_request(request, &response);
+        }
+
+        finished = true;
+        if (status.ok()) {
+            responder.Finish(response, status, this);
+        } else {
+            responder.FinishWithError(status, this);
+        }
+    }
+};
+
+prover_server::prover_server(
+    const std::vector<circuit_spec> &specs,
+    libzeth::satisfiability_check sat_check,
+    size_t sat_check_samples,
+    size_t key_cache_size,
+    proof_sinkT &sink,
+    size_t num_workers,
+    size_t max_queue_size,
+    std::chrono::milliseconds request_timeout)
+    : default_circuit(0)
+    , sat_check(sat_check)
+    , sat_check_samples(sat_check_samples)
+    , proving_keys(
+          key_cache_size,
+          [](const provingKeyT<ppT> &pk) { return pk.size_in_bits() / 8; })
+    , num_workers(num_workers)
+    , sink(sink)
+    , max_queue_size(max_queue_size)
+    , request_timeout(request_timeout)
+{
+    if (num_workers == 0) {
+        throw std::invalid_argument("at least one proving worker is required");
+    }
+    if (specs.empty()) {
+        throw std::invalid_argument("at least one circuit is required");
+    }
+
+    for (const circuit_spec &spec : specs) {
+        std::unique_ptr<circuit_entry> entry(new circuit_entry());
+        entry->num_inputs = spec.num_inputs;
+        entry->num_outputs = spec.num_outputs;
+        entry->name = circuit_name(spec.num_inputs, spec.num_outputs);
+        entry->keypair_file = spec.keypair_file;
+        for (const std::unique_ptr<circuit_entry> &other : circuits) {
+            if (other->name == entry->name) {
+                throw std::invalid_argument(
+                    "circuit " + entry->name + " given more than once");
+            }
+        }
+
+        // The circuit of the default size uses the setup directory itself
+        // (as when a single circuit was served), the others a subdirectory.
+        entry->setup_path = libzeth::get_path_to_setup_directory();
+        if (spec.num_inputs == ZETH_NUM_JS_INPUTS &&
+            spec.num_outputs == ZETH_NUM_JS_OUTPUTS) {
+            default_circuit = circuits.size();
+        } else {
+            entry->setup_path /= entry->name;
+            boost::filesystem::create_directories(entry->setup_path);
+        }
+
+        // The circuit used for the setup is then the one of worker 0
+        entry->worker_circuits.resize(num_workers);
+        const joinsplit_circuit &circuit = worker_circuit(*entry, 0);
+        entry->num_constraints = circuit.num_constraints();
+
+        keyPairT<ppT> keypair = setup_keypair(*entry, circuit);
+        entry->vk = keypair.vk;
+        entry->processed_vk.reset(new libzeth::processed_verification_key<ppT>(
+            libzeth::process_verification_key<ppT>(keypair.vk)));
+
+        // This may evict the keys of the previous circuits, which are then
+        // reloaded when needed
+        proving_keys.insert(entry->name, std::move(keypair.pk));
+        circuits.push_back(std::move(entry));
     }
-    std::string version(buffer);
-    return version;
 }
 
-void display_server_start_message()
+size_t prover_server::select_circuit(
+    size_t num_inputs, size_t num_outputs) const
 {
-    std::string copyright =
-        "Copyright (c) 2015-2019 Clearmatics Technologies Ltd";
-    std::string license = "SPDX-License-Identifier: LGPL-3.0+";
-    std::string project =
-        "R&D Department: PoC for Zerocash on Ethereum/Autonity";
-    std::string version = get_server_version();
-    std::string warning = "**WARNING:** This code is a research-quality proof "
-                          "of concept, DO NOT use in production!";
+    // The public inputs of a joinsplit (nullifiers, commitments, and the
+    // hashes binding them to h_sig) cover all of its notes, so a joinsplit
+    // can only be proven by the circuit of its size. Padding with dummy notes
+    // is up to the client, which then picks the smallest size served.
+    for (size_t i = 0; i < circuits.size(); ++i) {
+        if (circuits[i]->num_inputs == num_inputs &&
+            circuits[i]->num_outputs == num_outputs) {
+            return i;
+        }
+    }
 
-    std::cout << "\n=====================================================\n";
-    std::cout << copyright << "\n";
-    std::cout << license << "\n";
-    std::cout << project << "\n";
-    std::cout << version << "\n";
-    std::cout << warning << "\n";
-    std::cout << "=====================================================\n"
-              << std::endl;
+    throw std::invalid_argument(
+        "No circuit for joinsplits of size " +
+        circuit_name(num_inputs, num_outputs));
 }
 
-static void RunServer(
-    libzeth::circuit_wrapper<
-        FieldT,
-        HashT,
-        HashTreeT,
-        ppT,
-        ZETH_NUM_JS_INPUTS,
-        ZETH_NUM_JS_OUTPUTS> &prover,
-    keyPairT<ppT> &keypair)
+joinsplit_circuit &prover_server::worker_circuit(
+    circuit_entry &entry, size_t worker_idx)
 {
-    // Listen for incoming connections on 0.0.0.0:50051
-    std::string server_address("0.0.0.0:50051");
+    std::unique_ptr<joinsplit_circuit> &circuit =
+        entry.worker_circuits[worker_idx];
+    if (!circuit) {
+        std::cout << "[INFO] Preparing the " << entry.name
+                  << " circuit of worker " << worker_idx << std::endl;
+        libzeth::metrics_timer timer("prepare_circuit");
+        circuit = make_circuit(
+            entry.num_inputs,
+            entry.num_outputs,
+            entry.setup_path,
+            sat_check,
+            sat_check_samples);
+    }
+
+    return *circuit;
+}
+
+keyPairT<ppT> prover_server::setup_keypair(
+    const circuit_entry &entry, const joinsplit_circuit &circuit)
+{
+    if (!entry.keypair_file.empty()) {
+#ifdef ZKSNARK_GROTH16
+        std::cout << "[INFO] Loading keypair of the " << entry.name
+                  << " circuit: " << entry.keypair_file << std::endl;
+        return circuit.load_keypair(entry.keypair_file);
+#else
+        throw std::invalid_argument(
+            "Keypair loading not supported in this config");
+#endif
+    }
+
+    std::cout << "[INFO] Generate new keypair for the " << entry.name
+              << " circuit in " << entry.setup_path << std::endl;
+    return circuit.generate_trusted_setup();
+}
+
+std::shared_ptr<const provingKeyT<ppT>> prover_server::proving_key(
+    const circuit_entry &entry, const joinsplit_circuit &circuit)
+{
+    return proving_keys.get(
+        entry.name, [&entry, &circuit]() -> provingKeyT<ppT> {
+            std::cout << "[INFO] Reloading the proving key of the "
+                      << entry.name << " circuit" << std::endl;
+            libzeth::metrics_timer timer("load_proving_key");
+#ifdef ZKSNARK_GROTH16
+            if (!entry.keypair_file.empty()) {
+                return circuit.load_keypair(entry.keypair_file).pk;
+            }
+#else
+            (void)circuit;
+#endif
+            // Written by `generate_trusted_setup`
+            return libzeth::deserialize_proving_key_from_file<ppT>(
+                entry.setup_path / "pk.raw");
+        });
+}
+
+grpc::Status prover_server::prove_request(
+    size_t worker_idx,
+    const prover_proto::ProofInputs &proof_inputs,
+    prover_proto::ExtendedProof *proof)
+{
+    try {
+        const std::pair<size_t, size_t> size = proof_inputs_size(proof_inputs);
+        circuit_entry &entry =
+            *circuits[select_circuit(size.first, size.second)];
+        const joinsplit_circuit &circuit = worker_circuit(entry, worker_idx);
+        const std::shared_ptr<const provingKeyT<ppT>> pk =
+            proving_key(entry, circuit);
+
+        extended_proof<ppT> ext_proof = circuit.prove(proof_inputs, *pk);
+
+        {
+            libzeth::metrics_timer encode_timer("encode_response");
+            prepare_response(ext_proof, proof_inputs.proof_encoding(), proof);
+        }
+        sink.push(ext_proof);
+        libzeth::metrics::global().increment("proofs");
+
+    } catch (const std::exception &e) {
+        std::cout << "[ERROR] " << e.what() << std::endl;
+        libzeth::metrics::global().increment("failed_requests");
+        return grpc::Status(
+            grpc::StatusCode::INVALID_ARGUMENT, grpc::string(e.what()));
+    } catch (...) {
+        std::cout << "[ERROR] In catch all" << std::endl;
+        libzeth::metrics::global().increment("failed_requests");
+        return grpc::Status(grpc::StatusCode::UNKNOWN, "");
+    }
+
+    return grpc::Status::OK;
+}
+
+grpc::Status prover_server::prove_batch_request(
+    size_t worker_idx,
+    const std::vector<prover_proto::ProofInputs> &proof_inputs,
+    std::vector<prover_proto::ExtendedProof> &proofs)
+{
+    try {
+        // Indices of the inputs proven by each circuit. All sizes are checked
+        // before any proof is generated.
+        std::vector<std::vector<size_t>> batches(circuits.size());
+        for (size_t i = 0; i < proof_inputs.size(); ++i) {
+            const std::pair<size_t, size_t> size =
+                proof_inputs_size(proof_inputs[i]);
+            batches[select_circuit(size.first, size.second)].push_back(i);
+        }
+
+        proofs.resize(proof_inputs.size());
+        for (size_t c = 0; c < circuits.size(); ++c) {
+            const std::vector<size_t> &batch = batches[c];
+            if (batch.empty()) {
+                continue;
+            }
+
+            circuit_entry &entry = *circuits[c];
+            const joinsplit_circuit &circuit =
+                worker_circuit(entry, worker_idx);
+            const std::shared_ptr<const provingKeyT<ppT>> pk =
+                proving_key(entry, circuit);
+
+            std::vector<const prover_proto::ProofInputs *> batch_inputs;
+            batch_inputs.reserve(batch.size());
+            for (const size_t i : batch) {
+                batch_inputs.push_back(&proof_inputs[i]);
+            }
+            std::vector<extended_proof<ppT>> ext_proofs =
+                circuit.prove_batch(batch_inputs, *pk);
+
+            libzeth::metrics_timer encode_timer("encode_response");
+            for (size_t j = 0; j < batch.size(); ++j) {
+                prepare_response(
+                    ext_proofs[j],
+                    proof_inputs[batch[j]].proof_encoding(),
+                    &proofs[batch[j]]);
+                sink.push(ext_proofs[j]);
+            }
+            encode_timer.stop();
+            libzeth::metrics::global().increment("proofs", ext_proofs.size());
+        }
+
+    } catch (const std::exception &e) {
+        std::cout << "[ERROR] " << e.what() << std::endl;
+        libzeth::metrics::global().increment("failed_requests");
+        return grpc::Status(
+            grpc::StatusCode::INVALID_ARGUMENT, grpc::string(e.what()));
+    } catch (...) {
+        std::cout << "[ERROR] In catch all" << std::endl;
+        libzeth::metrics::global().increment("failed_requests");
+        return grpc::Status(grpc::StatusCode::UNKNOWN, "");
+    }
+
+    return grpc::Status::OK;
+}
+
+grpc::Status prover_server::verify_batch_request(
+    const prover_proto::VerifyBatchRequest &request,
+    prover_proto::VerifyBatchResponse *response) const
+{
+#ifdef ZKSNARK_GROTH16
+    try {
+        libzeth::metrics_timer parse_timer("parse_request");
+        std::vector<extended_proof<ppT>> ext_proofs;
+        ext_proofs.reserve(request.proofs_size());
+        for (const prover_proto::ExtendedProof &proof : request.proofs()) {
+            ext_proofs.push_back(libzeth::parse_proof<ppT>(proof));
+        }
+        parse_timer.stop();
+
+        // Each proof is checked by the circuits expecting its number of
+        // primary inputs. Circuits of different sizes may expect the same
+        // number, in which case a proof is valid if it is valid for any of
+        // them. Proofs matching no circuit are invalid.
+        std::vector<bool> results(ext_proofs.size(), false);
+        for (const std::unique_ptr<circuit_entry> &entry : circuits) {
+            const size_t num_primary_inputs =
+                entry->processed_vk->ABC_g1.domain_size();
+            std::vector<size_t> indices;
+            std::vector<extended_proof<ppT>> batch;
+            for (size_t i = 0; i < ext_proofs.size(); ++i) {
+                if (!results[i] && ext_proofs[i].get_primary_input().size() ==
+                                       num_primary_inputs) {
+                    indices.push_back(i);
+                    batch.push_back(ext_proofs[i]);
+                }
+            }
+            if (batch.empty()) {
+                continue;
+            }
+
+            const std::vector<bool> batch_results =
+                libzeth::verify_batch<ppT>(batch, *entry->processed_vk);
+            for (size_t j = 0; j < indices.size(); ++j) {
+                results[indices[j]] = batch_results[j];
+            }
+        }
+
+        bool all_valid = true;
+        for (const bool valid : results) {
+            response->add_valid(valid);
+            all_valid = all_valid && valid;
+        }
+        response->set_all_valid(all_valid);
+        libzeth::metrics::global().increment("verified_proofs", results.size());
+
+    } catch (const std::exception &e) {
+        std::cout << "[ERROR] " << e.what() << std::endl;
+        libzeth::metrics::global().increment("failed_requests");
+        return grpc::Status(
+            grpc::StatusCode::INVALID_ARGUMENT, grpc::string(e.what()));
+    } catch (...) {
+        std::cout << "[ERROR] In catch all" << std::endl;
+        libzeth::metrics::global().increment("failed_requests");
+        return grpc::Status(grpc::StatusCode::UNKNOWN, "");
+    }
+
+    return grpc::Status::OK;
+#else
+    (void)request;
+    (void)response;
+    return grpc::Status(
+        grpc::StatusCode::UNIMPLEMENTED,
+        "Batch verification is only supported with GROTH16");
+#endif
+}
 
-    prover_server service(prover, keypair);
+#ifdef DEBUG
+void prover_server::dump_constraint_system(
+    boost::filesystem::path file_path) const
+{
+    circuits[default_circuit]->worker_circuits[0]->dump_constraint_system(
+        file_path);
+}
+#endif
+
+bool prover_server::enqueue_proving_job(proving_job *job)
+{
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (prove_queue.size() >= max_queue_size) {
+            libzeth::metrics::global().increment("rejected_requests");
+            return false;
+        }
+        job->enqueue_time = std::chrono::steady_clock::now();
+        prove_queue.push_back(job);
+    }
+    queue_cv.notify_one();
+    return true;
+}
+
+void prover_server::worker_loop(size_t worker_idx, int num_threads)
+{
+#ifdef MULTICORE
+    // Only affects the OpenMP parallel regions started by this thread
+    omp_set_num_threads(num_threads);
+#else
+    (void)num_threads;
+#endif
+
+    for (;;) {
+        proving_job *job;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [this]() { return !prove_queue.empty(); });
+            job = prove_queue.front();
+            prove_queue.pop_front();
+        }
 
+        const std::chrono::duration<double> queue_time =
+            std::chrono::steady_clock::now() - job->enqueue_time;
+        libzeth::metrics::global().observe("queue_wait", queue_time.count());
+        job->process(worker_idx);
+    }
+}
+
+void prover_server::run(const std::string &server_address)
+{
     grpc::ServerBuilder builder;
 
     // Listen on the given address without any authentication mechanism.
     builder.AddListeningPort(server_address, grpc::InsecureServerCredentials());
 
     // Register "service" as the instance through which we'll communicate with
-    // clients. In this case it corresponds to an *synchronous* service.
+    // clients. In this case it corresponds to an *asynchronous* service.
     builder.RegisterService(&service);
+    cq = builder.AddCompletionQueue();
 
     // Finally assemble the server.
-    std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+    server = builder.BuildAndStart();
     std::cout << "[DEBUG] Server listening on " << server_address << std::endl;
 
-    // Wait for the server to shutdown. Note that some other thread must be
-    // responsible for shutting down the server for this call to ever return.
+    // Start the proving workers, splitting the cores between them
+    int num_threads = 1;
+#ifdef MULTICORE
+    num_threads = std::max(1, omp_get_num_procs() / (int)num_workers);
+#endif
+    std::cout << "[INFO] " << num_workers << " proving worker(s), "
+              << num_threads << " thread(s) each, queue size "
+              << max_queue_size << std::endl;
+    for (const std::unique_ptr<circuit_entry> &entry : circuits) {
+        std::cout << "[INFO] Serving the " << entry->name << " circuit ("
+                  << entry->num_constraints << " constraints)" << std::endl;
+    }
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&prover_server::worker_loop, this, i, num_threads);
+    }
+
     display_server_start_message();
-    server->Wait();
+
+    // Spawn the first instances of each call, then serve the events of the
+    // completion queue.
+    new get_verification_key_call(*this);
+    new prove_call(*this);
+    new prove_batch_call(*this);
+    new verify_batch_call(*this);
+
+    void *tag;
+    bool ok;
+    while (cq->Next(&tag, &ok)) {
+        static_cast<call_data *>(tag)->proceed(ok);
+    }
 }
 
-#ifdef ZKSNARK_GROTH16
-static keyPairT<ppT> load_keypair(const std::string &keypair_file)
+// Periodically write the metrics to `metrics_file`, for a scraper to read
+static void metrics_writer_loop(
+    const std::string &metrics_file, std::chrono::seconds interval)
 {
-    std::ifstream in(keypair_file, std::ios_base::in | std::ios_base::binary);
-    in.exceptions(
-        std::ios_base::eofbit | std::ios_base::badbit | std::ios_base::failbit);
-    return libzeth::mpc_read_keypair<ppT>(in);
+    for (;;) {
+        try {
+            libzeth::metrics::global().write_file(metrics_file);
+        } catch (const std::exception &e) {
+            std::cout << "[ERROR] " << e.what() << std::endl;
+        }
+        std::this_thread::sleep_for(interval);
+    }
+}
+
+// Write the proofs retained by `sink` to json files each time one of
+// `signals` is received (the signals must be blocked in all threads)
+static void proof_dump_loop(const ring_proof_sinkT *sink, sigset_t signals)
+{
+    for (;;) {
+        int signal;
+        if (sigwait(&signals, &signal) != 0) {
+            std::cout << "[ERROR] Failed to wait for signals" << std::endl;
+            return;
+        }
+        try {
+            const size_t num_proofs = sink->write_recent_proofs();
+            std::cout << "[INFO] Wrote " << num_proofs << " recent proof(s)"
+                      << std::endl;
+        } catch (const std::exception &e) {
+            std::cout << "[ERROR] " << e.what() << std::endl;
+        }
+    }
+}
+
+// Parse a joinsplit size "<inputs>x<outputs>" (throws if invalid)
+static std::pair<size_t, size_t> parse_circuit_size(const std::string &size)
+{
+    const size_t x = size.find('x');
+    size_t num_inputs_end = 0;
+    size_t num_outputs_end = 0;
+    try {
+        if (x != std::string::npos) {
+            const size_t num_inputs =
+                std::stoul(size.substr(0, x), &num_inputs_end);
+            const size_t num_outputs =
+                std::stoul(size.substr(x + 1), &num_outputs_end);
+            if (num_inputs_end == x &&
+                num_outputs_end == size.size() - x - 1) {
+                return {num_inputs, num_outputs};
+            }
+        }
+    } catch (const std::logic_error &) {
+    }
+
+    throw std::invalid_argument("invalid circuit size: " + size);
 }
-#endif
 
 int main(int argc, char **argv)
 {
     // Options
     po::options_description options("");
     options.add_options()(
-        "keypair,k", po::value<std::string>(), "file to load keypair from");
+        "circuits",
+        po::value<std::string>(),
+        "comma-separated joinsplit sizes (<inputs>x<outputs>) served, among "
+        "1x1, 1x2, 2x1, 2x2 and 4x4 (default: " +
+            circuit_name(ZETH_NUM_JS_INPUTS, ZETH_NUM_JS_OUTPUTS) + ")");
+    options.add_options()(
+        "keypair,k",
+        po::value<std::vector<std::string>>()->composing(),
+        "file to load the keypair of a circuit from (stream or mapped "
+        "format), as <inputs>x<outputs>=<file>, or <file> for the default "
+        "size. May be repeated. The keypairs of the other circuits are "
+        "generated.");
+    options.add_options()(
+        "key-cache-size",
+        po::value<size_t>(),
+        "memory (in MB) for the proving keys of the circuits, beyond which "
+        "the least recently used keys are evicted and reloaded when needed "
+        "(default: no limit)");
+    options.add_options()(
+        "proving-workers,w",
+        po::value<size_t>(),
+        "number of proofs computed concurrently (default: 1)");
+    options.add_options()(
+        "queue-size,q",
+        po::value<size_t>(),
+        "maximum number of pending proof requests (default: 16)");
+    options.add_options()(
+        "request-timeout,t",
+        po::value<size_t>(),
+        "maximum time (in seconds) a proof request may be queued (default: "
+        "no limit)");
+    options.add_options()(
+        "proof-sink,s",
+        po::value<std::string>(),
+        "what to do with generated proofs: none, file (json files written in "
+        "the background) or ring (most recent proofs kept in memory, and "
+        "written as json files on SIGUSR1) (default: none)");
+    options.add_options()(
+        "proof-sink-dir",
+        po::value<boost::filesystem::path>(),
+        "directory of the json files written by the proof sink (default: "
+        "debug directory)");
+    options.add_options()(
+        "proof-sink-size",
+        po::value<size_t>(),
+        "number of proofs retained by the ring proof sink (default: 16)");
+    options.add_options()(
+        "satisfiability-check,c",
+        po::value<std::string>(),
+        "check of the witness before proving: skip (trusted inputs), reject "
+        "(evaluate all constraints) or sample (evaluate a random sample of the "
+        "constraints) (default: reject)");
+    options.add_options()(
+        "satisfiability-samples",
+        po::value<size_t>(),
+        "number of constraints evaluated by the sample check (default: 1024)");
+    options.add_options()(
+        "metrics-file,m",
+        po::value<std::string>(),
+        "file to which timings and counters are periodically written, in the "
+        "Prometheus text format (default: none)");
+    options.add_options()(
+        "metrics-interval",
+        po::value<size_t>(),
+        "interval (in seconds) between writes of the metrics file (default: "
+        "10)");
+    options.add_options()("verbose,v", "Show the libsnark profiling output");
 #ifdef DEBUG
     options.add_options()(
         "jr1cs,j",
@@ -275,7 +1493,21 @@ int main(int argc, char **argv)
         std::cout << std::endl;
     };
 
-    std::string keypair_file;
+    std::vector<std::string> circuit_sizes{
+        circuit_name(ZETH_NUM_JS_INPUTS, ZETH_NUM_JS_OUTPUTS)};
+    std::vector<std::string> keypair_files;
+    size_t key_cache_size_mb = 0;
+    size_t num_workers = 1;
+    size_t max_queue_size = 16;
+    size_t request_timeout_s = 0;
+    std::string proof_sink_type = "none";
+    boost::filesystem::path proof_sink_dir;
+    size_t proof_sink_size = 16;
+    std::string sat_check_name = "reject";
+    size_t sat_check_samples = 1024;
+    std::string metrics_file;
+    size_t metrics_interval_s = 10;
+    bool verbose = false;
 #ifdef DEBUG
     boost::filesystem::path jr1cs_file;
 #endif
@@ -287,9 +1519,47 @@ int main(int argc, char **argv)
             usage();
             return 0;
         }
+        if (vm.count("circuits")) {
+            circuit_sizes =
+                libzeth::split_list(vm["circuits"].as<std::string>());
+        }
         if (vm.count("keypair")) {
-            keypair_file = vm["keypair"].as<std::string>();
+            keypair_files = vm["keypair"].as<std::vector<std::string>>();
+        }
+        if (vm.count("key-cache-size")) {
+            key_cache_size_mb = vm["key-cache-size"].as<size_t>();
+        }
+        if (vm.count("proving-workers")) {
+            num_workers = vm["proving-workers"].as<size_t>();
+        }
+        if (vm.count("queue-size")) {
+            max_queue_size = vm["queue-size"].as<size_t>();
+        }
+        if (vm.count("request-timeout")) {
+            request_timeout_s = vm["request-timeout"].as<size_t>();
         }
+        if (vm.count("proof-sink")) {
+            proof_sink_type = vm["proof-sink"].as<std::string>();
+        }
+        if (vm.count("proof-sink-dir")) {
+            proof_sink_dir = vm["proof-sink-dir"].as<boost::filesystem::path>();
+        }
+        if (vm.count("proof-sink-size")) {
+            proof_sink_size = vm["proof-sink-size"].as<size_t>();
+        }
+        if (vm.count("satisfiability-check")) {
+            sat_check_name = vm["satisfiability-check"].as<std::string>();
+        }
+        if (vm.count("satisfiability-samples")) {
+            sat_check_samples = vm["satisfiability-samples"].as<size_t>();
+        }
+        if (vm.count("metrics-file")) {
+            metrics_file = vm["metrics-file"].as<std::string>();
+        }
+        if (vm.count("metrics-interval")) {
+            metrics_interval_s = vm["metrics-interval"].as<size_t>();
+        }
+        verbose = vm.count("verbose");
 #ifdef DEBUG
         if (vm.count("jr1cs")) {
             jr1cs_file = vm["jr1cs"].as<boost::filesystem::path>();
@@ -301,44 +1571,146 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    if (num_workers == 0) {
+        std::cerr << " ERROR: at least one proving worker is required"
+                  << std::endl;
+        usage();
+        return 1;
+    }
+
+    libzeth::satisfiability_check sat_check;
+    if (sat_check_name == "skip") {
+        sat_check = libzeth::satisfiability_check_skip;
+    } else if (sat_check_name == "reject") {
+        sat_check = libzeth::satisfiability_check_reject;
+    } else if (sat_check_name == "sample") {
+        sat_check = libzeth::satisfiability_check_sample;
+    } else {
+        std::cerr << " ERROR: invalid satisfiability check: " << sat_check_name
+                  << std::endl;
+        usage();
+        return 1;
+    }
+
+    // Circuits served, with the keypair files given for some of them
+    std::vector<circuit_spec> specs;
+    try {
+        for (const std::string &size : circuit_sizes) {
+            const std::pair<size_t, size_t> parsed = parse_circuit_size(size);
+            specs.push_back({parsed.first, parsed.second, ""});
+        }
+
+        for (const std::string &keypair : keypair_files) {
+            const size_t separator = keypair.find('=');
+            const std::pair<size_t, size_t> size =
+                (separator == std::string::npos)
+                    ? std::pair<size_t, size_t>(
+                          ZETH_NUM_JS_INPUTS, ZETH_NUM_JS_OUTPUTS)
+                    : parse_circuit_size(keypair.substr(0, separator));
+            const std::string file = (separator == std::string::npos)
+                                         ? keypair
+                                         : keypair.substr(separator + 1);
+            bool served = false;
+            for (circuit_spec &spec : specs) {
+                if (spec.num_inputs == size.first &&
+                    spec.num_outputs == size.second) {
+                    spec.keypair_file = file;
+                    served = true;
+                }
+            }
+            if (!served) {
+                throw std::invalid_argument(
+                    "keypair given for a circuit not served: " + keypair);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << " ERROR: " << e.what() << std::endl;
+        usage();
+        return 1;
+    }
+
+#ifndef ZKSNARK_GROTH16
+    if (!keypair_files.empty()) {
+        std::cout << "Keypair loading not supported in this config"
+                  << std::endl;
+        return 1;
+    }
+#endif
+
+    std::unique_ptr<proof_sinkT> sink;
+    ring_proof_sinkT *ring_sink = nullptr;
+    if (proof_sink_type == "none") {
+        sink.reset(new libzeth::null_proof_sink<ppT>());
+    } else if (proof_sink_type == "file") {
+        sink.reset(new libzeth::file_proof_sink<ppT>(proof_sink_dir));
+    } else if (proof_sink_type == "ring" && proof_sink_size > 0) {
+        ring_sink = new ring_proof_sinkT(proof_sink_size, proof_sink_dir);
+        sink.reset(ring_sink);
+    } else {
+        std::cerr << " ERROR: invalid proof sink: " << proof_sink_type
+                  << std::endl;
+        usage();
+        return 1;
+    }
+
+    // The proofs retained by the ring sink are written on SIGUSR1. The signal
+    // is blocked before any other thread is started (threads inherit the
+    // signal mask), and waited for by a dedicated thread.
+    if (ring_sink != nullptr) {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGUSR1);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        std::thread(proof_dump_loop, ring_sink, signals).detach();
+        std::cout << "[INFO] Send SIGUSR1 to write the recent proofs"
+                  << std::endl;
+    }
+
     // We inititalize the curve parameters here
     std::cout << "[INFO] Init params" << std::endl;
     ppT::init_public_params();
+    if (!verbose) {
+        libff::inhibit_profiling_counters = true;
+        libff::inhibit_profiling_info = true;
+    }
 
-    libzeth::circuit_wrapper<
-        FieldT,
-        HashT,
-        HashTreeT,
-        ppT,
-        ZETH_NUM_JS_INPUTS,
-        ZETH_NUM_JS_OUTPUTS>
-        prover;
-    keyPairT<ppT> keypair = [&keypair_file, &prover]() {
-        if (!keypair_file.empty()) {
-#ifdef ZKSNARK_GROTH16
-            std::cout << "[INFO] Loading keypair: " << keypair_file
-                      << std::endl;
-            return load_keypair(keypair_file);
-#else
-            std::cout << "Keypair loading not supported in this config"
-                      << std::endl;
-            exit(1);
-#endif
-        }
-
-        std::cout << "[INFO] Generate new keypair" << std::endl;
-        return prover.generate_trusted_setup();
-    }();
+    // The circuits are prepared, and their keypairs loaded or generated,
+    // before the server starts
+    std::unique_ptr<prover_server> server;
+    try {
+        server.reset(new prover_server(
+            specs,
+            sat_check,
+            sat_check_samples,
+            key_cache_size_mb << 20,
+            *sink,
+            num_workers,
+            max_queue_size,
+            std::chrono::milliseconds(request_timeout_s * 1000)));
+    } catch (const std::exception &e) {
+        std::cerr << " ERROR: " << e.what() << std::endl;
+        return 1;
+    }
 
 #ifdef DEBUG
     // Run only if the flag is set
     if (jr1cs_file != "") {
         std::cout << "[DEBUG] Dump R1CS to json file" << std::endl;
-        prover.dump_constraint_system(jr1cs_file);
+        server->dump_constraint_system(jr1cs_file);
     }
 #endif
 
+    if (!metrics_file.empty()) {
+        std::cout << "[INFO] Writing metrics to " << metrics_file << std::endl;
+        std::thread(
+            metrics_writer_loop,
+            metrics_file,
+            std::chrono::seconds(std::max<size_t>(1, metrics_interval_s)))
+            .detach();
+    }
+
     std::cout << "[INFO] Setup successful, starting the server..." << std::endl;
-    RunServer(prover, keypair);
+    // Listen for incoming connections on 0.0.0.0:50051
+    server->run("0.0.0.0:50051");
     return 0;
 }
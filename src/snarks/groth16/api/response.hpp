@@ -20,6 +20,21 @@ void prepare_verification_key_response(
     libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &vk,
     prover_proto::VerificationKey *message);
 
+// Same as above, using the binary encoding of the messages
+template<typename ppT>
+void prepare_proof_response_binary(
+    extended_proof<ppT> &ext_proof, prover_proto::ExtendedProof *message);
+template<typename ppT>
+void prepare_verification_key_response_binary(
+    libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &vk,
+    prover_proto::VerificationKey *message);
+
+// Parse an extended proof (in either encoding), for instance sent by a client
+// for verification. Throws if the message is not a valid GROTH16 proof
+// encoding. The points are not checked to be on the curve.
+template<typename ppT>
+extended_proof<ppT> parse_proof(const prover_proto::ExtendedProof &message);
+
 } // namespace libzeth
 #include "response.tcc"
 
@@ -89,6 +89,94 @@ void prepare_verification_key_response(
     grpc_verification_key_groth16->set_abc_g1(abc_json_str);
 };
 
+template<typename ppT>
+void prepare_proof_response_binary(
+    extended_proof<ppT> &ext_proof, prover_proto::ExtendedProof *message)
+{
+    libsnark::r1cs_gg_ppzksnark_proof<ppT> proof_obj = ext_proof.get_proof();
+    prover_proto::ExtendedProofGROTH16Binary *grpc_extended_proof_obj =
+        message->mutable_groth16_extended_proof_binary();
+
+    grpc_extended_proof_obj->set_a(
+        format_binaryPointBaseGroup1Affine(proof_obj.g_A));
+    grpc_extended_proof_obj->set_b(
+        format_binaryPointBaseGroup2Affine(proof_obj.g_B));
+    grpc_extended_proof_obj->set_c(
+        format_binaryPointBaseGroup1Affine(proof_obj.g_C));
+
+    for (const libff::Fr<ppT> &input : ext_proof.get_primary_input()) {
+        grpc_extended_proof_obj->add_inputs(field_to_bytes(input));
+    }
+}
+
+template<typename ppT>
+void prepare_verification_key_response_binary(
+    libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &vk,
+    prover_proto::VerificationKey *message)
+{
+    prover_proto::VerificationKeyGROTH16Binary *grpc_verification_key =
+        message->mutable_groth16_verification_key_binary();
+
+    grpc_verification_key->set_alpha_g1(
+        format_binaryPointBaseGroup1Affine(vk.alpha_g1));
+    grpc_verification_key->set_beta_g2(
+        format_binaryPointBaseGroup2Affine(vk.beta_g2));
+    grpc_verification_key->set_delta_g2(
+        format_binaryPointBaseGroup2Affine(vk.delta_g2));
+
+    grpc_verification_key->add_abc_g1(
+        format_binaryPointBaseGroup1Affine(vk.ABC_g1.first));
+    for (const libff::G1<ppT> &abc_i : vk.ABC_g1.rest.values) {
+        grpc_verification_key->add_abc_g1(
+            format_binaryPointBaseGroup1Affine(abc_i));
+    }
+}
+
+template<typename ppT>
+extended_proof<ppT> parse_proof(const prover_proto::ExtendedProof &message)
+{
+    libsnark::r1cs_gg_ppzksnark_proof<ppT> proof_obj;
+    libsnark::r1cs_primary_input<libff::Fr<ppT>> primary_input;
+
+    if (message.has_groth16_extended_proof_binary()) {
+        const prover_proto::ExtendedProofGROTH16Binary &proof =
+            message.groth16_extended_proof_binary();
+        proof_obj.g_A = parse_binaryPointBaseGroup1Affine(proof.a());
+        proof_obj.g_B = parse_binaryPointBaseGroup2Affine(proof.b());
+        proof_obj.g_C = parse_binaryPointBaseGroup1Affine(proof.c());
+        for (const std::string &input : proof.inputs()) {
+            primary_input.push_back(bytes_to_field<libff::Fr<ppT>>(input));
+        }
+    } else if (message.has_groth16_extended_proof()) {
+        const prover_proto::ExtendedProofGROTH16 &proof =
+            message.groth16_extended_proof();
+        proof_obj.g_A = parse_hexPointBaseGroup1Affine(proof.a());
+        proof_obj.g_B = parse_hexPointBaseGroup2Affine(proof.b());
+        proof_obj.g_C = parse_hexPointBaseGroup1Affine(proof.c());
+
+        // Inputs formatted by prepare_proof_response: ["0x...", "0x...", ...]
+        const std::string &inputs = proof.inputs();
+        size_t position = 0;
+        for (;;) {
+            const size_t begin = inputs.find("\"0x", position);
+            if (begin == std::string::npos) {
+                break;
+            }
+            const size_t end = inputs.find('"', begin + 3);
+            if (end == std::string::npos) {
+                throw std::invalid_argument("Invalid proof inputs");
+            }
+            primary_input.push_back(string_to_field<libff::Fr<ppT>>(
+                inputs.substr(begin + 3, end - begin - 3)));
+            position = end + 1;
+        }
+    } else {
+        throw std::invalid_argument("Not a GROTH16 extended proof");
+    }
+
+    return extended_proof<ppT>(proof_obj, primary_input);
+}
+
 } // namespace libzeth
 
 #endif // __ZETH_RESPONSE_TCC__
@@ -10,6 +10,7 @@
 
 #include <libsnark/gadgetlib1/gadget.hpp>
 #include <libsnark/zk_proof_systems/ppzksnark/r1cs_gg_ppzksnark/r1cs_gg_ppzksnark.hpp>
+#include <vector>
 
 namespace libzeth
 {
@@ -19,15 +20,90 @@ libsnark::r1cs_gg_ppzksnark_proof<ppT> gen_proof(
     const libsnark::protoboard<libff::Fr<ppT>> &pb,
     const libsnark::r1cs_gg_ppzksnark_proving_key<ppT> &proving_key);
 
+// Generate one proof per (primary_input, auxiliary_input) pair, all for the
+// circuit of `proving_key`. The multi-exponentiations of the whole batch are
+// computed in a single pass over the proving key: the queries are processed
+// in blocks of `block_size` points, each block being used for every proof of
+// the batch before moving to the next one (a batch of one proof is processed
+// in a single block). The inputs are only read, so that callers can reuse
+// their buffers (see `proving_context`).
+template<typename ppT>
+std::vector<libsnark::r1cs_gg_ppzksnark_proof<ppT>> gen_proof_batch(
+    const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+        &primary_inputs,
+    const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+        &auxiliary_inputs,
+    const libsnark::r1cs_gg_ppzksnark_proving_key<ppT> &proving_key,
+    const size_t block_size = 1 << 14);
+
 template<typename ppT>
 libsnark::r1cs_gg_ppzksnark_keypair<ppT> gen_trusted_setup(
     const libsnark::protoboard<libff::Fr<ppT>> &pb);
 
+// Verification key with the pairing data shared by all verifications
+// precomputed: e(alpha, beta), and the Miller loop line coefficients of the
+// fixed G2 points. It should be built once per loaded key, and reused for all
+// the proofs checked against that key.
+template<typename ppT> class processed_verification_key
+{
+public:
+    libff::GT<ppT> alpha_g1_beta_g2;
+    libff::G1<ppT> alpha_g1;
+    libff::G2_precomp<ppT> beta_g2_precomp;
+    libff::G2_precomp<ppT> delta_g2_precomp;
+    libff::G2_precomp<ppT> generator_g2_precomp;
+    libsnark::accumulation_vector<libff::G1<ppT>> ABC_g1;
+
+    explicit processed_verification_key(
+        const libsnark::r1cs_gg_ppzksnark_verification_key<ppT>
+            &verification_key);
+};
+
+template<typename ppT>
+processed_verification_key<ppT> process_verification_key(
+    const libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &verification_key);
+
+template<typename ppT>
+bool verify(
+    const libzeth::extended_proof<ppT> &ext_proof,
+    const processed_verification_key<ppT> &processed_key);
+
+// Convenience overload, processing `verification_key` for a single proof.
+// Callers checking several proofs should process the key once.
 template<typename ppT>
 bool verify(
     const libzeth::extended_proof<ppT> &ext_proof,
     const libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &verification_key);
 
+// Check the proofs of `ext_proofs` (all for the circuit of
+// `verification_key`) together, and return whether each one is valid.
+//
+// The verification equations of the proofs are combined with random
+// coefficients, so that a single product of Miller loops and a single final
+// exponentiation check the whole batch (a batch containing invalid proofs
+// passes with negligible probability). If the combined check fails, the batch
+// is bisected to identify the invalid proofs.
+template<typename ppT>
+std::vector<bool> verify_batch(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
+    const processed_verification_key<ppT> &processed_key);
+
+template<typename ppT>
+std::vector<bool> verify_batch(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
+    const libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &verification_key);
+
+// Combined check (see `verify_batch`) of the proofs ext_proofs[indices[i]] for
+// i in [begin, end). Returns true if they are all valid. The proofs must be
+// well-formed, with the number of primary inputs expected by the key.
+template<typename ppT>
+bool verify_batch_combined(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
+    const std::vector<size_t> &indices,
+    size_t begin,
+    size_t end,
+    const processed_verification_key<ppT> &processed_key);
+
 } // namespace libzeth
 
 #include "snarks/groth16/core/computation.tcc"
@@ -6,6 +6,16 @@
 #define __ZETH_COMPUTATION_TCC__
 
 #include "computation.hpp"
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <libff/algebra/scalar_multiplication/multiexp.hpp>
+#include <libsnark/knowledge_commitment/kc_multiexp.hpp>
+#include <libsnark/reductions/r1cs_to_qap/r1cs_to_qap.hpp>
+
+#ifdef MULTICORE
+#include <omp.h>
+#endif
 
 namespace libzeth
 {
@@ -19,18 +29,210 @@ libsnark::r1cs_gg_ppzksnark_proof<ppT> gen_proof(
     // See:
     // https://github.com/scipr-lab/libsnark/blob/92a80f74727091fdc40e6021dc42e9f6b67d5176/libsnark/relations/constraint_satisfaction_problems/r1cs/r1cs.hpp#L81
     // For the definition of r1cs_primary_input and r1cs_auxiliary_input
-    libsnark::r1cs_primary_input<libff::Fr<ppT>> primary_input =
-        pb.primary_input();
-    libsnark::r1cs_auxiliary_input<libff::Fr<ppT>> auxiliary_input =
-        pb.auxiliary_input();
-
-    // Generate proof from public input, auxiliary input
-    // (private/secret data), and proving key. For now, force a pow2
-    // domain, in case the key came from the MPC.
-    proofT<ppT> proof = libsnark::r1cs_gg_ppzksnark_prover(
-        proving_key, primary_input, auxiliary_input, true);
-
-    return proof;
+    //
+    // The inputs are moved into the vectors (an initializer list would copy
+    // them a second time).
+    std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>> primary_inputs;
+    std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+        auxiliary_inputs;
+    primary_inputs.push_back(pb.primary_input());
+    auxiliary_inputs.push_back(pb.auxiliary_input());
+
+    // Generate proof from public input, auxiliary input (private/secret data),
+    // and proving key. For a single proof, `gen_proof_batch` computes the same
+    // multi-exponentiations as `libsnark::r1cs_gg_ppzksnark_prover`, and
+    // records the time spent in each stage.
+    return gen_proof_batch<ppT>(
+        primary_inputs, auxiliary_inputs, proving_key)[0];
+};
+
+// Generate a batch of proofs for the same circuit. This follows
+// `libsnark::r1cs_gg_ppzksnark_prover`, except that the evaluations of the
+// A, B, H and L queries are interleaved across the proofs of the batch.
+template<typename ppT>
+std::vector<libsnark::r1cs_gg_ppzksnark_proof<ppT>> gen_proof_batch(
+    const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+        &primary_inputs,
+    const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+        &auxiliary_inputs,
+    const libsnark::r1cs_gg_ppzksnark_proving_key<ppT> &proving_key,
+    const size_t block_size)
+{
+    using Fr = libff::Fr<ppT>;
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+    using kcT = libsnark::knowledge_commitment<G2, G1>;
+    const libff::multi_exp_method Method = libff::multi_exp_method_BDLO12;
+
+    if (primary_inputs.size() != auxiliary_inputs.size()) {
+        throw std::invalid_argument("input size mismatch (gen_proof_batch)");
+    }
+    if (block_size == 0) {
+        throw std::invalid_argument("invalid block size (gen_proof_batch)");
+    }
+
+    const size_t num_proofs = primary_inputs.size();
+    std::vector<proofT<ppT>> proofs;
+    if (num_proofs == 0) {
+        return proofs;
+    }
+
+#ifdef MULTICORE
+    const size_t chunks = omp_get_max_threads();
+#else
+    const size_t chunks = 1;
+#endif
+
+    // Blocks only serve to share the proving key accesses between the proofs
+    // of a batch. A single proof is computed in one block.
+    const size_t block = (num_proofs > 1) ? block_size
+                                          : std::max(
+                                                {proving_key.A_query.size(),
+                                                 proving_key.H_query.size(),
+                                                 proving_key.L_query.size(),
+                                                 (size_t)1});
+
+    libff::enter_block("Call to gen_proof_batch");
+
+    // Compute the polynomial H of each proof. As in `gen_proof`, force a pow2
+    // domain in case the key came from the MPC.
+    libff::enter_block("Compute the polynomials H");
+    metrics_timer qap_timer("prover_qap_witness_map");
+    std::vector<libsnark::qap_witness<Fr>> qap_wits;
+    qap_wits.reserve(num_proofs);
+    for (size_t j = 0; j < num_proofs; ++j) {
+        qap_wits.push_back(libsnark::r1cs_to_qap_witness_map(
+            proving_key.constraint_system,
+            primary_inputs[j],
+            auxiliary_inputs[j],
+            Fr::zero(),
+            Fr::zero(),
+            Fr::zero(),
+            true));
+    }
+    qap_timer.stop();
+    libff::leave_block("Compute the polynomials H");
+
+    const size_t num_variables = qap_wits[0].num_variables();
+    const size_t num_inputs = qap_wits[0].num_inputs();
+    const size_t h_size = qap_wits[0].degree() - 1;
+
+    // The A, B and L queries are indexed by the variables of the assignment
+    // padded with the constant 1 (at index 0), while `coefficients_for_ABCs`
+    // holds the unpadded assignment (variable i at index i - 1). Rather than
+    // building a padded copy of each assignment, the terms of index 0 are
+    // computed once for all proofs.
+    const std::vector<Fr> constant_one{Fr::one()};
+    const G1 A_0 = proving_key.A_query[0];
+    const kcT B_0 =
+        libsnark::kc_multi_exp_with_mixed_addition<G2, G1, Fr, Method>(
+            proving_key.B_query,
+            0,
+            1,
+            constant_one.begin(),
+            constant_one.end(),
+            1);
+
+    std::vector<G1> evaluation_At(num_proofs, A_0);
+    std::vector<kcT> evaluation_Bt(num_proofs, B_0);
+    std::vector<G1> evaluation_Ht(num_proofs, G1::zero());
+    std::vector<G1> evaluation_Lt(num_proofs, G1::zero());
+
+    libff::enter_block("Compute evaluations to A and B-queries");
+    metrics_timer ab_timer("prover_multiexp_A_B");
+    for (size_t begin = 1; begin < num_variables + 1; begin += block) {
+        const size_t end = std::min(begin + block, num_variables + 1);
+        for (size_t j = 0; j < num_proofs; ++j) {
+            const auto scalars = qap_wits[j].coefficients_for_ABCs.begin();
+            evaluation_At[j] =
+                evaluation_At[j] +
+                libff::multi_exp_with_mixed_addition<G1, Fr, Method>(
+                    proving_key.A_query.begin() + begin,
+                    proving_key.A_query.begin() + end,
+                    scalars + (begin - 1),
+                    scalars + (end - 1),
+                    chunks);
+            evaluation_Bt[j] =
+                evaluation_Bt[j] +
+                libsnark::kc_multi_exp_with_mixed_addition<G2, G1, Fr, Method>(
+                    proving_key.B_query,
+                    begin,
+                    end,
+                    scalars + (begin - 1),
+                    scalars + (end - 1),
+                    chunks);
+        }
+    }
+    ab_timer.stop();
+    libff::leave_block("Compute evaluations to A and B-queries");
+
+    libff::enter_block("Compute evaluations to H-query");
+    metrics_timer h_timer("prover_multiexp_H");
+    for (size_t begin = 0; begin < h_size; begin += block) {
+        const size_t end = std::min(begin + block, h_size);
+        for (size_t j = 0; j < num_proofs; ++j) {
+            evaluation_Ht[j] =
+                evaluation_Ht[j] +
+                libff::multi_exp<G1, Fr, Method>(
+                    proving_key.H_query.begin() + begin,
+                    proving_key.H_query.begin() + end,
+                    qap_wits[j].coefficients_for_H.begin() + begin,
+                    qap_wits[j].coefficients_for_H.begin() + end,
+                    chunks);
+        }
+    }
+    h_timer.stop();
+    libff::leave_block("Compute evaluations to H-query");
+
+    // L_query[i] corresponds to the variable of index num_inputs + 1 + i in
+    // the padded assignment (index num_inputs + i in the unpadded one)
+    libff::enter_block("Compute evaluations to L-query");
+    metrics_timer l_timer("prover_multiexp_L");
+    const size_t l_size = proving_key.L_query.size();
+    for (size_t begin = 0; begin < l_size; begin += block) {
+        const size_t end = std::min(begin + block, l_size);
+        for (size_t j = 0; j < num_proofs; ++j) {
+            const auto scalars =
+                qap_wits[j].coefficients_for_ABCs.begin() + num_inputs;
+            evaluation_Lt[j] =
+                evaluation_Lt[j] +
+                libff::multi_exp_with_mixed_addition<G1, Fr, Method>(
+                    proving_key.L_query.begin() + begin,
+                    proving_key.L_query.begin() + end,
+                    scalars + begin,
+                    scalars + end,
+                    chunks);
+        }
+    }
+    l_timer.stop();
+    libff::leave_block("Compute evaluations to L-query");
+
+    proofs.reserve(num_proofs);
+    for (size_t j = 0; j < num_proofs; ++j) {
+        // Random field elements for the zero-knowledge of each proof
+        const Fr r = Fr::random_element();
+        const Fr s = Fr::random_element();
+
+        // A = alpha + sum_i(a_i*A_i(t)) + r*delta
+        G1 g1_A = proving_key.alpha_g1 + evaluation_At[j] +
+                  r * proving_key.delta_g1;
+
+        // B = beta + sum_i(a_i*B_i(t)) + s*delta
+        G1 g1_B = proving_key.beta_g1 + evaluation_Bt[j].h +
+                  s * proving_key.delta_g1;
+        G2 g2_B = proving_key.beta_g2 + evaluation_Bt[j].g +
+                  s * proving_key.delta_g2;
+
+        // C = sum_i(a_i*((beta*A_i(t) + alpha*B_i(t) + C_i(t)) +
+        // H(t)*Z(t))/delta) + A*s + r*b - r*s*delta
+        G1 g1_C = evaluation_Ht[j] + evaluation_Lt[j] + s * g1_A + r * g1_B -
+                  (r * s) * proving_key.delta_g1;
+
+        proofs.emplace_back(std::move(g1_A), std::move(g2_B), std::move(g1_C));
+    }
+
+    libff::leave_block("Call to gen_proof_batch");
+    return proofs;
 };
 
 // Run the trusted setup and returns a struct {proving_key, verifying_key}
@@ -49,14 +251,271 @@ libsnark::r1cs_gg_ppzksnark_keypair<ppT> gen_trusted_setup(
         pb.get_constraint_system(), true);
 };
 
-// Verification of a proof
+template<typename ppT>
+processed_verification_key<ppT>::processed_verification_key(
+    const libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &verification_key)
+    : alpha_g1_beta_g2(ppT::reduced_pairing(
+          verification_key.alpha_g1, verification_key.beta_g2))
+    , alpha_g1(verification_key.alpha_g1)
+    , beta_g2_precomp(ppT::precompute_G2(verification_key.beta_g2))
+    , delta_g2_precomp(ppT::precompute_G2(verification_key.delta_g2))
+    , generator_g2_precomp(ppT::precompute_G2(libff::G2<ppT>::one()))
+    , ABC_g1(verification_key.ABC_g1)
+{
+}
+
+template<typename ppT>
+processed_verification_key<ppT> process_verification_key(
+    const libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &verification_key)
+{
+    return processed_verification_key<ppT>(verification_key);
+};
+
+// Verification of a proof (A, B, C) for the primary inputs x, checking
+//
+//   e(A, B) * e(-ABC(x), g2) * e(-C, delta) = e(alpha, beta)
+//
+// As in `r1cs_gg_ppzksnark_verifier_strong_IC`, proofs with points not on the
+// curve, or with an unexpected number of primary inputs, are invalid.
 template<typename ppT>
 bool verify(
     const libzeth::extended_proof<ppT> &ext_proof,
+    const processed_verification_key<ppT> &processed_key)
+{
+    using G1 = libff::G1<ppT>;
+
+    const proofT<ppT> &proof = ext_proof.get_proof();
+    const libsnark::r1cs_primary_input<libff::Fr<ppT>> &primary_input =
+        ext_proof.get_primary_input();
+    if (!proof.is_well_formed() ||
+        primary_input.size() != processed_key.ABC_g1.domain_size()) {
+        return false;
+    }
+
+    const libsnark::accumulation_vector<G1> accumulated_abc =
+        processed_key.ABC_g1.template accumulate_chunk<libff::Fr<ppT>>(
+            primary_input.begin(), primary_input.end(), 0);
+    G1 abc = -accumulated_abc.first;
+    G1 c = -proof.g_C;
+    abc.to_affine_coordinates();
+    c.to_affine_coordinates();
+
+    // Only the precomputations of the proof points remain to be done
+    const libff::Fqk<ppT> loops =
+        ppT::double_miller_loop(
+            ppT::precompute_G1(proof.g_A),
+            ppT::precompute_G2(proof.g_B),
+            ppT::precompute_G1(c),
+            processed_key.delta_g2_precomp) *
+        ppT::miller_loop(
+            ppT::precompute_G1(abc), processed_key.generator_g2_precomp);
+
+    return ppT::final_exponentiation(loops) == processed_key.alpha_g1_beta_g2;
+};
+
+template<typename ppT>
+bool verify(
+    const libzeth::extended_proof<ppT> &ext_proof,
+    const libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &verification_key)
+{
+    return verify<ppT>(
+        ext_proof, process_verification_key<ppT>(verification_key));
+};
+
+// Each proof (A, B, C) for the primary inputs x satisfies
+//
+//   e(A, B) = e(alpha, beta) * e(ABC(x), g2) * e(C, delta)
+//
+// Raising the equation of proof i to a random power r_i, and multiplying the
+// equations of the batch, the proofs are checked by
+//
+//   prod_i e(r_i*A_i, B_i) * e(-sum_i(r_i)*alpha, beta) *
+//       e(-sum_i(r_i*ABC(x_i)), g2) * e(-sum_i(r_i*C_i), delta) = 1
+//
+// i.e. one Miller loop per proof plus 3 (whose G2 precomputations are those
+// of the processed key), and a single final exponentiation.
+template<typename ppT>
+bool verify_batch_combined(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
+    const std::vector<size_t> &indices,
+    size_t begin,
+    size_t end,
+    const processed_verification_key<ppT> &processed_key)
+{
+    using Fr = libff::Fr<ppT>;
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+
+    const size_t num_proofs = end - begin;
+    if (num_proofs == 0) {
+        return true;
+    }
+
+    std::vector<libff::G1_precomp<ppT>> g1_precomps(num_proofs);
+    std::vector<libff::G2_precomp<ppT>> g2_precomps(num_proofs);
+    std::vector<Fr> coefficients(num_proofs);
+    std::vector<G1> abc_terms(num_proofs);
+    std::vector<G1> c_terms(num_proofs);
+
+    // Coefficients are drawn sequentially (the generator is not thread-safe)
+    for (size_t i = 0; i < num_proofs; ++i) {
+        coefficients[i] = Fr::random_element();
+    }
+
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t i = 0; i < num_proofs; ++i) {
+        const extended_proof<ppT> &ext_proof = ext_proofs[indices[begin + i]];
+        const proofT<ppT> &proof = ext_proof.get_proof();
+        const libsnark::accumulation_vector<G1> accumulated_abc =
+            processed_key.ABC_g1.template accumulate_chunk<Fr>(
+                ext_proof.get_primary_input().begin(),
+                ext_proof.get_primary_input().end(),
+                0);
+
+        G1 a = coefficients[i] * proof.g_A;
+        a.to_affine_coordinates();
+        g1_precomps[i] = ppT::precompute_G1(a);
+        g2_precomps[i] = ppT::precompute_G2(proof.g_B);
+        abc_terms[i] = coefficients[i] * accumulated_abc.first;
+        c_terms[i] = coefficients[i] * proof.g_C;
+    }
+
+    Fr sum_coefficients = Fr::zero();
+    G1 sum_abc = G1::zero();
+    G1 sum_c = G1::zero();
+    for (size_t i = 0; i < num_proofs; ++i) {
+        sum_coefficients += coefficients[i];
+        sum_abc = sum_abc + abc_terms[i];
+        sum_c = sum_c + c_terms[i];
+    }
+
+    // The G2 points of the shared terms are those of the key, whose
+    // precomputations are reused
+    G1 shared_g1[3] = {
+        -(sum_coefficients * processed_key.alpha_g1), -sum_abc, -sum_c};
+    for (G1 &g1 : shared_g1) {
+        g1.to_affine_coordinates();
+    }
+    const libff::Fqk<ppT> shared_loops =
+        ppT::double_miller_loop(
+            ppT::precompute_G1(shared_g1[0]),
+            processed_key.beta_g2_precomp,
+            ppT::precompute_G1(shared_g1[1]),
+            processed_key.generator_g2_precomp) *
+        ppT::miller_loop(
+            ppT::precompute_G1(shared_g1[2]), processed_key.delta_g2_precomp);
+
+    // Miller loops of the proofs, two pairs at a time (sharing the squarings
+    // of the loop). libff does not provide a loop over an arbitrary number of
+    // pairs.
+    const size_t num_loops = (num_proofs + 1) / 2;
+    std::vector<libff::Fqk<ppT>> loops(num_loops);
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+    for (size_t j = 0; j < num_loops; ++j) {
+        const size_t i = 2 * j;
+        if (i + 1 < num_proofs) {
+            loops[j] = ppT::double_miller_loop(
+                g1_precomps[i],
+                g2_precomps[i],
+                g1_precomps[i + 1],
+                g2_precomps[i + 1]);
+        } else {
+            loops[j] = ppT::miller_loop(g1_precomps[i], g2_precomps[i]);
+        }
+    }
+
+    libff::Fqk<ppT> product = shared_loops;
+    for (const libff::Fqk<ppT> &loop : loops) {
+        product = product * loop;
+    }
+
+    return ppT::final_exponentiation(product) == libff::GT<ppT>::one();
+}
+
+// Identify the invalid proofs among ext_proofs[indices[i]] for i in [begin,
+// end), writing the results to `results`. If `known_invalid` is true, the
+// range is known to contain an invalid proof and is split directly.
+template<typename ppT>
+void verify_batch_bisect(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
+    const std::vector<size_t> &indices,
+    size_t begin,
+    size_t end,
+    bool known_invalid,
+    const processed_verification_key<ppT> &processed_key,
+    std::vector<bool> &results)
+{
+    const bool valid =
+        !known_invalid &&
+        verify_batch_combined<ppT>(
+            ext_proofs, indices, begin, end, processed_key);
+    if (valid) {
+        for (size_t i = begin; i < end; ++i) {
+            results[indices[i]] = true;
+        }
+        return;
+    }
+
+    if (end - begin == 1) {
+        results[indices[begin]] = false;
+        return;
+    }
+
+    // If the first half is valid, the invalid proof is in the second half
+    const size_t middle = begin + (end - begin) / 2;
+    verify_batch_bisect<ppT>(
+        ext_proofs, indices, begin, middle, false, processed_key, results);
+    const bool first_half_valid = std::all_of(
+        indices.begin() + begin,
+        indices.begin() + middle,
+        [&results](size_t index) { return results[index]; });
+    verify_batch_bisect<ppT>(
+        ext_proofs,
+        indices,
+        middle,
+        end,
+        first_half_valid,
+        processed_key,
+        results);
+}
+
+template<typename ppT>
+std::vector<bool> verify_batch(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
+    const processed_verification_key<ppT> &processed_key)
+{
+    metrics_timer timer("verify_batch");
+    std::vector<bool> results(ext_proofs.size(), false);
+
+    // As in `verify`, proofs with points not on the curve, or with an
+    // unexpected number of primary inputs, are invalid. They are not included
+    // in the combined check.
+    std::vector<size_t> indices;
+    indices.reserve(ext_proofs.size());
+    for (size_t i = 0; i < ext_proofs.size(); ++i) {
+        if (ext_proofs[i].get_proof().is_well_formed() &&
+            ext_proofs[i].get_primary_input().size() ==
+                processed_key.ABC_g1.domain_size()) {
+            indices.push_back(i);
+        }
+    }
+
+    verify_batch_bisect<ppT>(
+        ext_proofs, indices, 0, indices.size(), false, processed_key, results);
+    return results;
+};
+
+template<typename ppT>
+std::vector<bool> verify_batch(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
     const libsnark::r1cs_gg_ppzksnark_verification_key<ppT> &verification_key)
 {
-    return libsnark::r1cs_gg_ppzksnark_verifier_strong_IC<ppT>(
-        verification_key, ext_proof.get_primary_input(), ext_proof.get_proof());
+    return verify_batch<ppT>(
+        ext_proofs, process_verification_key<ppT>(verification_key));
 };
 
 } // namespace libzeth
@@ -0,0 +1,21 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "snarks/groth16/mpc/mapped_keypair.hpp"
+
+namespace libzeth
+{
+
+bool mapped_keypair_is_mapped_file(const std::string &filename)
+{
+    std::ifstream in(filename, std::ios_base::binary | std::ios_base::in);
+    char magic[sizeof(mapped_keypair_magic)];
+    if (!in.read(magic, sizeof(magic))) {
+        return false;
+    }
+
+    return 0 == memcmp(magic, mapped_keypair_magic, sizeof(magic));
+}
+
+} // namespace libzeth
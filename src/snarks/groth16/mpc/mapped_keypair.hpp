@@ -0,0 +1,58 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SNARKS_GROTH16_MPC_MAPPED_KEYPAIR_HPP__
+#define __ZETH_SNARKS_GROTH16_MPC_MAPPED_KEYPAIR_HPP__
+
+#include "include_libsnark.hpp"
+
+#include <string>
+
+// Native binary format for Groth16 keypairs, loaded without parsing.
+//
+// The stream format written by `mpc_write_keypair` encodes each curve point
+// separately, and reading a key for a large circuit spends most of its time
+// decoding points one by one. Instead, this format holds every query of the
+// proving key (A, B, H and L) as a fixed-size array of points in their
+// in-memory representation (Jacobian coordinates in Montgomery form), behind
+// a header giving the number of entries of each array. A file is
+// memory-mapped and each array is copied in bulk into the proving key.
+//
+// The constraint system and the verification key (both small compared to the
+// queries) follow the point arrays in the libsnark stream format.
+//
+// Points are stored as they are in memory, so files are not portable across
+// architectures or curve implementations. The sizes of the points, and the
+// representation of the generators, are checked when reading a file.
+namespace libzeth
+{
+
+/// Write a keypair to `filename` in the mapped format.
+template<typename ppT>
+void mapped_keypair_write(
+    const libsnark::r1cs_gg_ppzksnark_keypair<ppT> &keypair,
+    const std::string &filename);
+
+/// Read a keypair in the mapped format from `filename`.
+template<typename ppT>
+libsnark::r1cs_gg_ppzksnark_keypair<ppT> mapped_keypair_read(
+    const std::string &filename);
+
+/// Read a keypair in the mapped format from `filename`, using
+/// `constraint_system` (typically generated from the circuit by the caller)
+/// in place of the one held in the file. The dimensions of the constraint
+/// system are checked against the file.
+template<typename ppT>
+libsnark::r1cs_gg_ppzksnark_keypair<ppT> mapped_keypair_read(
+    const std::string &filename,
+    libsnark::r1cs_constraint_system<libff::Fr<ppT>> &&constraint_system);
+
+/// Returns true if `filename` holds a keypair in the mapped format.
+bool mapped_keypair_is_mapped_file(const std::string &filename);
+
+} // namespace libzeth
+
+#include "snarks/groth16/mpc/mapped_keypair.tcc"
+
+#endif // __ZETH_SNARKS_GROTH16_MPC_MAPPED_KEYPAIR_HPP__
@@ -0,0 +1,350 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_SNARKS_GROTH16_MPC_MAPPED_KEYPAIR_TCC__
+#define __ZETH_SNARKS_GROTH16_MPC_MAPPED_KEYPAIR_TCC__
+
+#include "mapped_keypair.hpp"
+// This comment preserves include order under clang-format.
+#include "phase2.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+namespace libzeth
+{
+
+const char mapped_keypair_magic[8] = {'Z', 'E', 'T', 'H', 'K', 'E', 'Y', 0};
+const uint32_t mapped_keypair_version = 1;
+// Every section of the file starts on a cache line boundary
+const size_t mapped_keypair_alignment = 64;
+
+// Header at the start of the file. It is followed by the sections:
+// - G1 and G2 generators (to check the representation of the points),
+// - alpha_g1, beta_g1, beta_g2, delta_g1, delta_g2,
+// - A_query, B_query indices, B_query values, H_query, L_query,
+// - constraint system and verification key (libsnark stream format).
+struct mapped_keypair_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t g1_size;
+    uint32_t g2_size;
+    uint32_t reserved;
+    uint64_t num_inputs;
+    uint64_t num_variables;
+    uint64_t num_constraints;
+    uint64_t A_query_size;
+    uint64_t B_query_domain_size;
+    uint64_t B_query_size;
+    uint64_t H_query_size;
+    uint64_t L_query_size;
+    uint64_t constraint_system_size;
+    uint64_t verification_key_size;
+};
+
+static inline size_t mapped_keypair_align(const size_t offset)
+{
+    return (offset + mapped_keypair_alignment - 1) &
+           ~(mapped_keypair_alignment - 1);
+}
+
+// Arrays are copied by chunks of this size (in bytes), in parallel
+const size_t mapped_keypair_chunk_size = 1 << 20;
+
+template<typename T>
+static void mapped_keypair_copy(
+    std::vector<T> &dest, const uint8_t *src, const size_t num_entries)
+{
+    dest.resize(num_entries);
+    T *dest_data = dest.data();
+    // The pages of the file are faulted in by several threads at once
+    parallel_for_chunks(
+        num_entries,
+        std::max<size_t>(1, mapped_keypair_chunk_size / sizeof(T)),
+        [dest_data, src](size_t begin, size_t end) {
+            memcpy(
+                dest_data + begin,
+                src + begin * sizeof(T),
+                (end - begin) * sizeof(T));
+            return true;
+        });
+}
+
+template<typename ppT> static void mapped_keypair_check_types()
+{
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+    static_assert(
+        std::is_trivially_copyable<G1>::value &&
+            std::is_trivially_copyable<G2>::value,
+        "mapped keypairs require trivially copyable points");
+    static_assert(
+        sizeof(size_t) == sizeof(uint64_t),
+        "mapped keypairs require 64-bit indices");
+}
+
+template<typename ppT>
+void mapped_keypair_write(
+    const libsnark::r1cs_gg_ppzksnark_keypair<ppT> &keypair,
+    const std::string &filename)
+{
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+    using knowledge_commitment = libsnark::knowledge_commitment<G2, G1>;
+    mapped_keypair_check_types<ppT>();
+
+    const libsnark::r1cs_gg_ppzksnark_proving_key<ppT> &pk = keypair.pk;
+    check_well_formed_(pk, "proving key (write)");
+    check_well_formed_(keypair.vk, "verification key (write)");
+
+    std::string constraint_system;
+    std::string verification_key;
+    {
+        std::ostringstream ss;
+        ss << pk.constraint_system;
+        constraint_system = ss.str();
+    }
+    {
+        std::ostringstream ss;
+        ss << keypair.vk;
+        verification_key = ss.str();
+    }
+
+    mapped_keypair_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, mapped_keypair_magic, sizeof(header.magic));
+    header.version = mapped_keypair_version;
+    header.g1_size = sizeof(G1);
+    header.g2_size = sizeof(G2);
+    header.num_inputs = pk.constraint_system.num_inputs();
+    header.num_variables = pk.constraint_system.num_variables();
+    header.num_constraints = pk.constraint_system.num_constraints();
+    header.A_query_size = pk.A_query.size();
+    header.B_query_domain_size = pk.B_query.domain_size();
+    header.B_query_size = pk.B_query.values.size();
+    header.H_query_size = pk.H_query.size();
+    header.L_query_size = pk.L_query.size();
+    header.constraint_system_size = constraint_system.size();
+    header.verification_key_size = verification_key.size();
+
+    std::ofstream out(filename, std::ios_base::binary | std::ios_base::out);
+    out.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+
+    size_t offset = 0;
+    auto write_section = [&out, &offset](const void *data, const size_t size) {
+        const char padding[mapped_keypair_alignment] = {0};
+        const size_t start = mapped_keypair_align(offset);
+        out.write(padding, start - offset);
+        out.write((const char *)data, size);
+        offset = start + size;
+    };
+
+    write_section(&header, sizeof(header));
+    write_section(&G1::one(), sizeof(G1));
+    write_section(&G2::one(), sizeof(G2));
+    write_section(&pk.alpha_g1, sizeof(G1));
+    write_section(&pk.beta_g1, sizeof(G1));
+    write_section(&pk.beta_g2, sizeof(G2));
+    write_section(&pk.delta_g1, sizeof(G1));
+    write_section(&pk.delta_g2, sizeof(G2));
+    write_section(pk.A_query.data(), pk.A_query.size() * sizeof(G1));
+    write_section(
+        pk.B_query.indices.data(), pk.B_query.indices.size() * sizeof(size_t));
+    write_section(
+        pk.B_query.values.data(),
+        pk.B_query.values.size() * sizeof(knowledge_commitment));
+    write_section(pk.H_query.data(), pk.H_query.size() * sizeof(G1));
+    write_section(pk.L_query.data(), pk.L_query.size() * sizeof(G1));
+    write_section(constraint_system.data(), constraint_system.size());
+    write_section(verification_key.data(), verification_key.size());
+    out.flush();
+}
+
+template<typename ppT>
+static libsnark::r1cs_gg_ppzksnark_keypair<ppT> mapped_keypair_read_data(
+    const std::string &filename,
+    const uint8_t *data,
+    const size_t data_size,
+    libsnark::r1cs_constraint_system<libff::Fr<ppT>> *constraint_system)
+{
+    using G1 = libff::G1<ppT>;
+    using G2 = libff::G2<ppT>;
+    using knowledge_commitment = libsnark::knowledge_commitment<G2, G1>;
+
+    // Return the next section of `num_entries` entries of `entry_size` bytes,
+    // checking that it lies within the file.
+    size_t offset = 0;
+    auto section = [&](const size_t num_entries, const size_t entry_size) {
+        const size_t start = mapped_keypair_align(offset);
+        if (start > data_size ||
+            num_entries > (data_size - start) / entry_size) {
+            throw std::invalid_argument(
+                "Keypair file " + filename + " is truncated");
+        }
+        offset = start + num_entries * entry_size;
+        return data + start;
+    };
+
+    mapped_keypair_header header;
+    memcpy(&header, section(1, sizeof(header)), sizeof(header));
+    if (memcmp(header.magic, mapped_keypair_magic, sizeof(header.magic)) ||
+        header.version != mapped_keypair_version) {
+        throw std::invalid_argument(
+            filename + " is not a mapped keypair file (or has an unsupported "
+                       "version)");
+    }
+    // The sizes of the points and the representation of the generators
+    // identify the curve implementation which wrote the file.
+    if (header.g1_size != sizeof(G1) || header.g2_size != sizeof(G2) ||
+        memcmp(section(1, sizeof(G1)), &G1::one(), sizeof(G1)) ||
+        memcmp(section(1, sizeof(G2)), &G2::one(), sizeof(G2))) {
+        throw std::invalid_argument(
+            "Keypair file " + filename +
+            " was written for a different curve implementation");
+    }
+
+    libsnark::r1cs_gg_ppzksnark_keypair<ppT> keypair;
+    libsnark::r1cs_gg_ppzksnark_proving_key<ppT> &pk = keypair.pk;
+    memcpy(&pk.alpha_g1, section(1, sizeof(G1)), sizeof(G1));
+    memcpy(&pk.beta_g1, section(1, sizeof(G1)), sizeof(G1));
+    memcpy(&pk.beta_g2, section(1, sizeof(G2)), sizeof(G2));
+    memcpy(&pk.delta_g1, section(1, sizeof(G1)), sizeof(G1));
+    memcpy(&pk.delta_g2, section(1, sizeof(G2)), sizeof(G2));
+
+    mapped_keypair_copy(
+        pk.A_query,
+        section(header.A_query_size, sizeof(G1)),
+        header.A_query_size);
+
+    pk.B_query.domain_size_ = header.B_query_domain_size;
+    mapped_keypair_copy(
+        pk.B_query.indices,
+        section(header.B_query_size, sizeof(size_t)),
+        header.B_query_size);
+    mapped_keypair_copy(
+        pk.B_query.values,
+        section(header.B_query_size, sizeof(knowledge_commitment)),
+        header.B_query_size);
+    for (size_t i = 0; i < pk.B_query.indices.size(); ++i) {
+        if (pk.B_query.indices[i] >= pk.B_query.domain_size_ ||
+            (i > 0 && pk.B_query.indices[i] <= pk.B_query.indices[i - 1])) {
+            throw std::invalid_argument(
+                "Keypair file " + filename + " has invalid B_query indices");
+        }
+    }
+
+    mapped_keypair_copy(
+        pk.H_query,
+        section(header.H_query_size, sizeof(G1)),
+        header.H_query_size);
+    mapped_keypair_copy(
+        pk.L_query,
+        section(header.L_query_size, sizeof(G1)),
+        header.L_query_size);
+
+    const uint8_t *cs_data = section(header.constraint_system_size, 1);
+    if (constraint_system != nullptr) {
+        pk.constraint_system = std::move(*constraint_system);
+    } else {
+        std::istringstream in(
+            std::string((const char *)cs_data, header.constraint_system_size));
+        in.exceptions(
+            std::ios_base::eofbit | std::ios_base::badbit |
+            std::ios_base::failbit);
+        in >> pk.constraint_system;
+    }
+    if (pk.constraint_system.num_inputs() != header.num_inputs ||
+        pk.constraint_system.num_variables() != header.num_variables ||
+        pk.constraint_system.num_constraints() != header.num_constraints) {
+        throw std::invalid_argument(
+            "Keypair file " + filename +
+            " does not match the constraint system");
+    }
+
+    const uint8_t *vk_data = section(header.verification_key_size, 1);
+    {
+        std::istringstream in(
+            std::string((const char *)vk_data, header.verification_key_size));
+        in.exceptions(
+            std::ios_base::eofbit | std::ios_base::badbit |
+            std::ios_base::failbit);
+        in >> keypair.vk;
+    }
+
+    check_well_formed_(keypair.pk, "proving key (read)");
+    check_well_formed_(keypair.vk, "verification key (read)");
+    return keypair;
+}
+
+template<typename ppT>
+static libsnark::r1cs_gg_ppzksnark_keypair<ppT> mapped_keypair_read_file(
+    const std::string &filename,
+    libsnark::r1cs_constraint_system<libff::Fr<ppT>> *constraint_system)
+{
+    mapped_keypair_check_types<ppT>();
+
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(
+            "Cannot open " + filename + ": " + std::string(strerror(errno)));
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::invalid_argument(
+            "Keypair file " + filename + " is empty or cannot be read");
+    }
+
+    void *data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const std::string error(strerror(errno));
+    // The mapping remains valid after the file is closed
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + filename + ": " + error);
+    }
+
+    // The arrays are copied from the start to the end of the file
+    ::madvise(data, st.st_size, MADV_SEQUENTIAL);
+    try {
+        libsnark::r1cs_gg_ppzksnark_keypair<ppT> keypair =
+            mapped_keypair_read_data<ppT>(
+                filename, (const uint8_t *)data, st.st_size, constraint_system);
+        ::munmap(data, st.st_size);
+        return keypair;
+    } catch (...) {
+        ::munmap(data, st.st_size);
+        throw;
+    }
+}
+
+template<typename ppT>
+libsnark::r1cs_gg_ppzksnark_keypair<ppT> mapped_keypair_read(
+    const std::string &filename)
+{
+    return mapped_keypair_read_file<ppT>(filename, nullptr);
+}
+
+template<typename ppT>
+libsnark::r1cs_gg_ppzksnark_keypair<ppT> mapped_keypair_read(
+    const std::string &filename,
+    libsnark::r1cs_constraint_system<libff::Fr<ppT>> &&constraint_system)
+{
+    return mapped_keypair_read_file<ppT>(filename, &constraint_system);
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_SNARKS_GROTH16_MPC_MAPPED_KEYPAIR_TCC__
@@ -751,15 +751,17 @@ bool is_well_formed(const libsnark::r1cs_gg_ppzksnark_proving_key<ppT> &pk)
         return false;
     }
 
-    using knowledge_commitment =
-        libsnark::knowledge_commitment<libff::G2<ppT>, libff::G1<ppT>>;
-    for (const knowledge_commitment &b : pk.B_query.values) {
-        if (!b.g.is_well_formed() || !b.h.is_well_formed()) {
-            return false;
-        }
-    }
-
-    return true;
+    const auto &B_values = pk.B_query.values;
+    return parallel_for_chunks(
+        B_values.size(), 1 << 10, [&B_values](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (!B_values[i].g.is_well_formed() ||
+                    !B_values[i].h.is_well_formed()) {
+                    return false;
+                }
+            }
+            return true;
+        });
 }
 
 template<typename ppT>
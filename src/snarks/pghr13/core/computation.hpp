@@ -9,6 +9,7 @@
 
 #include <libsnark/gadgetlib1/gadget.hpp>
 #include <libsnark/zk_proof_systems/ppzksnark/r1cs_ppzksnark/r1cs_ppzksnark.hpp>
+#include <vector>
 
 namespace libzeth
 {
@@ -18,11 +19,43 @@ libsnark::r1cs_ppzksnark_proof<ppT> gen_proof(
     const libsnark::protoboard<libff::Fr<ppT>> &pb,
     const libsnark::r1cs_ppzksnark_proving_key<ppT> &proving_key);
 template<typename ppT>
+std::vector<libsnark::r1cs_ppzksnark_proof<ppT>> gen_proof_batch(
+    const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+        &primary_inputs,
+    const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+        &auxiliary_inputs,
+    const libsnark::r1cs_ppzksnark_proving_key<ppT> &proving_key);
+template<typename ppT>
 libsnark::r1cs_ppzksnark_keypair<ppT> gen_trusted_setup(
     const libsnark::protoboard<libff::Fr<ppT>> &pb);
+// Verification key with its pairing data precomputed, to be built once per
+// loaded key
+template<typename ppT>
+using processed_verification_key =
+    libsnark::r1cs_ppzksnark_processed_verification_key<ppT>;
+template<typename ppT>
+processed_verification_key<ppT> process_verification_key(
+    const libsnark::r1cs_ppzksnark_verification_key<ppT> &verification_key);
+
 template<typename ppT>
 bool verify(
     const libzeth::extended_proof<ppT> &ext_proof,
+    const processed_verification_key<ppT> &processed_key);
+template<typename ppT>
+bool verify(
+    const libzeth::extended_proof<ppT> &ext_proof,
+    const libsnark::r1cs_ppzksnark_verification_key<ppT> &verification_key);
+
+// Check the proofs of `ext_proofs`, and return whether each one is valid.
+// The proofs are checked one after the other (combined verification is only
+// implemented for GROTH16).
+template<typename ppT>
+std::vector<bool> verify_batch(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
+    const processed_verification_key<ppT> &processed_key);
+template<typename ppT>
+std::vector<bool> verify_batch(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
     const libsnark::r1cs_ppzksnark_verification_key<ppT> &verification_key);
 
 } // namespace libzeth
@@ -5,6 +5,8 @@
 #ifndef __ZETH_COMPUTATION_TCC__
 #define __ZETH_COMPUTATION_TCC__
 
+#include "metrics.hpp"
+
 namespace libzeth
 {
 
@@ -23,13 +25,42 @@ libsnark::r1cs_ppzksnark_proof<ppT> gen_proof(
         pb.auxiliary_input();
 
     // Generate proof from public input, auxiliary input (private/secret data),
-    // and proving key
+    // and proving key. The stages of the libsnark prover are not timed
+    // separately.
+    metrics_timer timer("prover");
     proofT<ppT> proof = libsnark::r1cs_ppzksnark_prover(
         proving_key, primary_input, auxiliary_input);
 
     return proof;
 };
 
+// Generate a batch of proofs for the same circuit. The proofs are generated
+// one after the other (batched multi-exponentiations are only implemented for
+// GROTH16).
+template<typename ppT>
+std::vector<libsnark::r1cs_ppzksnark_proof<ppT>> gen_proof_batch(
+    const std::vector<libsnark::r1cs_primary_input<libff::Fr<ppT>>>
+        &primary_inputs,
+    const std::vector<libsnark::r1cs_auxiliary_input<libff::Fr<ppT>>>
+        &auxiliary_inputs,
+    const libsnark::r1cs_ppzksnark_proving_key<ppT> &proving_key)
+{
+    if (primary_inputs.size() != auxiliary_inputs.size()) {
+        throw std::invalid_argument("input size mismatch (gen_proof_batch)");
+    }
+
+    std::vector<proofT<ppT>> proofs;
+    proofs.reserve(primary_inputs.size());
+    for (size_t i = 0; i < primary_inputs.size(); ++i) {
+        // Timed per proof, as in gen_proof
+        metrics_timer timer("prover");
+        proofs.push_back(libsnark::r1cs_ppzksnark_prover(
+            proving_key, primary_inputs[i], auxiliary_inputs[i]));
+    }
+
+    return proofs;
+};
+
 // Run the trusted setup and returns a struct {proving_key, verifying_key}
 template<typename ppT>
 libsnark::r1cs_ppzksnark_keypair<ppT> gen_trusted_setup(
@@ -44,7 +75,23 @@ libsnark::r1cs_ppzksnark_keypair<ppT> gen_trusted_setup(
     return libsnark::r1cs_ppzksnark_generator<ppT>(pb.get_constraint_system());
 };
 
+template<typename ppT>
+processed_verification_key<ppT> process_verification_key(
+    const libsnark::r1cs_ppzksnark_verification_key<ppT> &verification_key)
+{
+    return libsnark::r1cs_ppzksnark_verifier_process_vk<ppT>(verification_key);
+};
+
 // Verification of a proof
+template<typename ppT>
+bool verify(
+    const libzeth::extended_proof<ppT> &ext_proof,
+    const processed_verification_key<ppT> &processed_key)
+{
+    return libsnark::r1cs_ppzksnark_online_verifier_strong_IC<ppT>(
+        processed_key, ext_proof.get_primary_input(), ext_proof.get_proof());
+};
+
 template<typename ppT>
 bool verify(
     const libzeth::extended_proof<ppT> &ext_proof,
@@ -54,6 +101,30 @@ bool verify(
         verification_key, ext_proof.get_primary_input(), ext_proof.get_proof());
 };
 
+template<typename ppT>
+std::vector<bool> verify_batch(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
+    const processed_verification_key<ppT> &processed_key)
+{
+    metrics_timer timer("verify_batch");
+    std::vector<bool> results;
+    results.reserve(ext_proofs.size());
+    for (const extended_proof<ppT> &ext_proof : ext_proofs) {
+        results.push_back(verify<ppT>(ext_proof, processed_key));
+    }
+
+    return results;
+};
+
+template<typename ppT>
+std::vector<bool> verify_batch(
+    const std::vector<libzeth::extended_proof<ppT>> &ext_proofs,
+    const libsnark::r1cs_ppzksnark_verification_key<ppT> &verification_key)
+{
+    return verify_batch<ppT>(
+        ext_proofs, process_verification_key<ppT>(verification_key));
+};
+
 } // namespace libzeth
 
 #endif // __ZETH_COMPUTATION_TCC__
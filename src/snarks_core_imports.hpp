@@ -11,6 +11,7 @@
 #elif ZKSNARK_GROTH16
 #include "snarks/groth16/core/computation.hpp"
 #include "snarks/groth16/core/helpers.hpp"
+#include "snarks/groth16/mpc/mapped_keypair.hpp"
 #include "snarks/groth16/mpc/mpc_utils.hpp"
 #include "snarks/groth16/mpc/phase2.hpp"
 #else
@@ -0,0 +1,101 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "types/bits.hpp"
+#include "util.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace libzeth;
+
+namespace
+{
+
+TEST(BitsTest, VectorConversion)
+{
+    const std::vector<bool> vect = hex_to_binary_vector(
+        "0f2d00000000000000000000000000000000000000000000000000000000a0b1");
+    const bits256 b = get_bits256_from_vector(vect);
+
+    ASSERT_EQ(vect, get_vector_from_bits256(b));
+    ASSERT_FALSE(b[0]);
+    ASSERT_TRUE(b[4]);
+    ASSERT_TRUE(b[255]);
+    ASSERT_EQ(0x0f2d000000000000ull, b.words()[0]);
+    ASSERT_EQ(0x000000000000a0b1ull, b.words()[3]);
+
+    // Sizes which are not a multiple of 64
+    const std::vector<bool> addr = {1, 0, 1, 1};
+    ASSERT_EQ(addr, get_vector_from_bits_addr(get_bits_addr_from_vector(addr)));
+
+    std::vector<bool> appended = {1};
+    b.append_to_vector(appended);
+    ASSERT_EQ(257u, appended.size());
+    ASSERT_TRUE(appended[0]);
+    ASSERT_EQ(vect, std::vector<bool>(appended.begin() + 1, appended.end()));
+
+    ASSERT_THROW(
+        get_bits256_from_vector(std::vector<bool>(255)), std::length_error);
+}
+
+TEST(BitsTest, SetAndFill)
+{
+    bits32 b;
+    ASSERT_EQ(bits32(), b);
+    b.set(31, true);
+    b.set(0, true);
+    ASSERT_EQ(hex_to_binary_vector("80000001"), get_vector_from_bits32(b));
+    b.set(0, false);
+    ASSERT_EQ(hex_to_binary_vector("00000001"), get_vector_from_bits32(b));
+
+    b.fill(true);
+    ASSERT_EQ(std::vector<bool>(32, true), get_vector_from_bits32(b));
+    ASSERT_EQ(get_bits32_from_vector(std::vector<bool>(32, true)), b);
+}
+
+TEST(BitsTest, Addition)
+{
+    const bits64 a = hex_value_to_bits64("2F0000000000000F");
+    const bits64 b = hex_value_to_bits64("1800000000000008");
+    ASSERT_EQ(
+        hex_value_to_bits64("4700000000000017"), binary_addition<64>(a, b));
+
+    // Carry propagated across words
+    const bits256 c = hex_digest_to_bits256(
+        "00000000000000000000000000000000ffffffffffffffffffffffffffffffff");
+    const bits256 one = hex_digest_to_bits256(
+        "0000000000000000000000000000000000000000000000000000000000000001");
+    ASSERT_EQ(
+        hex_digest_to_bits256(
+            "0000000000000000000000000000000100000000000000000000000000000000"),
+        binary_addition<256>(c, one));
+
+    // Overflow is discarded, or reported when requested
+    const bits32 max32 = get_bits32_from_vector(std::vector<bool>(32, true));
+    const bits32 one32 =
+        get_bits32_from_vector(hex_to_binary_vector("00000001"));
+    ASSERT_EQ(bits32(), binary_addition<32>(max32, one32));
+    ASSERT_THROW(binary_addition<32>(max32, one32, true), std::overflow_error);
+    ASSERT_EQ(max32, binary_addition<32>(max32, bits32(), true));
+    ASSERT_EQ(hex_value_to_bits64("4700000000000017"), sum_bits64(a, b));
+}
+
+TEST(BitsTest, Xor)
+{
+    const bits64 a = hex_value_to_bits64("2F0000000000000F");
+    const bits64 b = hex_value_to_bits64("1800000000000008");
+    ASSERT_EQ(hex_value_to_bits64("3700000000000007"), binary_xor<64>(a, b));
+}
+
+TEST(BitsTest, FromBytes)
+{
+    const std::string digest_hex =
+        "6461f753bfe21ba2219ced74875b8dbd8c114c3c79d7e41306dd82118de1895b";
+    ASSERT_EQ(
+        hex_digest_to_bits256(digest_hex),
+        bits256::from_bytes(hexadecimal_str_to_binary_str(digest_hex)));
+    ASSERT_THROW(bits64::from_bytes(std::string(7, 0)), std::length_error);
+}
+
+} // namespace
@@ -7,6 +7,7 @@
 #include "snarks_alias.hpp"
 
 #include "gtest/gtest.h"
+#include <cstdlib>
 #include <libff/common/default_types/ec_pp.hpp>
 
 // Access the `from_bits` function and other utils
@@ -228,6 +229,76 @@ TEST(TestBlake2sComp, TestTrue)
     ASSERT_EQ(expected.get_bits(pb), output.bits.get_bits(pb));
 }
 
+// Compute the hash of `input` with the gadget
+libff::bit_vector gadget_hash(const libff::bit_vector &input)
+{
+    libsnark::protoboard<FieldT> pb;
+
+    libsnark::block_variable<FieldT> input_block(
+        pb, input.size(), "input_block");
+    libsnark::digest_variable<FieldT> output(pb, BLAKE2s_digest_size, "output");
+    BLAKE2s_256_comp<FieldT> blake2s_comp_gadget(pb, input_block, output);
+
+    input_block.generate_r1cs_witness(input);
+    blake2s_comp_gadget.generate_r1cs_witness();
+    return output.get_digest();
+}
+
+libff::bit_vector random_bits(size_t len)
+{
+    libff::bit_vector bits(len);
+    for (size_t i = 0; i < len; i++) {
+        bits[i] = std::rand() & 1;
+    }
+    return bits;
+}
+
+TEST(TestBlake2sComp, TestGetHash)
+{
+    // blake2s(b"hello world"), as in TestBlake2sComp.TestTrue
+    libff::bit_vector input = hex_to_binary_vector("68656c6c6f20776f726c64");
+    libff::bit_vector expected = hex_digest_to_binary_vector(
+        "9aec6806794561107e594b1f6a8a6b0c92a0cba9acf5e5e93cca06f781813b0b");
+    ASSERT_EQ(expected, BLAKE2s_256_comp<FieldT>::get_hash(input));
+
+    // Compare the native hash against the gadget for various input lengths
+    std::srand(0);
+    for (size_t len : {8, 256, 504, 512}) {
+        libff::bit_vector rand_input = random_bits(len);
+        ASSERT_EQ(
+            gadget_hash(rand_input),
+            BLAKE2s_256_comp<FieldT>::get_hash(rand_input));
+    }
+}
+
+TEST(TestBlake2sComp, TestGetHashBatch)
+{
+    // Use a number of inputs which is not a multiple of the number of lanes
+    const size_t num_inputs = 3 * blake2s_native_lanes() + 1;
+    std::vector<libff::bit_vector> inputs;
+    std::srand(1);
+    for (size_t i = 0; i < num_inputs; i++) {
+        inputs.push_back(random_bits(8 * (i % 65)));
+    }
+
+    std::vector<libff::bit_vector> outputs =
+        BLAKE2s_256_comp<FieldT>::get_hash(inputs);
+    ASSERT_EQ(num_inputs, outputs.size());
+    for (size_t i = 0; i < num_inputs; i++) {
+        ASSERT_EQ(BLAKE2s_256_comp<FieldT>::get_hash(inputs[i]), outputs[i]);
+    }
+
+    // Full-block inputs against the gadget
+    inputs.resize(blake2s_native_lanes());
+    for (auto &input : inputs) {
+        input = random_bits(BLAKE2s_block_size);
+    }
+    outputs = BLAKE2s_256_comp<FieldT>::get_hash(inputs);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        ASSERT_EQ(gadget_hash(inputs[i]), outputs[i]);
+    }
+}
+
 } // namespace
 
 int main(int argc, char **argv)
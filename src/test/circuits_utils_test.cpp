@@ -0,0 +1,184 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "gtest/gtest.h"
+#include <libff/common/default_types/ec_pp.hpp>
+
+#include "circuits/blake2s/blake2s_comp.hpp"
+#include "circuits/circuits-utils.hpp"
+#include "circuits/joinsplit.tcc"
+#include "util.hpp"
+#include "zeth.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#ifdef MULTICORE
+#include <omp.h>
+#endif
+
+using namespace libzeth;
+
+typedef libff::default_ec_pp ppT;
+
+// Should be alt_bn128 in the CMakeLists.txt
+typedef libff::Fr<ppT> FieldT;
+typedef BLAKE2s_256_comp<FieldT> HashT;
+typedef MiMC_mp_gadget<FieldT> HashTreeT;
+
+namespace
+{
+
+TEST(CircuitsUtilsTest, RethrowFirstExceptionAfterAllTasks)
+{
+    const size_t num_tasks = 8;
+    std::atomic<size_t> num_run(0);
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < num_tasks; ++i) {
+        tasks.emplace_back([&num_run, i]() {
+            ++num_run;
+            if (i == 2) {
+                // When run concurrently, task 5 throws first
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                throw std::invalid_argument("task 2");
+            }
+            if (i == 5) {
+                throw std::runtime_error("task 5");
+            }
+        });
+    }
+
+    ASSERT_THROW(
+        generate_witnesses_concurrently(tasks), std::invalid_argument);
+    ASSERT_EQ(num_tasks, num_run.load());
+
+    // Without failure, all tasks run and nothing is thrown
+    num_run = 0;
+    tasks.resize(2);
+    generate_witnesses_concurrently(tasks);
+    ASSERT_EQ(2u, num_run.load());
+}
+
+// Witness of a 2-2 JoinSplit spending a note at address 1 of the tree (see
+// prover_test), checking that it satisfies the constraints.
+std::vector<FieldT> joinsplit_witness()
+{
+    merkle_tree_field<FieldT, HashTreeT> tree(ZETH_MERKLE_TREE_DEPTH);
+
+    bits384 trap_r_bits384 = get_bits384_from_vector(hex_to_binary_vector(
+        "0F000000000000FF00000000000000FF00000000000000FF00000000000000FF00"
+        "000000000000FF00000000000000FF"));
+    bits256 a_sk_bits256 = get_bits256_from_vector(hex_digest_to_binary_vector(
+        "FF0000000000000000000000000000000000000000000000000000000000000F"));
+    bits256 a_pk_bits256 = get_bits256_from_vector(hex_digest_to_binary_vector(
+        "f172d7299ac8ac974ea59413e4a87691826df038ba24a2b52d5c5d15c2cc8c49"));
+    bits256 nf_bits256 = get_bits256_from_vector(hex_digest_to_binary_vector(
+        "ff2f41920346251f6e7c67062149f98bc90c915d3d3020927ca01deab5da0fd7"));
+    FieldT cm_field = FieldT("9047913389147464750130699723564635396506448356890"
+                             "6678810249472230384841563494");
+    const size_t address = 1;
+    tree.set_value(address, cm_field);
+    const std::vector<FieldT> path = tree.get_path(address);
+    const bits_addr address_bits = get_bits_addr_from_vector(
+        address_bits_from_address(address, ZETH_MERKLE_TREE_DEPTH));
+
+    zeth_note note_input(
+        a_pk_bits256,
+        get_bits64_from_vector(hex_to_binary_vector("2F0000000000000F")),
+        get_bits256_from_vector(hex_digest_to_binary_vector(
+            "FFFF0000000000000000000000000000"
+            "00000000000000000000000000009009")),
+        trap_r_bits384);
+    zeth_note note_dummy_input(
+        a_pk_bits256,
+        get_bits64_from_vector(hex_to_binary_vector("0000000000000000")),
+        get_bits256_from_vector(hex_digest_to_binary_vector(
+            "AAAA0000000000000000000000000000"
+            "0000000000000000000000000000EEEE")),
+        trap_r_bits384);
+    std::array<joinsplit_input<FieldT>, 2> inputs;
+    inputs[0] = joinsplit_input<FieldT>(
+        path, address_bits, note_input, a_sk_bits256, nf_bits256);
+    inputs[1] = joinsplit_input<FieldT>(
+        path, address_bits, note_dummy_input, a_sk_bits256, nf_bits256);
+
+    bits256 a_pk_out_bits256 = get_bits256_from_vector(
+        hex_digest_to_binary_vector("7777f753bfe21ba2219ced74875b8dbd8c"
+                                    "114c3c79d7e41306dd82118de1895b"));
+    bits256 rho_out_bits256;
+    bits384 trap_r_out_bits384 = get_bits384_from_vector(hex_to_binary_vector(
+        "11000000000000990000000000000099000000000000007700000000000000FF00"
+        "000000000000FF0000000000000777"));
+    std::array<zeth_note, 2> outputs;
+    outputs[0] = zeth_note(
+        a_pk_out_bits256,
+        get_bits64_from_vector(hex_to_binary_vector("1800000000000008")),
+        rho_out_bits256,
+        trap_r_out_bits384);
+    outputs[1] = zeth_note(
+        a_pk_out_bits256,
+        get_bits64_from_vector(hex_to_binary_vector("0000000000000000")),
+        rho_out_bits256,
+        trap_r_out_bits384);
+
+    libsnark::protoboard<FieldT> pb;
+    joinsplit_gadget<FieldT, HashT, HashTreeT, 2, 2> joinsplit_g(pb);
+    joinsplit_g.generate_r1cs_constraints();
+    joinsplit_g.generate_r1cs_witness(
+        tree.get_root(),
+        inputs,
+        outputs,
+        get_bits64_from_vector(hex_to_binary_vector("0000000000000000")),
+        get_bits64_from_vector(hex_to_binary_vector("1700000000000007")),
+        get_bits256_from_vector(hex_digest_to_binary_vector(
+            "6838aac4d8247655715d3dfb9b32573d"
+            "a2b7d3360ba89ccdaaa7923bb24c99f7")),
+        get_bits256_from_vector(hex_digest_to_binary_vector(
+            "403794c0e20e3bf36b820d8f7aef5505"
+            "e5d1c7ac265d5efbcc3030a74a3f701b")));
+    EXPECT_TRUE(pb.is_satisfied());
+
+    return pb.full_variable_assignment();
+}
+
+TEST(CircuitsUtilsTest, ConcurrentJoinsplitWitnessMatchesSequential)
+{
+    // On a single thread, the witness generation tasks of the JoinSplit run
+    // one after the other, in order. Without MULTICORE, both witnesses are
+    // generated this way.
+#ifdef MULTICORE
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+    const std::vector<FieldT> sequential = joinsplit_witness();
+
+    // Use several threads even on a single core, so that the tasks interleave
+#ifdef MULTICORE
+    omp_set_num_threads(std::max(max_threads, 4));
+#endif
+    const std::vector<FieldT> concurrent = joinsplit_witness();
+#ifdef MULTICORE
+    omp_set_num_threads(max_threads);
+#endif
+
+    ASSERT_EQ(sequential.size(), concurrent.size());
+    for (size_t i = 0; i < sequential.size(); ++i) {
+        ASSERT_EQ(sequential[i], concurrent[i]) << "variable " << i;
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // /!\ WARNING: Do once for all tests. Do not
+    // forget to do this !!!!
+    ppT::init_public_params();
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -115,6 +115,55 @@ TEST(TestHexConvertion, TestHexToFieldBadString)
     ASSERT_FALSE(res);
 };
 
+TEST(TestBytesConvertion, TestBytesToField)
+{
+    const std::string hex =
+        "1fffffffffffffffffffffffffffffffffffffffffffffffffffffffffff0102";
+    const FieldT expected_field_element =
+        libzeth::string_to_field<FieldT>(hex);
+    const std::string bytes = libzeth::hexadecimal_str_to_binary_str(hex);
+
+    ASSERT_EQ(expected_field_element, libzeth::bytes_to_field<FieldT>(bytes));
+    ASSERT_EQ(bytes, libzeth::field_to_bytes(expected_field_element));
+
+    const FieldT element = FieldT::random_element();
+    ASSERT_EQ(
+        element,
+        libzeth::bytes_to_field<FieldT>(libzeth::field_to_bytes(element)));
+};
+
+TEST(TestBytesConvertion, TestBytesToFieldBadString)
+{
+    // Wrong length
+    ASSERT_THROW(
+        libzeth::bytes_to_field<FieldT>(std::string(31, 0)), std::length_error);
+
+    // Not smaller than the modulus
+    ASSERT_THROW(
+        libzeth::bytes_to_field<FieldT>(std::string(32, (char)0xff)),
+        std::invalid_argument);
+};
+
+TEST(TestBytesConvertion, TestBytesToBits)
+{
+    const std::string digest_hex =
+        "6461f753bfe21ba2219ced74875b8dbd8c114c3c79d7e41306dd82118de1895b";
+    ASSERT_EQ(
+        libzeth::hex_digest_to_bits256(digest_hex),
+        libzeth::bytes_digest_to_bits256(
+            libzeth::hexadecimal_str_to_binary_str(digest_hex)));
+
+    const std::string value_hex = "2f0000000000000f";
+    ASSERT_EQ(
+        libzeth::hex_value_to_bits64(value_hex),
+        libzeth::bytes_value_to_bits64(
+            libzeth::hexadecimal_str_to_binary_str(value_hex)));
+
+    ASSERT_THROW(
+        libzeth::bytes_digest_to_bits256(std::string(31, 0)),
+        std::length_error);
+};
+
 } // namespace
 
 int main(int argc, char **argv)
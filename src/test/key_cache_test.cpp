@@ -0,0 +1,72 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libsnark_helpers/key_cache.hpp"
+
+#include "gtest/gtest.h"
+#include <stdexcept>
+
+using namespace libzeth;
+
+namespace
+{
+
+// Keys are strings, whose size is their length
+static size_t string_size(const std::string &key) { return key.size(); }
+
+TEST(KeyCacheTest, LoadOnce)
+{
+    key_cache<std::string> cache(0, string_size);
+    size_t num_loads = 0;
+    const key_cache<std::string>::key_loader load =
+        [&num_loads]() -> std::string {
+        ++num_loads;
+        return std::string("key");
+    };
+
+    ASSERT_FALSE(cache.contains("a"));
+    ASSERT_EQ("key", *cache.get("a", load));
+    ASSERT_EQ("key", *cache.get("a", load));
+    ASSERT_EQ(1u, num_loads);
+    ASSERT_TRUE(cache.contains("a"));
+    ASSERT_EQ(3u, cache.size_in_bytes());
+
+    // Failed loads are not cached
+    const key_cache<std::string>::key_loader failing_load =
+        []() -> std::string { throw std::runtime_error("cannot load"); };
+    ASSERT_THROW(cache.get("b", failing_load), std::runtime_error);
+    ASSERT_FALSE(cache.contains("b"));
+    ASSERT_EQ(1u, cache.num_keys());
+}
+
+TEST(KeyCacheTest, EvictLeastRecentlyUsed)
+{
+    key_cache<std::string> cache(10, string_size);
+    cache.insert("a", "aaaa");
+    cache.insert("b", "bbbb");
+
+    // "a" becomes the most recently used, so "b" is evicted
+    const std::shared_ptr<const std::string> b =
+        cache.get("b", []() { return std::string("bbbb"); });
+    cache.get("a", []() { return std::string("aaaa"); });
+    cache.insert("c", "cccc");
+    ASSERT_TRUE(cache.contains("a"));
+    ASSERT_FALSE(cache.contains("b"));
+    ASSERT_TRUE(cache.contains("c"));
+    ASSERT_EQ(8u, cache.size_in_bytes());
+
+    // Evicted keys remain valid for their users
+    ASSERT_EQ("bbbb", *b);
+
+    // A key larger than the limit evicts all others, but is kept
+    cache.insert("d", "dddddddddddd");
+    ASSERT_EQ(1u, cache.num_keys());
+    ASSERT_TRUE(cache.contains("d"));
+
+    // Replacing a key updates the size
+    cache.insert("d", "dd");
+    ASSERT_EQ(2u, cache.size_in_bytes());
+}
+
+} // namespace
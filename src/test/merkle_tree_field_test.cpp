@@ -0,0 +1,349 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "circuits/mimc/mimc_mp.hpp"
+#include "types/incremental_merkle_tree.hpp"
+#include "types/merkle_tree_field.hpp"
+
+#include "gtest/gtest.h"
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <libff/common/default_types/ec_pp.hpp>
+
+using namespace libzeth;
+
+// Instantiation of the templates for the tests
+typedef libff::default_ec_pp ppT;
+typedef libff::Fr<ppT> FieldT;
+typedef MiMC_mp_gadget<FieldT> HashTreeT;
+
+namespace
+{
+
+const size_t tree_depth = 6;
+
+// Recompute the root from the value at `address` and its authentication path
+FieldT root_from_path(
+    const FieldT &value,
+    const size_t address,
+    const std::vector<FieldT> &path)
+{
+    FieldT node = value;
+    size_t pos = address;
+    for (const FieldT &sibling : path) {
+        node = (pos & 1) ? HashTreeT::get_hash(sibling, node)
+                         : HashTreeT::get_hash(node, sibling);
+        pos = pos / 2;
+    }
+    return node;
+}
+
+template<typename TreeT> void check_paths(const TreeT &tree)
+{
+    for (size_t address = 0; address < (1ul << tree_depth); ++address) {
+        std::vector<FieldT> path = tree.get_path(address);
+        ASSERT_EQ(tree_depth, path.size());
+        ASSERT_EQ(
+            tree.get_root(),
+            root_from_path(tree.get_value(address), address, path));
+    }
+}
+
+TEST(MerkleTreeField, TestEmptyTree)
+{
+    merkle_tree_field<FieldT, HashTreeT> map_tree(tree_depth);
+    merkle_tree_field_array<FieldT, HashTreeT> array_tree(tree_depth);
+
+    ASSERT_EQ(map_tree.hash_defaults[0], map_tree.get_root());
+    ASSERT_EQ(map_tree.get_root(), array_tree.get_root());
+    ASSERT_EQ(FieldT::zero(), array_tree.get_value(3));
+    check_paths(map_tree);
+    check_paths(array_tree);
+}
+
+TEST(MerkleTreeField, TestArrayStorageMatchesMapStorage)
+{
+    merkle_tree_field<FieldT, HashTreeT> map_tree(tree_depth);
+    merkle_tree_field_array<FieldT, HashTreeT> array_tree(tree_depth);
+
+    // Scattered insertions, some of which overwrite previous values
+    const std::vector<size_t> addresses = {5, 0, 63, 12, 5, 1, 40, 63, 2};
+    for (const size_t address : addresses) {
+        const FieldT value = FieldT::random_element();
+        map_tree.set_value(address, value);
+        array_tree.set_value(address, value);
+
+        ASSERT_EQ(map_tree.get_root(), array_tree.get_root());
+        ASSERT_EQ(value, array_tree.get_value(address));
+    }
+
+    for (size_t address = 0; address < (1ul << tree_depth); ++address) {
+        ASSERT_EQ(map_tree.get_value(address), array_tree.get_value(address));
+        ASSERT_EQ(map_tree.get_path(address), array_tree.get_path(address));
+    }
+    check_paths(map_tree);
+    check_paths(array_tree);
+}
+
+TEST(MerkleTreeField, TestConstructorsMatchSetValue)
+{
+    std::vector<FieldT> contents_as_vector;
+    std::map<size_t, FieldT> contents;
+    merkle_tree_field<FieldT, HashTreeT> expected_tree(tree_depth);
+    for (size_t address = 0; address < 11; ++address) {
+        const FieldT value = FieldT::random_element();
+        contents_as_vector.push_back(value);
+        contents[3 * address + 1] = value;
+        expected_tree.set_value(address, value);
+    }
+
+    merkle_tree_field<FieldT, HashTreeT> map_tree(
+        tree_depth, contents_as_vector);
+    merkle_tree_field_array<FieldT, HashTreeT> array_tree(
+        tree_depth, contents_as_vector);
+    ASSERT_EQ(expected_tree.get_root(), map_tree.get_root());
+    ASSERT_EQ(expected_tree.get_root(), array_tree.get_root());
+    ASSERT_EQ(contents_as_vector[7], array_tree.get_value(7));
+    check_paths(array_tree);
+
+    merkle_tree_field<FieldT, HashTreeT> expected_sparse_tree(tree_depth);
+    for (const auto &entry : contents) {
+        expected_sparse_tree.set_value(entry.first, entry.second);
+    }
+
+    merkle_tree_field<FieldT, HashTreeT> map_sparse_tree(tree_depth, contents);
+    merkle_tree_field_array<FieldT, HashTreeT> array_sparse_tree(
+        tree_depth, contents);
+    ASSERT_EQ(expected_sparse_tree.get_root(), map_sparse_tree.get_root());
+    ASSERT_EQ(expected_sparse_tree.get_root(), array_sparse_tree.get_root());
+    check_paths(map_sparse_tree);
+}
+
+TEST(MerkleTreeField, TestBulkConstruction)
+{
+    // Odd number of leaves (missing right children on most layers) and full
+    // tree
+    for (const size_t num_leaves : {37ul, 1ul << tree_depth}) {
+        std::vector<FieldT> contents_as_vector;
+        merkle_tree_field_array<FieldT, HashTreeT> expected_tree(tree_depth);
+        for (size_t address = 0; address < num_leaves; ++address) {
+            contents_as_vector.push_back(FieldT::random_element());
+            expected_tree.set_value(address, contents_as_vector.back());
+        }
+
+        merkle_tree_field<FieldT, HashTreeT> map_tree(
+            tree_depth, contents_as_vector);
+        merkle_tree_field_array<FieldT, HashTreeT> array_tree(
+            tree_depth, contents_as_vector);
+        ASSERT_EQ(expected_tree.get_root(), map_tree.get_root());
+        ASSERT_EQ(expected_tree.get_root(), array_tree.get_root());
+        for (size_t address = 0; address < (1ul << tree_depth); ++address) {
+            ASSERT_EQ(
+                expected_tree.get_path(address), map_tree.get_path(address));
+            ASSERT_EQ(
+                expected_tree.get_path(address), array_tree.get_path(address));
+        }
+    }
+}
+
+TEST(MerkleTreeField, TestSetValues)
+{
+    merkle_tree_field<FieldT, HashTreeT> expected_tree(tree_depth);
+    merkle_tree_field<FieldT, HashTreeT> map_tree(tree_depth);
+    merkle_tree_field_array<FieldT, HashTreeT> array_tree(tree_depth);
+
+    // A block of consecutive leaves, as appended by a single Ethereum block
+    std::vector<FieldT> block_values;
+    for (size_t i = 0; i < 9; ++i) {
+        block_values.push_back(FieldT::random_element());
+        expected_tree.set_value(13 + i, block_values.back());
+    }
+    map_tree.set_values(13, block_values);
+    array_tree.set_values(13, block_values);
+    ASSERT_EQ(expected_tree.get_root(), map_tree.get_root());
+    ASSERT_EQ(expected_tree.get_root(), array_tree.get_root());
+
+    // Scattered leaves, overwriting some of the previous ones
+    std::map<size_t, FieldT> values;
+    for (const size_t address : {0, 1, 14, 15, 40, 63}) {
+        values[address] = FieldT::random_element();
+        expected_tree.set_value(address, values[address]);
+    }
+    map_tree.set_values(values);
+    array_tree.set_values(values);
+    ASSERT_EQ(expected_tree.get_root(), map_tree.get_root());
+    ASSERT_EQ(expected_tree.get_root(), array_tree.get_root());
+
+    for (size_t address = 0; address < (1ul << tree_depth); ++address) {
+        ASSERT_EQ(expected_tree.get_path(address), map_tree.get_path(address));
+        ASSERT_EQ(
+            expected_tree.get_path(address), array_tree.get_path(address));
+    }
+}
+
+TEST(MerkleTreeField, TestMmapStorage)
+{
+    typedef merkle_tree_field_mmap<FieldT, HashTreeT> mmap_treeT;
+    const std::string filename = "/tmp/zeth_test_merkle_tree_field_mmap.bin";
+    std::remove(filename.c_str());
+
+    merkle_tree_field_array<FieldT, HashTreeT> expected_tree(tree_depth);
+    {
+        mmap_treeT tree(merkle_tree_mmap_storage<FieldT>(
+            filename, mmap_treeT::compute_hash_defaults(tree_depth)));
+        ASSERT_EQ(expected_tree.get_root(), tree.get_root());
+
+        for (size_t address = 0; address < 21; ++address) {
+            const FieldT value = FieldT::random_element();
+            tree.set_value(address, value);
+            expected_tree.set_value(address, value);
+        }
+        ASSERT_EQ(expected_tree.get_root(), tree.get_root());
+        tree.nodes.flush();
+        ASSERT_EQ(21ul, tree.nodes.committed_leaves());
+    }
+
+    // Reopen the file: the tree is mapped as is, without rehashing
+    {
+        mmap_treeT tree{merkle_tree_mmap_storage<FieldT>(filename)};
+        ASSERT_EQ(tree_depth, tree.depth);
+        ASSERT_EQ(expected_tree.hash_defaults, tree.hash_defaults);
+        ASSERT_EQ(expected_tree.get_root(), tree.get_root());
+        for (size_t address = 0; address < (1ul << tree_depth); ++address) {
+            ASSERT_EQ(expected_tree.get_path(address), tree.get_path(address));
+        }
+
+        // The parameters of the tree are checked against the file
+        ASSERT_THROW(
+            merkle_tree_mmap_storage<FieldT>(
+                filename, mmap_treeT::compute_hash_defaults(tree_depth + 1)),
+            std::invalid_argument);
+    }
+
+    std::remove(filename.c_str());
+}
+
+TEST(MerkleTreeField, TestMmapStorageRecovery)
+{
+    typedef merkle_tree_field_mmap<FieldT, HashTreeT> mmap_treeT;
+    const std::string filename = "/tmp/zeth_test_merkle_tree_field_crash.bin";
+    const std::string snapshot = filename + ".snapshot";
+    std::remove(filename.c_str());
+    std::remove(snapshot.c_str());
+
+    const size_t num_committed = 21;
+    merkle_tree_field_array<FieldT, HashTreeT> expected_tree(tree_depth);
+    {
+        mmap_treeT tree(merkle_tree_mmap_storage<FieldT>(
+            filename, mmap_treeT::compute_hash_defaults(tree_depth)));
+        for (size_t address = 0; address < num_committed; ++address) {
+            const FieldT value = FieldT::random_element();
+            tree.set_value(address, value);
+            expected_tree.set_value(address, value);
+        }
+        tree.nodes.flush();
+
+        // Append leaves without committing them. This overwrites the
+        // right-most committed node of each layer in the file.
+        for (size_t address = num_committed; address < num_committed + 10;
+             ++address) {
+            tree.set_value(address, FieldT::random_element());
+        }
+        ASSERT_NE(expected_tree.get_root(), tree.get_root());
+
+        // Snapshot the file as left by a crash at this point (the mapping is
+        // shared, so the copy sees the uncommitted nodes)
+        boost::filesystem::copy_file(filename, snapshot);
+    }
+
+    // The snapshot is restored to the last commit
+    {
+        mmap_treeT tree{merkle_tree_mmap_storage<FieldT>(snapshot)};
+        ASSERT_EQ(num_committed, tree.nodes.committed_leaves());
+        ASSERT_EQ(expected_tree.get_root(), tree.get_root());
+        for (size_t address = 0; address < (1ul << tree_depth); ++address) {
+            ASSERT_EQ(expected_tree.get_path(address), tree.get_path(address));
+        }
+
+        // Appending after recovery ignores the stale nodes of the file
+        for (size_t address = num_committed; address < num_committed + 5;
+             ++address) {
+            const FieldT value = FieldT::random_element();
+            tree.set_value(address, value);
+            expected_tree.set_value(address, value);
+        }
+        ASSERT_EQ(expected_tree.get_root(), tree.get_root());
+        for (size_t address = 0; address < (1ul << tree_depth); ++address) {
+            ASSERT_EQ(expected_tree.get_path(address), tree.get_path(address));
+        }
+    }
+
+    std::remove(filename.c_str());
+    std::remove(snapshot.c_str());
+}
+
+TEST(IncrementalMerkleTree, TestMatchesMerkleTreeField)
+{
+    merkle_tree_field_array<FieldT, HashTreeT> expected_tree(tree_depth);
+    incremental_merkle_tree<FieldT, HashTreeT> tree(tree_depth);
+    ASSERT_EQ(expected_tree.get_root(), tree.get_root());
+
+    // Fill the tree, tracking some of the leaves along the way
+    for (size_t address = 0; address < (1ul << tree_depth); ++address) {
+        const FieldT value = FieldT::random_element();
+        expected_tree.set_value(address, value);
+        ASSERT_EQ(address, tree.append(value));
+        ASSERT_EQ(address + 1, tree.size());
+        ASSERT_EQ(expected_tree.get_root(), tree.get_root());
+
+        if (address % 5 == 0 || address == 6 || address == 31) {
+            tree.track(address);
+        }
+
+        for (size_t tracked = 0; tracked <= address; ++tracked) {
+            if (tree.is_tracked(tracked)) {
+                ASSERT_EQ(
+                    expected_tree.get_value(tracked), tree.get_value(tracked));
+                ASSERT_EQ(
+                    expected_tree.get_path(tracked), tree.get_path(tracked));
+            }
+        }
+    }
+
+    ASSERT_THROW(tree.append(FieldT::one()), std::overflow_error);
+}
+
+TEST(IncrementalMerkleTree, TestTrackedLeaves)
+{
+    incremental_merkle_tree<FieldT, HashTreeT> tree(tree_depth);
+    ASSERT_THROW(tree.track(0), std::invalid_argument);
+
+    tree.append(FieldT("12"));
+    tree.append(FieldT("34"));
+    ASSERT_THROW(tree.track(0), std::invalid_argument);
+    ASSERT_THROW(tree.get_path(1), std::invalid_argument);
+
+    tree.track(1);
+    ASSERT_TRUE(tree.is_tracked(1));
+    ASSERT_EQ(FieldT("34"), tree.get_value(1));
+
+    tree.append(FieldT("56"));
+    ASSERT_EQ(
+        tree.get_root(), root_from_path(FieldT("34"), 1, tree.get_path(1)));
+
+    tree.untrack(1);
+    ASSERT_FALSE(tree.is_tracked(1));
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // /!\ WARNING: Do once for all tests. Do not
+    // forget to do this !!!!
+    ppT::init_public_params();
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
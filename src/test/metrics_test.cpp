@@ -0,0 +1,57 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "metrics.hpp"
+
+#include "gtest/gtest.h"
+#include <sstream>
+
+using namespace libzeth;
+
+namespace
+{
+
+TEST(MetricsTest, Histogram)
+{
+    metrics_histogram histogram;
+    histogram.observe(0.0001);
+    histogram.observe(0.001);
+    histogram.observe(0.003);
+    histogram.observe(100.0);
+
+    const std::array<uint64_t, 16> cumulative = histogram.cumulative_counts();
+    ASSERT_EQ(2u, cumulative[0]);
+    ASSERT_EQ(2u, cumulative[1]);
+    ASSERT_EQ(3u, cumulative[2]);
+    ASSERT_EQ(3u, cumulative[14]);
+    ASSERT_EQ(4u, cumulative[15]);
+    ASSERT_EQ(4u, histogram.count());
+    ASSERT_DOUBLE_EQ(100.0041, histogram.sum());
+}
+
+TEST(MetricsTest, TimersAndCounters)
+{
+    {
+        metrics_timer timer("test_stage");
+        timer.stop();
+        // Stopping again (or destroying the timer) records nothing more
+        timer.stop();
+    }
+    metrics::global().increment("test_events");
+    metrics::global().increment("test_events", 2);
+
+    std::stringstream ss;
+    metrics::global().write(ss);
+    const std::string text = ss.str();
+    ASSERT_NE(
+        std::string::npos,
+        text.find("zeth_stage_seconds_count{stage=\"test_stage\"} 1\n"));
+    ASSERT_NE(
+        std::string::npos,
+        text.find("zeth_stage_seconds_bucket{stage=\"test_stage\",le=\"+Inf\"} "
+                  "1\n"));
+    ASSERT_NE(std::string::npos, text.find("zeth_test_events_total 3\n"));
+}
+
+} // namespace
@@ -181,6 +181,8 @@ TEST(TestMiMCMp, TestTrue)
     FieldT expected_out = FieldT("167979224495559946840631042142333962005996937"
                                  "15764605878168345782964540311877");
     ASSERT_TRUE(expected_out == pb.val(mimc_mp_gadget.result()));
+    ASSERT_EQ(
+        MiMC_mp_gadget<FieldT>::expected_constraints(), pb.num_constraints());
 }
 
 TEST(TestMiMCMp, TestFalse)
@@ -212,6 +214,81 @@ TEST(TestMiMCMp, TestFalse)
     ASSERT_FALSE(unexpected_out == pb.val(mimc_mp_gadget.result()));
 }
 
+TEST(TestMiMCPerm, TestNativeMatchesGadget)
+{
+    const FieldT x = FieldT("37031414935355631796575317199601601742960852086719"
+                            "19316200479060314459804651");
+    const FieldT k = FieldT("15683951496311901749339509118960676303290224812129"
+                            "752890706581988986633412003");
+
+    // Native permutation on the values used in TestMiMCPerm.TestTrue
+    const FieldT expected_out =
+        FieldT("192990723315478049773124691205698348115617480"
+               "95378968014959488920239255590840");
+    ASSERT_TRUE(
+        expected_out == MiMCe7_permutation_gadget<FieldT>::permute(x, k));
+
+    // Compare against the gadget on random values
+    for (size_t i = 0; i < 8; ++i) {
+        const FieldT rand_x = FieldT::random_element();
+        const FieldT rand_k = FieldT::random_element();
+
+        libsnark::protoboard<FieldT> pb;
+        libsnark::pb_variable<FieldT> in_x;
+        libsnark::pb_variable<FieldT> in_k;
+        in_x.allocate(pb, "x");
+        in_k.allocate(pb, "k");
+        pb.val(in_x) = rand_x;
+        pb.val(in_k) = rand_k;
+
+        MiMCe7_permutation_gadget<FieldT> mimc_gadget(
+            pb, in_x, in_k, "mimc_gadget");
+        mimc_gadget.generate_r1cs_constraints();
+        mimc_gadget.generate_r1cs_witness();
+
+        ASSERT_TRUE(pb.is_satisfied());
+        ASSERT_TRUE(
+            pb.val(mimc_gadget.result()) ==
+            MiMCe7_permutation_gadget<FieldT>::permute(rand_x, rand_k));
+    }
+}
+
+TEST(TestMiMCMp, TestGetHashMatchesGadget)
+{
+    // Native hash on the values used in TestMiMCMp.TestTrue
+    const FieldT x = FieldT("37031414935355631796575317199601601742960852086719"
+                            "19316200479060314459804651");
+    const FieldT y = FieldT("15683951496311901749339509118960676303290224812129"
+                            "752890706581988986633412003");
+    const FieldT expected_out =
+        FieldT("167979224495559946840631042142333962005996937"
+               "15764605878168345782964540311877");
+    ASSERT_TRUE(expected_out == MiMC_mp_gadget<FieldT>::get_hash(x, y));
+
+    // Compare against the gadget on random values
+    for (size_t i = 0; i < 8; ++i) {
+        const FieldT rand_x = FieldT::random_element();
+        const FieldT rand_y = FieldT::random_element();
+
+        libsnark::protoboard<FieldT> pb;
+        libsnark::pb_variable<FieldT> in_x;
+        libsnark::pb_variable<FieldT> in_y;
+        in_x.allocate(pb, "x");
+        in_y.allocate(pb, "y");
+        pb.val(in_x) = rand_x;
+        pb.val(in_y) = rand_y;
+
+        MiMC_mp_gadget<FieldT> mimc_mp_gadget(pb, in_x, in_y, "gadget");
+        mimc_mp_gadget.generate_r1cs_constraints();
+        mimc_mp_gadget.generate_r1cs_witness();
+
+        ASSERT_TRUE(pb.is_satisfied());
+        ASSERT_TRUE(
+            pb.val(mimc_mp_gadget.result()) ==
+            MiMC_mp_gadget<FieldT>::get_hash(rand_x, rand_y));
+    }
+}
+
 } // namespace
 
 int main(int argc, char **argv)
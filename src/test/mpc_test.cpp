@@ -6,6 +6,7 @@
 #include "circuits/sha256/sha256_ethereum.hpp"
 #include "snarks/groth16/mpc/chacha_rng.hpp"
 #include "snarks/groth16/mpc/evaluator_from_lagrange.hpp"
+#include "snarks/groth16/mpc/mapped_keypair.hpp"
 #include "snarks/groth16/mpc/mpc_utils.hpp"
 #include "snarks/groth16/mpc/multi_exp.hpp"
 #include "snarks/groth16/mpc/phase2.hpp"
@@ -13,6 +14,7 @@
 #include "test/simple_test.hpp"
 #include "util.hpp"
 
+#include <cstdio>
 #include <fstream>
 #include <gtest/gtest.h>
 #include <thread>
@@ -466,6 +468,74 @@ TEST(MPCTests, KeyPairReadWrite)
     ASSERT_EQ(keypair.vk, keypair_deserialized.vk);
 }
 
+TEST(MPCTests, KeyPairMappedReadWrite)
+{
+    r1cs_constraint_system<Fr> constraint_system =
+        get_simple_constraint_system();
+    qap_instance<Fr> qap = r1cs_to_qap_instance_map(constraint_system, true);
+    srs_powersoftau<ppT> pot = dummy_powersoftau<ppT>(qap.degree());
+    const srs_lagrange_evaluations<ppT> lagrange =
+        powersoftau_compute_lagrange_evaluations(pot, qap.degree());
+    srs_mpc_layer_L1<ppT> layer1 =
+        mpc_compute_linearcombination<ppT>(pot, lagrange, qap);
+    const Fr delta = Fr::random_element();
+    srs_mpc_phase2_accumulator<ppT> phase2 =
+        srs_mpc_dummy_phase2<ppT>(layer1, delta, qap.num_inputs()).accumulator;
+    const r1cs_gg_ppzksnark_keypair<ppT> keypair = mpc_create_key_pair(
+        std::move(pot),
+        std::move(layer1),
+        std::move(phase2),
+        r1cs_constraint_system<Fr>(constraint_system),
+        qap);
+
+    const std::string filename = "/tmp/zeth_test_mpc_keypair_mapped.bin";
+    mapped_keypair_write(keypair, filename);
+    ASSERT_TRUE(mapped_keypair_is_mapped_file(filename));
+
+    const r1cs_gg_ppzksnark_keypair<ppT> keypair_read =
+        mapped_keypair_read<ppT>(filename);
+    ASSERT_EQ(keypair.pk, keypair_read.pk);
+    ASSERT_EQ(keypair.vk, keypair_read.vk);
+
+    // Constraint system provided by the caller
+    const r1cs_gg_ppzksnark_keypair<ppT> keypair_read_cs =
+        mapped_keypair_read<ppT>(
+            filename, r1cs_constraint_system<Fr>(constraint_system));
+    ASSERT_EQ(keypair.pk, keypair_read_cs.pk);
+
+    // Stream-format files are rejected
+    {
+        std::ofstream out(filename, std::ios_base::binary | std::ios_base::out);
+        mpc_write_keypair(out, keypair);
+    }
+    ASSERT_FALSE(mapped_keypair_is_mapped_file(filename));
+    ASSERT_THROW(mapped_keypair_read<ppT>(filename), std::invalid_argument);
+
+    std::remove(filename.c_str());
+}
+
+TEST(MPCTests, ContainerIsWellFormed)
+{
+    // Spans several chunks, the last of which is partial
+    const size_t num_points = 1000;
+    const size_t chunk_size = 64;
+    libff::G1_vector<ppT> points(num_points);
+    for (size_t i = 0; i < num_points; ++i) {
+        points[i] = Fr(i + 1) * G1::one();
+    }
+    ASSERT_TRUE(container_is_well_formed(points, chunk_size));
+
+    // (1, 3) is not on the curve
+    const G1 invalid(
+        libff::Fq<ppT>(1), libff::Fq<ppT>(3), libff::Fq<ppT>::one());
+    for (const size_t i : {0ul, 63ul, 64ul, 500ul, num_points - 1}) {
+        libff::G1_vector<ppT> tampered = points;
+        tampered[i] = invalid;
+        ASSERT_FALSE(container_is_well_formed(tampered, chunk_size))
+            << "i = " << std::to_string(i);
+    }
+}
+
 TEST(MPCTests, Phase2PublicKeyReadWrite)
 {
     srs_mpc_hash_t empty_hash;
@@ -0,0 +1,163 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "circuits/mimc/mimc_mp.hpp"
+#include "circuits/poseidon/poseidon.hpp"
+
+#include "gtest/gtest.h"
+#include <libff/common/default_types/ec_pp.hpp>
+
+using namespace libzeth;
+
+typedef libff::default_ec_pp ppT;
+typedef libff::Fr<ppT> FieldT;
+
+// The expected values are the published test vectors of the reference
+// implementation of Poseidon (poseidonperm_x5_254_3 in
+// https://extgit.iaik.tugraz.at/krypto/hadeshash, code/test_vectors.txt),
+// which are also the hashes of circomlib.
+
+namespace
+{
+
+TEST(TestPoseidon, TestPermutation)
+{
+    // Permutation of [0, 1, 2]:
+    //   0x115cc0f5e7d690413df64c6b9662e9cf2a3617f2743245519e19607a4417189a
+    //   0x0fca49b798923ab0239de1c9e7a4a9a2210312b6a2f616d18b5a87f9b628ae29
+    //   0x0e7ae82e40091e63cbd4f16a6d16310b3729d4b6e138fcf54110e2867045a30c
+    const Poseidon_gadget<FieldT>::state input = {
+        FieldT::zero(), FieldT("1"), FieldT("2")};
+    const Poseidon_gadget<FieldT>::state expected = {
+        FieldT("785320012077606287868479836409507245881502937609273200924941"
+               "4926327459813530"),
+        FieldT("714210461305540881791196210031680886644837844347450365999247"
+               "8482890339429929"),
+        FieldT("654953767412243231177778959804310787000213748485012642916050"
+               "7761192163713804")};
+    ASSERT_TRUE(expected == Poseidon_gadget<FieldT>::permute(input));
+}
+
+TEST(TestPoseidon, TestTrue)
+{
+    libsnark::protoboard<FieldT> pb;
+
+    // Public input
+    libsnark::pb_variable<FieldT> y;
+    y.allocate(pb, "y");
+    pb.set_input_sizes(1);
+    pb.val(y) = FieldT("2");
+
+    // Private inputs
+    libsnark::pb_variable<FieldT> x;
+    x.allocate(pb, "x");
+    pb.val(x) = FieldT("1");
+
+    Poseidon_gadget<FieldT> poseidon_gadget(pb, x, y, "gadget");
+    poseidon_gadget.generate_r1cs_witness();
+    poseidon_gadget.generate_r1cs_constraints();
+
+    // First element of the permutation of [0, 1, 2]
+    FieldT expected_out = FieldT("78532001207760628786847983640950724588150"
+                                 "29376092732009249414926327459813530");
+    ASSERT_TRUE(expected_out == pb.val(poseidon_gadget.result()));
+    ASSERT_TRUE(pb.is_satisfied());
+    ASSERT_EQ(
+        Poseidon_gadget<FieldT>::expected_constraints(), pb.num_constraints());
+}
+
+TEST(TestPoseidon, TestFalse)
+{
+    libsnark::protoboard<FieldT> pb;
+
+    // Public input
+    libsnark::pb_variable<FieldT> y;
+    y.allocate(pb, "y");
+    pb.set_input_sizes(1);
+    pb.val(y) = FieldT("3");
+
+    // Private inputs
+    libsnark::pb_variable<FieldT> x;
+    x.allocate(pb, "x");
+    pb.val(x) = FieldT("1");
+
+    Poseidon_gadget<FieldT> poseidon_gadget(pb, x, y, "gadget");
+    poseidon_gadget.generate_r1cs_witness();
+    poseidon_gadget.generate_r1cs_constraints();
+
+    FieldT unexpected_out = FieldT("78532001207760628786847983640950724588150"
+                                   "29376092732009249414926327459813530");
+    ASSERT_FALSE(unexpected_out == pb.val(poseidon_gadget.result()));
+
+    // Changing an input after witness generation breaks the constraints
+    pb.val(y) = FieldT("2");
+    ASSERT_FALSE(pb.is_satisfied());
+}
+
+TEST(TestPoseidon, TestGetHash)
+{
+    // Hash of [1, 2] (circomlib), and of [0, 0]
+    //   0x2098f5fb9e239eab3ceac3f27b81e481dc3124d55ffed523a839ee8446b64864
+    ASSERT_TRUE(
+        FieldT("78532001207760628786847983640950724588150293760927320092494"
+               "14926327459813530") ==
+        Poseidon_gadget<FieldT>::get_hash(FieldT("1"), FieldT("2")));
+    ASSERT_TRUE(
+        FieldT("14744269619966411208579211824598458697587494354926760081771"
+               "325075741142829156") ==
+        Poseidon_gadget<FieldT>::get_hash(FieldT::zero(), FieldT::zero()));
+
+    // The hash is not symmetric, so that the Merkle tree commits to the
+    // position of the nodes
+    ASSERT_FALSE(
+        Poseidon_gadget<FieldT>::get_hash(FieldT("1"), FieldT("2")) ==
+        Poseidon_gadget<FieldT>::get_hash(FieldT("2"), FieldT("1")));
+}
+
+TEST(TestPoseidon, TestGetHashMatchesGadget)
+{
+    // Compare against the gadget on random values
+    for (size_t i = 0; i < 8; ++i) {
+        const FieldT rand_x = FieldT::random_element();
+        const FieldT rand_y = FieldT::random_element();
+
+        libsnark::protoboard<FieldT> pb;
+        libsnark::pb_variable<FieldT> in_x;
+        libsnark::pb_variable<FieldT> in_y;
+        in_x.allocate(pb, "x");
+        in_y.allocate(pb, "y");
+        pb.val(in_x) = rand_x;
+        pb.val(in_y) = rand_y;
+
+        Poseidon_gadget<FieldT> poseidon_gadget(pb, in_x, in_y, "gadget");
+        poseidon_gadget.generate_r1cs_constraints();
+        poseidon_gadget.generate_r1cs_witness();
+
+        ASSERT_TRUE(pb.is_satisfied());
+        ASSERT_TRUE(
+            pb.val(poseidon_gadget.result()) ==
+            Poseidon_gadget<FieldT>::get_hash(rand_x, rand_y));
+    }
+}
+
+TEST(TestPoseidon, TestFewerConstraintsThanMiMC)
+{
+    // 3 * (8 * 3 + 57) + 1, against 4 * 91 + 1 for MiMC_mp_gadget
+    ASSERT_EQ(244u, Poseidon_gadget<FieldT>::expected_constraints());
+    ASSERT_LT(
+        Poseidon_gadget<FieldT>::expected_constraints(),
+        MiMC_mp_gadget<FieldT>::expected_constraints());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // /!\ WARNING: Do once for all tests. Do not
+    // forget to do this !!!!
+    ppT::init_public_params();
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
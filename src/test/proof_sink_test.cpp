@@ -0,0 +1,164 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#include "libsnark_helpers/proof_sink.hpp"
+#include "metrics.hpp"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <fstream>
+#include <libff/common/default_types/ec_pp.hpp>
+#include <sstream>
+
+using namespace libzeth;
+
+typedef libff::default_ec_pp ppT;
+typedef libff::Fr<ppT> FieldT;
+
+namespace
+{
+
+// A proof whose single primary input is `value`, to tell proofs apart
+extended_proof<ppT> make_proof(size_t value)
+{
+    proofT<ppT> proof;
+    libsnark::r1cs_primary_input<FieldT> inputs{FieldT(value)};
+    return extended_proof<ppT>(proof, inputs);
+}
+
+// Empty directory, removed by the destructor
+class temp_directory
+{
+public:
+    const boost::filesystem::path path;
+
+    temp_directory()
+        : path(
+              boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path("zeth_proof_sink_%%%%%%%%"))
+    {
+        boost::filesystem::create_directories(path);
+    }
+
+    ~temp_directory() { boost::filesystem::remove_all(path); }
+
+    std::vector<std::string> file_names() const
+    {
+        std::vector<std::string> names;
+        for (const boost::filesystem::directory_entry &entry :
+             boost::filesystem::directory_iterator(path)) {
+            names.push_back(entry.path().filename().string());
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+};
+
+TEST(ProofSinkTest, RingOrderingAndWraparound)
+{
+    ring_buffer_proof_sink<ppT> sink(3);
+    sink.push(make_proof(0));
+    sink.push(make_proof(1));
+
+    // Not full yet
+    std::vector<extended_proof<ppT>> recent = sink.recent_proofs();
+    ASSERT_EQ(2u, recent.size());
+    ASSERT_EQ(FieldT(0), recent[0].get_primary_input()[0]);
+    ASSERT_EQ(FieldT(1), recent[1].get_primary_input()[0]);
+
+    // After wrapping around, the 3 most recent proofs are kept, oldest first
+    for (size_t i = 2; i < 8; ++i) {
+        sink.push(make_proof(i));
+    }
+    recent = sink.recent_proofs();
+    ASSERT_EQ(3u, recent.size());
+    ASSERT_EQ(FieldT(5), recent[0].get_primary_input()[0]);
+    ASSERT_EQ(FieldT(6), recent[1].get_primary_input()[0]);
+    ASSERT_EQ(FieldT(7), recent[2].get_primary_input()[0]);
+    ASSERT_EQ(8u, sink.num_pushed());
+
+    ASSERT_THROW(ring_buffer_proof_sink<ppT>(0), std::invalid_argument);
+}
+
+TEST(ProofSinkTest, RingWriteRecentProofs)
+{
+    temp_directory dir;
+    ring_buffer_proof_sink<ppT> sink(2, dir.path);
+    for (size_t i = 0; i < 5; ++i) {
+        sink.push(make_proof(i));
+    }
+
+    // Files are named after the number of proofs pushed before each one
+    ASSERT_EQ(2u, sink.write_recent_proofs());
+    const std::string prefix = "recent_proof_" + proof_sink_run_id() + "_";
+    const std::vector<std::string> expected{prefix + "3.json",
+                                            prefix + "4.json"};
+    ASSERT_EQ(expected, dir.file_names());
+}
+
+TEST(ProofSinkTest, FileSinkCountsDropped)
+{
+    temp_directory dir;
+    {
+        // No room for pending proofs, so that all proofs are dropped
+        file_proof_sink<ppT> sink(dir.path, 0);
+        sink.push(make_proof(0));
+        sink.push(make_proof(1));
+        sink.push(make_proof(2));
+        ASSERT_EQ(3u, sink.num_dropped());
+    }
+    ASSERT_TRUE(dir.file_names().empty());
+
+    std::stringstream ss;
+    metrics::global().write(ss);
+    ASSERT_NE(
+        std::string::npos, ss.str().find("zeth_dropped_proofs_total 3\n"));
+}
+
+TEST(ProofSinkTest, FileSinkDrainsOnDestruction)
+{
+    temp_directory dir;
+
+    // A file left by a previous run must not be overwritten
+    const boost::filesystem::path previous =
+        dir.path / "proof_and_inputs_0.json";
+    {
+        std::ofstream out(previous.string());
+        out << "previous run";
+    }
+
+    {
+        file_proof_sink<ppT> sink(dir.path, 64);
+        for (size_t i = 0; i < 10; ++i) {
+            sink.push(make_proof(i));
+        }
+        // All pending proofs are written before the destructor returns
+    }
+
+    const std::string prefix =
+        "proof_and_inputs_" + proof_sink_run_id() + "_";
+    std::vector<std::string> expected{"proof_and_inputs_0.json"};
+    for (size_t i = 0; i < 10; ++i) {
+        expected.push_back(prefix + std::to_string(i) + ".json");
+    }
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(expected, dir.file_names());
+
+    std::ifstream in(previous.string());
+    std::string content;
+    std::getline(in, content);
+    ASSERT_EQ("previous run", content);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    // /!\ WARNING: Do once for all tests. Do not
+    // forget to do this !!!!
+    ppT::init_public_params();
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
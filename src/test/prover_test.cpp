@@ -717,6 +717,83 @@ bool TestInvalidJS2In2(
     return res;
 }
 
+// Generate the witness of a joinsplit spending a note which is not in the
+// merkle tree: the joinsplit is balanced, but the constraint system is not
+// satisfied (the roots computed from the two inputs differ).
+void TestUnsatisfiedJS2In2(
+    circuit_wrapper<FieldT, HashT, HashTreeT, ppT, 2, 2> &prover,
+    libzeth::keyPairT<ppT> keypair)
+{
+    libff::print_header("test JS 2-2: input note not in the merkle tree");
+
+    std::unique_ptr<merkle_tree_field<FieldT, HashTreeT>> test_merkle_tree =
+        std::unique_ptr<merkle_tree_field<FieldT, HashTreeT>>(
+            new merkle_tree_field<FieldT, HashTreeT>(
+                ZETH_MERKLE_TREE_DEPTH_TEST));
+
+    bits384 trap_r_bits384 = get_bits384_from_vector(hex_to_binary_vector(
+        "0F000000000000FF00000000000000FF00000000000000FF00000000000000FF00"
+        "000000000000FF00000000000000FF"));
+    bits64 value_bits64 =
+        get_bits64_from_vector(hex_to_binary_vector("2F0000000000000F"));
+    bits256 a_sk_bits256 = get_bits256_from_vector(hex_digest_to_binary_vector(
+        "FF0000000000000000000000000000000000000000000000000000000000000F"));
+    bits256 rho_bits256 = get_bits256_from_vector(hex_digest_to_binary_vector(
+        "FFFF000000000000000000000000000000000000000000000000000000009009"));
+    bits256 a_pk_bits256 = get_bits256_from_vector(hex_digest_to_binary_vector(
+        "f172d7299ac8ac974ea59413e4a87691826df038ba24a2b52d5c5d15c2cc8c49"));
+    bits256 nf_bits256 = get_bits256_from_vector(hex_digest_to_binary_vector(
+        "ff2f41920346251f6e7c67062149f98bc90c915d3d3020927ca01deab5da0fd7"));
+    FieldT cm_field = FieldT("9047913389147464750130699723564635396506448356890"
+                             "6678810249472230384841563494");
+    libff::bit_vector address_bits = {1, 0, 0, 0};
+    const size_t address_commitment = 1;
+    bits256 h_sig = get_bits256_from_vector(hex_digest_to_binary_vector(
+        "6838aac4d8247655715d3dfb9b32573da2b7d3360ba89ccdaaa7923bb24c99f7"));
+    bits256 phi = get_bits256_from_vector(hex_digest_to_binary_vector(
+        "403794c0e20e3bf36b820d8f7aef5505e5d1c7ac265d5efbcc3030a74a3f701b"));
+
+    test_merkle_tree->set_value(address_commitment, cm_field);
+    std::vector<FieldT> path = test_merkle_tree->get_path(address_commitment);
+    const FieldT root = test_merkle_tree->get_root();
+
+    // The second note has a nonzero value, but is not in the tree
+    bits64 value_missing_bits64 =
+        get_bits64_from_vector(hex_to_binary_vector("0000000000000001"));
+    zeth_note note_input(
+        a_pk_bits256, value_bits64, rho_bits256, trap_r_bits384);
+    zeth_note note_missing_input(
+        a_pk_bits256, value_missing_bits64, rho_bits256, trap_r_bits384);
+    std::array<joinsplit_input<FieldT>, 2> inputs;
+    inputs[0] = joinsplit_input<FieldT>(
+        path,
+        get_bits_addr_from_vector(address_bits),
+        note_input,
+        a_sk_bits256,
+        nf_bits256);
+    inputs[1] = joinsplit_input<FieldT>(
+        path,
+        get_bits_addr_from_vector(address_bits),
+        note_missing_input,
+        a_sk_bits256,
+        nf_bits256);
+
+    // All the value goes to vpub_out
+    std::array<zeth_note, 2> outputs;
+    outputs[0] = zeth_note(a_pk_bits256, bits64(), bits256(), trap_r_bits384);
+    outputs[1] = outputs[0];
+
+    prover.prove(
+        root,
+        inputs,
+        outputs,
+        bits64(),
+        binary_addition<64>(value_bits64, value_missing_bits64),
+        h_sig,
+        phi,
+        keypair.pk);
+}
+
 TEST(MainTests, ProofGenAndVerifJS2to2)
 {
     // Run the trusted setup once for all tests, and keep the keypair in memory
@@ -746,6 +823,10 @@ TEST(MainTests, ProofGenAndVerifJS2to2)
     } catch (const std::invalid_argument &e) {
         std::cerr << "Invalid argument exception: " << e.what() << '\n';
     }
+
+    // The default satisfiability check rejects the witness before proving
+    ASSERT_THROW(
+        TestUnsatisfiedJS2In2(proverJS2to2, keypair), std::invalid_argument);
 }
 
 } // namespace
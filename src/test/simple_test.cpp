@@ -4,6 +4,9 @@
 
 #include "simple_test.hpp"
 
+#include "libsnark_helpers/extended_proof.hpp"
+#include "libsnark_helpers/proving_context.hpp"
+#include "snarks/groth16/core/computation.hpp"
 #include "util.hpp"
 
 #include <gtest/gtest.h>
@@ -82,6 +85,114 @@ TEST(SimpleTests, SimpleCircuitProofPow2Domain)
         r1cs_gg_ppzksnark_verifier_strong_IC(keypair.vk, primary, proof));
 }
 
+TEST(SimpleTests, ProvingContext)
+{
+    protoboard<FieldT> pb;
+    test::simple_circuit<FieldT>(pb);
+    const r1cs_gg_ppzksnark_keypair<ppT> keypair =
+        r1cs_gg_ppzksnark_generator<ppT>(pb.get_constraint_system(), true);
+
+    // Witnesses for x = 1 (y = 12) and x = 2 (y = 33), loaded in turn from
+    // the protoboard. Variables: y, x, g1, g2.
+    const std::vector<std::vector<FieldT>> witnesses{{12, 1, 1, 1},
+                                                     {33, 2, 4, 8}};
+    proving_context<FieldT> context;
+    context.reset(witnesses.size());
+    for (size_t i = 0; i < witnesses.size(); ++i) {
+        for (size_t j = 0; j < witnesses[i].size(); ++j) {
+            pb.val(pb_variable<FieldT>(j + 1)) = witnesses[i][j];
+        }
+        ASSERT_TRUE(pb.is_satisfied());
+        context.load_witness(pb, i);
+        ASSERT_EQ(pb.primary_input(), context.primary_inputs[i]);
+        ASSERT_EQ(pb.auxiliary_input(), context.auxiliary_inputs[i]);
+    }
+
+    // Buffers are reused by subsequent requests
+    const FieldT *const auxiliary_data = context.auxiliary_inputs[0].data();
+    context.reset(1);
+    context.load_witness(pb, 0);
+    ASSERT_EQ(auxiliary_data, context.auxiliary_inputs[0].data());
+    ASSERT_EQ(pb.auxiliary_input(), context.auxiliary_inputs[0]);
+
+    // Proofs generated from the buffers, one at a time and in batches (with
+    // blocks smaller than the queries)
+    const std::vector<r1cs_gg_ppzksnark_proof<ppT>> single_proof =
+        gen_proof_batch<ppT>(
+            context.primary_inputs, context.auxiliary_inputs, keypair.pk);
+    ASSERT_TRUE(r1cs_gg_ppzksnark_verifier_strong_IC(
+        keypair.vk, context.primary_inputs[0], single_proof[0]));
+
+    context.reset(witnesses.size());
+    for (size_t i = 0; i < witnesses.size(); ++i) {
+        context.primary_inputs[i].assign(
+            witnesses[i].begin(), witnesses[i].begin() + 1);
+        context.auxiliary_inputs[i].assign(
+            witnesses[i].begin() + 1, witnesses[i].end());
+    }
+    const std::vector<r1cs_gg_ppzksnark_proof<ppT>> proofs =
+        gen_proof_batch<ppT>(
+            context.primary_inputs, context.auxiliary_inputs, keypair.pk, 2);
+    ASSERT_EQ(witnesses.size(), proofs.size());
+    for (size_t i = 0; i < proofs.size(); ++i) {
+        ASSERT_TRUE(r1cs_gg_ppzksnark_verifier_strong_IC(
+            keypair.vk, context.primary_inputs[i], proofs[i]));
+    }
+}
+
+TEST(SimpleTests, VerifyBatch)
+{
+    protoboard<FieldT> pb;
+    test::simple_circuit<FieldT>(pb);
+    const r1cs_gg_ppzksnark_keypair<ppT> keypair =
+        r1cs_gg_ppzksnark_generator<ppT>(pb.get_constraint_system(), true);
+
+    // Proofs for x = 1, ..., 5
+    std::vector<r1cs_gg_ppzksnark_proof<ppT>> proofs;
+    std::vector<r1cs_primary_input<FieldT>> primary_inputs;
+    for (long x = 1; x <= 5; ++x) {
+        const long y = x * x * x + 4 * x * x + 2 * x + 5;
+        primary_inputs.push_back(r1cs_primary_input<FieldT>{y});
+        const r1cs_auxiliary_input<FieldT> auxiliary{x, x * x, x * x * x};
+        proofs.push_back(r1cs_gg_ppzksnark_prover(
+            keypair.pk, primary_inputs.back(), auxiliary, true));
+    }
+
+    std::vector<extended_proof<ppT>> ext_proofs;
+    for (size_t i = 0; i < proofs.size(); ++i) {
+        ext_proofs.emplace_back(proofs[i], primary_inputs[i]);
+    }
+    ASSERT_EQ(
+        std::vector<bool>(proofs.size(), true),
+        verify_batch<ppT>(ext_proofs, keypair.vk));
+    ASSERT_TRUE(verify_batch<ppT>({}, keypair.vk).empty());
+
+    // Proof 1 with the statement of proof 3, proof 3 with an unexpected
+    // number of inputs, and proof 4 with the statement of proof 0.
+    r1cs_primary_input<FieldT> two_inputs{primary_inputs[3][0], 1};
+    ext_proofs[1] = extended_proof<ppT>(proofs[1], primary_inputs[3]);
+    ext_proofs[3] = extended_proof<ppT>(proofs[3], two_inputs);
+    ext_proofs[4] = extended_proof<ppT>(proofs[4], primary_inputs[0]);
+    ASSERT_EQ(
+        std::vector<bool>({true, false, true, false, false}),
+        verify_batch<ppT>(ext_proofs, keypair.vk));
+
+    // With the processed key, the proofs are checked as by libsnark
+    const processed_verification_key<ppT> processed_vk =
+        process_verification_key<ppT>(keypair.vk);
+    ASSERT_EQ(
+        std::vector<bool>({true, false, true, false, false}),
+        verify_batch<ppT>(ext_proofs, processed_vk));
+    for (const extended_proof<ppT> &ext_proof : ext_proofs) {
+        ASSERT_EQ(
+            r1cs_gg_ppzksnark_verifier_strong_IC<ppT>(
+                keypair.vk,
+                ext_proof.get_primary_input(),
+                ext_proof.get_proof()),
+            verify<ppT>(ext_proof, processed_vk));
+    }
+}
+
 } // namespace
 
 int main(int argc, char **argv)
@@ -8,52 +8,96 @@
 #include "zeth.h"
 
 #include <array>
+#include <cstdint>
 #include <iostream>
+#include <string>
 #include <vector>
 
 namespace libzeth
 {
 
-typedef std::array<bool, 384> bits384;
-typedef std::array<bool, 256> bits256;
-typedef std::array<bool, 64> bits64;
-typedef std::array<bool, 32> bits32;
-typedef std::array<bool, ZETH_MERKLE_TREE_DEPTH> bits_addr;
+/// Fixed-size binary string of `Size` bits, packed in 64-bit words.
+///
+/// Bit 0 is the most significant bit of the string (the order used by the
+/// hexadecimal and byte encodings, and by the circuits). It is held in the
+/// most significant bit of the first word, so that the words are the
+/// big-endian encoding of the string, padded with zeroes up to a multiple of
+/// 64 bits. Arithmetic and comparisons then operate on whole words.
+template<size_t Size> class bits
+{
+public:
+    static const size_t num_words = (Size + 63) / 64;
+    typedef std::array<uint64_t, num_words> words_type;
+
+    /// All bits set to 0.
+    bits();
+
+    /// Set all bits to `value`.
+    void fill(bool value);
+
+    static constexpr size_t size() { return Size; }
+    bool operator[](size_t i) const;
+    void set(size_t i, bool value);
+
+    const words_type &words() const { return words_; }
+    words_type &words() { return words_; }
+
+    bool operator==(const bits<Size> &other) const;
+    bool operator!=(const bits<Size> &other) const;
+
+    /// Create from a vector of exactly `Size` bits.
+    static bits<Size> from_vector(const std::vector<bool> &vect);
+
+    /// Create from a string of exactly `Size / 8` bytes (most significant
+    /// bit of each byte first).
+    static bits<Size> from_bytes(const std::string &bytes);
+
+    /// Append the bits to the end of `into`, avoiding any intermediate copy.
+    void append_to_vector(std::vector<bool> &into) const;
+
+    std::vector<bool> to_vector() const;
+
+private:
+    words_type words_;
+};
+
+typedef bits<384> bits384;
+typedef bits<256> bits256;
+typedef bits<64> bits64;
+typedef bits<32> bits32;
+typedef bits<ZETH_MERKLE_TREE_DEPTH> bits_addr;
 
 // Dump a vector into an array
 template<size_t Size>
-std::array<bool, Size> dump_vector_in_array(std::vector<bool> vect);
+bits<Size> dump_vector_in_array(const std::vector<bool> &vect);
 
-bits384 get_bits384_from_vector(std::vector<bool> vect);
-bits256 get_bits256_from_vector(std::vector<bool> vect);
-bits64 get_bits64_from_vector(std::vector<bool> vect);
-bits32 get_bits32_from_vector(std::vector<bool> vect);
-bits_addr get_bits_addr_from_vector(std::vector<bool> vect);
+bits384 get_bits384_from_vector(const std::vector<bool> &vect);
+bits256 get_bits256_from_vector(const std::vector<bool> &vect);
+bits64 get_bits64_from_vector(const std::vector<bool> &vect);
+bits32 get_bits32_from_vector(const std::vector<bool> &vect);
+bits_addr get_bits_addr_from_vector(const std::vector<bool> &vect);
 
 // Dump an array into a vector
 template<size_t Size>
-std::vector<bool> dump_array_in_vector(std::array<bool, Size> arr);
+std::vector<bool> dump_array_in_vector(const bits<Size> &arr);
 
-std::vector<bool> get_vector_from_bits384(bits384 arr);
-std::vector<bool> get_vector_from_bits256(bits256 arr);
-std::vector<bool> get_vector_from_bits64(bits64 arr);
-std::vector<bool> get_vector_from_bits32(bits32 arr);
-std::vector<bool> get_vector_from_bits_addr(bits_addr arr);
+std::vector<bool> get_vector_from_bits384(const bits384 &arr);
+std::vector<bool> get_vector_from_bits256(const bits256 &arr);
+std::vector<bool> get_vector_from_bits64(const bits64 &arr);
+std::vector<bool> get_vector_from_bits32(const bits32 &arr);
+std::vector<bool> get_vector_from_bits_addr(const bits_addr &arr);
 
 // Sum 2 binary strings
 template<size_t BitLen>
-std::array<bool, BitLen> binary_addition(
-    std::array<bool, BitLen> A,
-    std::array<bool, BitLen> B,
-    bool withCarry = false);
+bits<BitLen> binary_addition(
+    const bits<BitLen> &A, const bits<BitLen> &B, bool withCarry = false);
 
 template<size_t BitLen>
-std::array<bool, BitLen> binary_xor(
-    std::array<bool, BitLen> A, std::array<bool, BitLen> B);
+bits<BitLen> binary_xor(const bits<BitLen> &A, const bits<BitLen> &B);
 
-bits64 sum_bits64(bits64 a, bits64 b);
+bits64 sum_bits64(const bits64 &a, const bits64 &b);
 
 } // namespace libzeth
 #include "bits.tcc"
 
-#endif // __ZETH_TYPES_BITS_HPP__
\ No newline at end of file
+#endif // __ZETH_TYPES_BITS_HPP__
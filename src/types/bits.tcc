@@ -5,46 +5,136 @@
 #ifndef __ZETH_TYPES_BITS_TCC__
 #define __ZETH_TYPES_BITS_TCC__
 
+#include <stdexcept>
+
 namespace libzeth
 {
 
-/// dump_vector_in_array dumps a vector into an array
+template<size_t Size> bits<Size>::bits() { words_.fill(0); }
+
+template<size_t Size> void bits<Size>::fill(bool value)
+{
+    words_.fill(value ? ~uint64_t(0) : 0);
+
+    // Keep the padding bits of the last word at 0, so that words can be
+    // compared and added directly.
+    const size_t padding = num_words * 64 - Size;
+    if (padding != 0) {
+        words_[num_words - 1] &= ~uint64_t(0) << padding;
+    }
+}
+
+template<size_t Size> bool bits<Size>::operator[](size_t i) const
+{
+    return (words_[i / 64] >> (63 - (i % 64))) & 1;
+}
+
+template<size_t Size> void bits<Size>::set(size_t i, bool value)
+{
+    const uint64_t mask = uint64_t(1) << (63 - (i % 64));
+    if (value) {
+        words_[i / 64] |= mask;
+    } else {
+        words_[i / 64] &= ~mask;
+    }
+}
+
 template<size_t Size>
-std::array<bool, Size> dump_vector_in_array(std::vector<bool> vect)
+bool bits<Size>::operator==(const bits<Size> &other) const
+{
+    return words_ == other.words_;
+}
+
+template<size_t Size>
+bool bits<Size>::operator!=(const bits<Size> &other) const
+{
+    return words_ != other.words_;
+}
+
+template<size_t Size>
+bits<Size> bits<Size>::from_vector(const std::vector<bool> &vect)
 {
-    std::array<bool, Size> array;
     if (vect.size() != Size) {
         throw std::length_error(
             "Invalid bit length for the given boolean vector (should be equal "
             "to the size of the vector)");
     }
 
-    std::copy(vect.begin(), vect.end(), array.begin());
-    return array;
+    bits<Size> result;
+    for (size_t i = 0; i < Size; ++i) {
+        result.words_[i / 64] |= uint64_t(vect[i]) << (63 - (i % 64));
+    }
+
+    return result;
+}
+
+template<size_t Size>
+bits<Size> bits<Size>::from_bytes(const std::string &bytes)
+{
+    static_assert(Size % 8 == 0, "from_bytes requires whole bytes");
+    if (bytes.size() != Size / 8) {
+        throw std::length_error(
+            "Invalid byte length for the given binary string (should be equal "
+            "to the number of bits / 8)");
+    }
+
+    bits<Size> result;
+    for (size_t i = 0; i < Size / 8; ++i) {
+        result.words_[i / 8] |= uint64_t((uint8_t)bytes[i])
+                                << (56 - 8 * (i % 8));
+    }
+
+    return result;
+}
+
+template<size_t Size>
+void bits<Size>::append_to_vector(std::vector<bool> &into) const
+{
+    const size_t offset = into.size();
+    into.resize(offset + Size);
+    for (size_t i = 0; i < Size; ++i) {
+        into[offset + i] = (*this)[i];
+    }
+}
+
+template<size_t Size> std::vector<bool> bits<Size>::to_vector() const
+{
+    std::vector<bool> vect;
+    append_to_vector(vect);
+    return vect;
+}
+
+/// dump_vector_in_array dumps a vector into an array
+template<size_t Size>
+bits<Size> dump_vector_in_array(const std::vector<bool> &vect)
+{
+    return bits<Size>::from_vector(vect);
 };
 
 /// dump_array_in_vector dumps an array into a vector
 template<size_t Size>
-std::vector<bool> dump_array_in_vector(std::array<bool, Size> arr)
+std::vector<bool> dump_array_in_vector(const bits<Size> &arr)
 {
-    std::vector<bool> vect(Size);
-    std::copy(arr.begin(), arr.end(), vect.begin());
-    return vect;
+    return arr.to_vector();
 }
 
 /// binary_addition sums 2 binary strings with or without carry depending on the
 /// boolean value of the `with_carry` variable
 template<size_t BitLen>
-std::array<bool, BitLen> binary_addition(
-    std::array<bool, BitLen> A, std::array<bool, BitLen> B, bool with_carry)
+bits<BitLen> binary_addition(
+    const bits<BitLen> &A, const bits<BitLen> &B, bool with_carry)
 {
-    std::array<bool, BitLen> sum;
-    sum.fill(0);
-
-    bool carry = 0;
-    for (int i = BitLen - 1; i >= 0; i--) {
-        sum[i] = ((A[i] ^ B[i]) ^ carry);
-        carry = ((A[i] & B[i]) | (A[i] & carry)) | (B[i] & carry);
+    // Words hold the big-endian encoding of the strings, padded with zeroes
+    // in the least significant bits, so the sum is computed word by word
+    // from the last one and the final carry is the overflow of the sum.
+    bits<BitLen> sum;
+    uint64_t carry = 0;
+    for (size_t i = bits<BitLen>::num_words; i-- > 0;) {
+        const uint64_t a = A.words()[i];
+        const uint64_t s = a + B.words()[i];
+        const uint64_t s_carry = s + carry;
+        carry = (s < a) | (s_carry < s);
+        sum.words()[i] = s_carry;
     }
 
     // If we ask for the last carry to be taken into account (with_carry=true)
@@ -59,14 +149,11 @@ std::array<bool, BitLen> binary_addition(
 
 /// binary_xor computes the XOR of 2 binary strings
 template<size_t BitLen>
-std::array<bool, BitLen> binary_xor(
-    std::array<bool, BitLen> A, std::array<bool, BitLen> B)
+bits<BitLen> binary_xor(const bits<BitLen> &A, const bits<BitLen> &B)
 {
-    std::array<bool, BitLen> xor_array;
-    xor_array.fill(0);
-
-    for (int i = BitLen - 1; i >= 0; i--) {
-        xor_array[i] = A[i] != B[i];
+    bits<BitLen> xor_array;
+    for (size_t i = 0; i < bits<BitLen>::num_words; ++i) {
+        xor_array.words()[i] = A.words()[i] ^ B.words()[i];
     }
 
     return xor_array;
@@ -74,4 +161,4 @@ std::array<bool, BitLen> binary_xor(
 
 } // namespace libzeth
 
-#endif // __ZETH_TYPES_BITS_TCC__
\ No newline at end of file
+#endif // __ZETH_TYPES_BITS_TCC__
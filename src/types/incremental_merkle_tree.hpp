@@ -0,0 +1,93 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_TYPES_INCREMENTAL_MERKLE_TREE_HPP__
+#define __ZETH_TYPES_INCREMENTAL_MERKLE_TREE_HPP__
+
+#include "types/merkle_tree_field.hpp"
+
+#include <map>
+#include <vector>
+
+namespace libzeth
+{
+
+// Append-only Merkle tree whose nodes are field elements.
+//
+// Leaves are appended from left to right (as commitments are on-chain), and
+// the tree only keeps the "frontier": for each layer, the root of the last
+// complete left subtree waiting for its right sibling. This is enough to
+// compute the root, and memory stays O(depth) regardless of the number of
+// leaves. Nodes which have not been filled yet are empty subtrees (see
+// merkle_tree_field::hash_defaults), so that both trees have the same root
+// for the same sequence of leaves.
+//
+// The authentication path of selected leaves can be maintained by tracking
+// them right after they are appended. Each tracked leaf uses O(depth) memory
+// and its path is updated on every subsequent append.
+template<typename FieldT, typename HashTreeT> class incremental_merkle_tree
+{
+private:
+    // Path of a tracked leaf. The siblings on the left of the path are known
+    // when the leaf is appended. The ones on the right are filled by the next
+    // leaves, lowest layer first, using a frontier of the subtree being
+    // filled (`cursor`).
+    struct witness_tracker {
+        size_t address;
+        FieldT value;
+        std::vector<FieldT> path;
+        // Level (0 for the leaves) of the sibling being filled, or `depth`
+        // once the path is complete
+        size_t cursor_level;
+        size_t cursor_size;
+        std::vector<FieldT> cursor;
+    };
+
+    size_t num_leaves;
+    FieldT last_leaf;
+    // frontier[level] is the root of the last complete left subtree of height
+    // `level`. frontier[depth] holds the root once the tree is full.
+    std::vector<FieldT> frontier;
+    std::map<size_t, witness_tracker> witnesses;
+
+    bool frontier_append(
+        std::vector<FieldT> &branch,
+        const size_t size,
+        const FieldT &value) const;
+    FieldT frontier_root(
+        const std::vector<FieldT> &branch, const size_t size) const;
+    void witness_append(witness_tracker &witness, const FieldT &value) const;
+    void witness_next_cursor(
+        witness_tracker &witness, const size_t from_level) const;
+
+public:
+    // Value of the root of an empty subtree, indexed by layer (the root of
+    // the tree is at index 0, and the leaves at index `depth`)
+    std::vector<FieldT> hash_defaults;
+    size_t depth;
+
+    incremental_merkle_tree(const size_t depth);
+
+    // Number of leaves appended so far
+    size_t size() const;
+    // Append a leaf and return its address
+    size_t append(const FieldT &value);
+    FieldT get_root() const;
+
+    // Start maintaining the authentication path of the leaf at `address`,
+    // which must be the last appended leaf.
+    void track(const size_t address);
+    void untrack(const size_t address);
+    bool is_tracked(const size_t address) const;
+
+    // Value and authentication path (see merkle_tree_field::get_path) of a
+    // tracked leaf
+    FieldT get_value(const size_t address) const;
+    std::vector<FieldT> get_path(const size_t address) const;
+};
+
+} // namespace libzeth
+#include "incremental_merkle_tree.tcc"
+
+#endif // __ZETH_TYPES_INCREMENTAL_MERKLE_TREE_HPP__
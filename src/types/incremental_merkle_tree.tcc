@@ -0,0 +1,208 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_TYPES_INCREMENTAL_MERKLE_TREE_TCC__
+#define __ZETH_TYPES_INCREMENTAL_MERKLE_TREE_TCC__
+
+#include <stdexcept>
+
+namespace libzeth
+{
+
+template<typename FieldT, typename HashTreeT>
+incremental_merkle_tree<FieldT, HashTreeT>::incremental_merkle_tree(
+    const size_t depth)
+    : num_leaves(0)
+    , frontier(depth + 1)
+    , hash_defaults(
+          merkle_tree_field<FieldT, HashTreeT>::compute_hash_defaults(depth))
+    , depth(depth)
+{
+}
+
+template<typename FieldT, typename HashTreeT>
+size_t incremental_merkle_tree<FieldT, HashTreeT>::size() const
+{
+    return num_leaves;
+}
+
+template<typename FieldT, typename HashTreeT>
+size_t incremental_merkle_tree<FieldT, HashTreeT>::append(const FieldT &value)
+{
+    if (num_leaves == (1ul << depth)) {
+        throw std::overflow_error("Merkle tree is full");
+    }
+
+    frontier_append(frontier, num_leaves, value);
+    last_leaf = value;
+    const size_t address = num_leaves++;
+
+    for (auto &entry : witnesses) {
+        witness_append(entry.second, value);
+    }
+
+    return address;
+}
+
+template<typename FieldT, typename HashTreeT>
+FieldT incremental_merkle_tree<FieldT, HashTreeT>::get_root() const
+{
+    return frontier_root(frontier, num_leaves);
+}
+
+template<typename FieldT, typename HashTreeT>
+void incremental_merkle_tree<FieldT, HashTreeT>::track(const size_t address)
+{
+    if (num_leaves == 0 || address != num_leaves - 1) {
+        throw std::invalid_argument(
+            "Only the last appended leaf can be tracked");
+    }
+
+    witness_tracker witness;
+    witness.address = address;
+    witness.value = last_leaf;
+    witness.path.reserve(depth);
+    for (size_t level = 0; level < depth; ++level) {
+        if ((address >> level) & 1) {
+            // The left sibling is complete, and is still on the frontier
+            witness.path.push_back(frontier[level]);
+        } else {
+            // The right sibling is empty for now
+            witness.path.push_back(hash_defaults[depth - level]);
+        }
+    }
+
+    witness_next_cursor(witness, 0);
+    witnesses[address] = witness;
+}
+
+template<typename FieldT, typename HashTreeT>
+void incremental_merkle_tree<FieldT, HashTreeT>::untrack(const size_t address)
+{
+    witnesses.erase(address);
+}
+
+template<typename FieldT, typename HashTreeT>
+bool incremental_merkle_tree<FieldT, HashTreeT>::is_tracked(
+    const size_t address) const
+{
+    return witnesses.find(address) != witnesses.end();
+}
+
+template<typename FieldT, typename HashTreeT>
+FieldT incremental_merkle_tree<FieldT, HashTreeT>::get_value(
+    const size_t address) const
+{
+    auto it = witnesses.find(address);
+    if (it == witnesses.end()) {
+        throw std::invalid_argument("Leaf is not tracked");
+    }
+
+    return it->second.value;
+}
+
+template<typename FieldT, typename HashTreeT>
+std::vector<FieldT> incremental_merkle_tree<FieldT, HashTreeT>::get_path(
+    const size_t address) const
+{
+    auto it = witnesses.find(address);
+    if (it == witnesses.end()) {
+        throw std::invalid_argument("Leaf is not tracked");
+    }
+
+    return it->second.path;
+}
+
+// Append `value` to the frontier `branch` of a subtree of height
+// `branch.size() - 1` currently holding `size` leaves. Returns true when the
+// subtree becomes full, in which case its root is stored in `branch.back()`.
+template<typename FieldT, typename HashTreeT>
+bool incremental_merkle_tree<FieldT, HashTreeT>::frontier_append(
+    std::vector<FieldT> &branch, const size_t size, const FieldT &value) const
+{
+    const size_t height = branch.size() - 1;
+
+    // Walk up while the new node is a right child, merging it with its left
+    // sibling on the frontier. The first left child replaces the frontier
+    // node of its level.
+    FieldT node = value;
+    size_t pos = size;
+    for (size_t level = 0; level < height; ++level) {
+        if ((pos & 1) == 0) {
+            branch[level] = node;
+            return false;
+        }
+
+        node = HashTreeT::get_hash(branch[level], node);
+        pos = pos / 2;
+    }
+
+    branch[height] = node;
+    return true;
+}
+
+// Root of the subtree of height `branch.size() - 1` holding `size` leaves,
+// where the missing leaves are empty.
+template<typename FieldT, typename HashTreeT>
+FieldT incremental_merkle_tree<FieldT, HashTreeT>::frontier_root(
+    const std::vector<FieldT> &branch, const size_t size) const
+{
+    const size_t height = branch.size() - 1;
+    if (size == (1ul << height)) {
+        return branch[height];
+    }
+
+    FieldT node = hash_defaults[depth];
+    for (size_t level = 0; level < height; ++level) {
+        if ((size >> level) & 1) {
+            node = HashTreeT::get_hash(branch[level], node);
+        } else {
+            node = HashTreeT::get_hash(node, hash_defaults[depth - level]);
+        }
+    }
+
+    return node;
+}
+
+template<typename FieldT, typename HashTreeT>
+void incremental_merkle_tree<FieldT, HashTreeT>::witness_append(
+    witness_tracker &witness, const FieldT &value) const
+{
+    if (witness.cursor_level == depth) {
+        return;
+    }
+
+    const bool full =
+        frontier_append(witness.cursor, witness.cursor_size, value);
+    ++witness.cursor_size;
+
+    if (full) {
+        // The sibling is complete, move on to the next right sibling
+        witness.path[witness.cursor_level] = witness.cursor.back();
+        witness_next_cursor(witness, witness.cursor_level + 1);
+    } else {
+        witness.path[witness.cursor_level] =
+            frontier_root(witness.cursor, witness.cursor_size);
+    }
+}
+
+// Start filling the first right sibling of the path, at or above
+// `from_level`.
+template<typename FieldT, typename HashTreeT>
+void incremental_merkle_tree<FieldT, HashTreeT>::witness_next_cursor(
+    witness_tracker &witness, const size_t from_level) const
+{
+    size_t level = from_level;
+    while (level < depth && ((witness.address >> level) & 1)) {
+        ++level;
+    }
+
+    witness.cursor_level = level;
+    witness.cursor_size = 0;
+    witness.cursor.assign(level + 1, FieldT::zero());
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_TYPES_INCREMENTAL_MERKLE_TREE_TCC__
@@ -8,6 +8,7 @@
 #include "types/bits.hpp"
 #include "types/note.hpp"
 
+#include <array>
 #include <libsnark/common/data_structures/merkle_tree.hpp>
 #include <vector>
 
@@ -46,6 +47,40 @@ public:
     }
 };
 
+// All the data needed to generate a joinsplit proof (ie: the arguments of
+// `circuit_wrapper::prove`). This is used to request proofs in batches.
+template<typename FieldT, size_t NumInputs, size_t NumOutputs>
+class joinsplit_proof_inputs
+{
+public:
+    FieldT root;
+    std::array<joinsplit_input<FieldT>, NumInputs> inputs;
+    std::array<zeth_note, NumOutputs> outputs;
+    bits64 vpub_in;
+    bits64 vpub_out;
+    bits256 h_sig;
+    bits256 phi;
+
+    joinsplit_proof_inputs(){};
+    joinsplit_proof_inputs(
+        const FieldT &root,
+        const std::array<joinsplit_input<FieldT>, NumInputs> &inputs,
+        const std::array<zeth_note, NumOutputs> &outputs,
+        bits64 vpub_in,
+        bits64 vpub_out,
+        bits256 h_sig,
+        bits256 phi)
+        : root(root)
+        , inputs(inputs)
+        , outputs(outputs)
+        , vpub_in(vpub_in)
+        , vpub_out(vpub_out)
+        , h_sig(h_sig)
+        , phi(phi)
+    {
+    }
+};
+
 } // namespace libzeth
 
 #endif // __ZETH_TYPES_JOINSPLIT_HPP__
@@ -5,6 +5,9 @@
 #ifndef __ZETH_TYPES_MERKLE_TREE_FIELD_HPP__
 #define __ZETH_TYPES_MERKLE_TREE_FIELD_HPP__
 
+#include "types/merkle_tree_mmap_storage.hpp"
+#include "types/merkle_tree_storage.hpp"
+
 #include <libff/common/default_types/ec_pp.hpp>
 #include <libff/common/utils.hpp>
 #include <map>
@@ -15,24 +18,28 @@ namespace libzeth
 
 // Merkle Tree whose nodes are field elements
 //
-// A Merkle tree is maintained as two maps:
-// - `values` = Map from addresses to values, and
-// - `hashes` = Map from addresses to hashes.
-//
-// The second map maintains the intermediate hashes of a Merkle tree
-// built atop the values currently stored in the tree (the
-// implementation admits a very efficient support for sparse
-// trees). Besides offering methods to load and store values, the
-// class offers methods to retrieve the root of the Merkle tree and to
-// obtain the authentication paths for (the value at) a given address.
-
-template<typename FieldT, typename HashTreeT> class merkle_tree_field
+// The tree maintains the leaves (values) and the intermediate hashes of a
+// Merkle tree built atop the values currently stored in the tree, in a
+// storage given by the `StorageT` policy (see merkle_tree_storage.hpp). Nodes
+// which have never been set are the roots of empty subtrees, and take their
+// value from `hash_defaults` (the storage supports very efficient sparse
+// trees). Besides offering methods to load and store values, the class offers
+// methods to retrieve the root of the Merkle tree and to obtain the
+// authentication paths for (the value at) a given address.
+
+template<
+    typename FieldT,
+    typename HashTreeT,
+    typename StorageT = merkle_tree_map_storage<FieldT>>
+class merkle_tree_field
 {
 
 public:
+    // Value of the root of an empty subtree, indexed by layer (the root of
+    // the tree is at index 0, and the leaves at index `depth`)
     std::vector<FieldT> hash_defaults;
-    std::map<size_t, FieldT> values;
-    std::map<size_t, FieldT> hashes;
+    // Leaves (layer `depth`) and intermediate hashes of the tree
+    StorageT nodes;
     size_t depth;
 
     merkle_tree_field(const size_t depth);
@@ -40,16 +47,49 @@ public:
         const size_t depth, const std::vector<FieldT> &contents_as_vector);
     merkle_tree_field(
         const size_t depth, const std::map<size_t, FieldT> &contents);
+    // Tree over an existing storage (e.g. a merkle_tree_mmap_storage
+    // reopened from disk). The depth and `hash_defaults` are those of the
+    // storage.
+    merkle_tree_field(StorageT &&storage);
 
     FieldT get_value(const size_t address) const;
     void set_value(const size_t address, const FieldT &value);
+    // Set several leaves at once. The ancestors shared by the paths of the
+    // leaves are only recomputed once.
+    void set_values(const std::map<size_t, FieldT> &values);
+    // Set the leaves at consecutive addresses, starting at `first_address`
+    void set_values(
+        const size_t first_address, const std::vector<FieldT> &values);
 
     FieldT get_root() const;
     std::vector<FieldT> get_path(const size_t address) const;
 
     void dump() const;
+
+    // Roots of the empty subtrees, from the root (index 0) to the leaves
+    // (index `depth`) of a tree of depth `depth`
+    static std::vector<FieldT> compute_hash_defaults(const size_t depth);
+
+private:
+    // Recompute the nodes above the given (sorted) leaf positions, level by
+    // level, hashing each dirty node once
+    void update_ancestors(std::vector<size_t> positions);
 };
 
+// Merkle tree backed by merkle_tree_array_storage
+template<typename FieldT, typename HashTreeT>
+using merkle_tree_field_array = merkle_tree_field<
+    FieldT,
+    HashTreeT,
+    merkle_tree_array_storage<FieldT>>;
+
+// Persistent Merkle tree backed by merkle_tree_mmap_storage
+template<typename FieldT, typename HashTreeT>
+using merkle_tree_field_mmap = merkle_tree_field<
+    FieldT,
+    HashTreeT,
+    merkle_tree_mmap_storage<FieldT>>;
+
 } // namespace libzeth
 #include "merkle_tree_field.tcc"
 
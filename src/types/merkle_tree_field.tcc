@@ -14,223 +14,251 @@
 namespace libzeth
 {
 
-template<typename FieldT, typename HashTreeT>
-merkle_tree_field<FieldT, HashTreeT>::merkle_tree_field(const size_t depth)
-    : depth(depth)
+template<typename FieldT, typename HashTreeT, typename StorageT>
+merkle_tree_field<FieldT, HashTreeT, StorageT>::merkle_tree_field(
+    const size_t depth)
+    : hash_defaults(compute_hash_defaults(depth))
+    , nodes(hash_defaults)
+    , depth(depth)
 {
-    assert(depth < sizeof(size_t) * 8);
-
-    // Value of the leaves when initializing the merkle tree
-    FieldT last = FieldT::zero();
-
-    // Length of a merkle path = depth + 1
-    // `hash_defaults` contains the default value of a merkle path
-    // ie: The recursive hash of the zero valued leaves
-    hash_defaults.reserve(depth + 1);
-    hash_defaults.emplace_back(last);
-    for (size_t i = 0; i < depth; ++i) {
-        last = HashTreeT::get_hash(last, last);
-        hash_defaults.push_back(last);
-    }
-
-    std::reverse(hash_defaults.begin(), hash_defaults.end());
 }
 
-template<typename FieldT, typename HashTreeT>
-merkle_tree_field<FieldT, HashTreeT>::merkle_tree_field(
+template<typename FieldT, typename HashTreeT, typename StorageT>
+merkle_tree_field<FieldT, HashTreeT, StorageT>::merkle_tree_field(
     const size_t depth, const std::vector<FieldT> &contents_as_vector)
-    : merkle_tree_field<FieldT, HashTreeT>(depth)
+    : merkle_tree_field<FieldT, HashTreeT, StorageT>(depth)
 {
     assert(libff::log2(contents_as_vector.size()) <= depth);
-    for (size_t address = 0; address < contents_as_vector.size(); ++address) {
-        // `1ul << depth` returns the total number of leaves in the merkle tree
-        // of depth `depth`
-        const size_t idx = address + (1ul << depth) - 1;
-        values[idx] = contents_as_vector[address];
-        hashes[idx] = contents_as_vector[address];
-    }
-
-    size_t idx_begin = (1ul << depth) - 1;
-    size_t idx_end = contents_as_vector.size() + ((1ul << depth) - 1);
-
-    for (int layer = depth; layer > 0; --layer) {
-        for (size_t idx = idx_begin; idx < idx_end; idx += 2) {
-            FieldT l = hashes[idx]; // this is sound, because idx_begin is
-                                    // always a left child
-            FieldT r =
-                (idx + 1 < idx_end ? hashes[idx + 1] : hash_defaults[layer]);
 
-            FieldT h = HashTreeT::get_hash(l, r);
-            hashes[(idx - 1) / 2] = h;
+    // Bulk construction: each layer is computed into a contiguous buffer,
+    // hashing the pairs of siblings in parallel, and handed to the storage
+    // once complete.
+    std::vector<FieldT> layer_nodes = contents_as_vector;
+    for (size_t layer = depth; layer > 0; --layer) {
+        const size_t num_nodes = layer_nodes.size();
+        std::vector<FieldT> parent_nodes((num_nodes + 1) / 2);
+
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+        for (size_t pos = 0; pos < parent_nodes.size(); ++pos) {
+            // Missing right children are empty subtrees
+            const size_t left = 2 * pos;
+            parent_nodes[pos] = HashTreeT::get_hash(
+                layer_nodes[left],
+                left + 1 < num_nodes ? layer_nodes[left + 1]
+                                     : hash_defaults[layer]);
         }
 
-        idx_begin = (idx_begin - 1) / 2;
-        idx_end = (idx_end - 1) / 2;
+        nodes.set_layer(layer, std::move(layer_nodes));
+        layer_nodes = std::move(parent_nodes);
     }
+
+    nodes.set_layer(0, std::move(layer_nodes));
 }
 
-template<typename FieldT, typename HashTreeT>
-merkle_tree_field<FieldT, HashTreeT>::merkle_tree_field(
+template<typename FieldT, typename HashTreeT, typename StorageT>
+merkle_tree_field<FieldT, HashTreeT, StorageT>::merkle_tree_field(
     const size_t depth, const std::map<size_t, FieldT> &contents)
-    : merkle_tree_field<FieldT, HashTreeT>(depth)
+    : merkle_tree_field<FieldT, HashTreeT, StorageT>(depth)
 {
-    if (!contents.empty()) {
-        assert(contents.rbegin()->first < 1ul << depth);
-
-        for (auto it = contents.begin(); it != contents.end(); ++it) {
-            const size_t address = it->first;
-            const FieldT value = it->second;
-            const size_t idx = address + (1ul << depth) - 1;
-
-            values[address] = value;
-            hashes[idx] = value;
-        }
+    set_values(contents);
+}
 
-        auto last_it = hashes.end();
-
-        for (int layer = depth; layer > 0; --layer) {
-            auto next_last_it = hashes.begin();
-
-            for (auto it = hashes.begin(); it != last_it; ++it) {
-                const size_t idx = it->first;
-                const FieldT hash = it->second;
-
-                if (idx % 2 == 0) {
-                    // this is the right child of its parent and by invariant we
-                    // are missing the left child
-                    hashes[(idx - 1) / 2] =
-                        HashTreeT::get_hash(hash_defaults[layer], hash);
-                } else {
-                    if (std::next(it) == last_it ||
-                        std::next(it)->first != idx + 1) {
-                        // this is the left child of its parent and is missing
-                        // its right child
-                        hashes[(idx - 1) / 2] =
-                            HashTreeT::get_hash(hash, hash_defaults[layer]);
-                    } else {
-                        // typical case: this is the left child of the parent
-                        // and adjacent to it there is a right child
-                        hashes[(idx - 1) / 2] =
-                            HashTreeT::get_hash(hash, std::next(it)->second);
-                        ++it;
-                    }
-                }
-            }
-            last_it = next_last_it;
-        }
-    }
+template<typename FieldT, typename HashTreeT, typename StorageT>
+merkle_tree_field<FieldT, HashTreeT, StorageT>::merkle_tree_field(
+    StorageT &&storage)
+    : hash_defaults(storage.get_defaults())
+    , nodes(std::move(storage))
+    , depth(hash_defaults.size() - 1)
+{
 }
 
-template<typename FieldT, typename HashTreeT>
-FieldT merkle_tree_field<FieldT, HashTreeT>::get_value(
+template<typename FieldT, typename HashTreeT, typename StorageT>
+FieldT merkle_tree_field<FieldT, HashTreeT, StorageT>::get_value(
     const size_t address) const
 {
     assert(libff::log2(address) <= depth);
 
-    auto it = values.find(address);
-    FieldT result = (it == values.end() ? FieldT("0") : it->second);
-
-    return result;
+    // The default value of the leaves is zero
+    return nodes.get(depth, address);
 }
 
-template<typename FieldT, typename HashTreeT>
-void merkle_tree_field<FieldT, HashTreeT>::set_value(
+template<typename FieldT, typename HashTreeT, typename StorageT>
+void merkle_tree_field<FieldT, HashTreeT, StorageT>::set_value(
     const size_t address, const FieldT &value)
 {
     assert(libff::log2(address) <= depth);
 
-    values[address] = value;
+    nodes.set(depth, address, value);
 
     // After adding the value, we update the nodes on its merkle path
-    size_t idx = address + (1ul << depth) - 1;
-    hashes[idx] =
-        value; // The last element on the merkle path is the leaf value itself
-    for (int layer = depth - 1; layer >= 0; --layer) {
-        idx = (idx - 1) / 2;
+    size_t pos = address;
+    for (size_t layer = depth; layer > 0; --layer) {
+        const size_t left = pos & ~size_t(1);
+        const FieldT h = HashTreeT::get_hash(
+            nodes.get(layer, left), nodes.get(layer, left + 1));
 
-        auto it = hashes.find(2 * idx + 1);
-        FieldT l = (it == hashes.end() ? hash_defaults[layer + 1] : it->second);
+        pos = pos / 2;
+        nodes.set(layer - 1, pos, h);
+    }
+}
 
-        it = hashes.find(2 * idx + 2);
-        FieldT r = (it == hashes.end() ? hash_defaults[layer + 1] : it->second);
+template<typename FieldT, typename HashTreeT, typename StorageT>
+void merkle_tree_field<FieldT, HashTreeT, StorageT>::set_values(
+    const std::map<size_t, FieldT> &values)
+{
+    if (values.empty()) {
+        return;
+    }
+    assert(libff::log2(values.rbegin()->first) <= depth);
 
-        FieldT h = HashTreeT::get_hash(l, r);
-        hashes[idx] = h;
+    std::vector<size_t> positions;
+    positions.reserve(values.size());
+    for (auto it = values.begin(); it != values.end(); ++it) {
+        nodes.set(depth, it->first, it->second);
+        positions.push_back(it->first);
     }
+
+    update_ancestors(std::move(positions));
 }
 
-template<typename FieldT, typename HashTreeT>
-FieldT merkle_tree_field<FieldT, HashTreeT>::get_root() const
+template<typename FieldT, typename HashTreeT, typename StorageT>
+void merkle_tree_field<FieldT, HashTreeT, StorageT>::set_values(
+    const size_t first_address, const std::vector<FieldT> &values)
 {
-    auto it = hashes.find(0);
-    return (it == hashes.end() ? hash_defaults[0] : it->second);
+    if (values.empty()) {
+        return;
+    }
+    assert(libff::log2(first_address + values.size() - 1) <= depth);
+
+    std::vector<size_t> positions;
+    positions.reserve(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        nodes.set(depth, first_address + i, values[i]);
+        positions.push_back(first_address + i);
+    }
+
+    update_ancestors(std::move(positions));
 }
 
-template<typename FieldT, typename HashTreeT>
-std::vector<FieldT> merkle_tree_field<FieldT, HashTreeT>::get_path(
-    const size_t address) const
+template<typename FieldT, typename HashTreeT, typename StorageT>
+FieldT merkle_tree_field<FieldT, HashTreeT, StorageT>::get_root() const
 {
+    return nodes.get(0, 0);
+}
 
-    // Create empty vector of size depth
-    std::vector<FieldT> result(depth);
-
+template<typename FieldT, typename HashTreeT, typename StorageT>
+std::vector<FieldT> merkle_tree_field<FieldT, HashTreeT, StorageT>::get_path(
+    const size_t address) const
+{
     // Check that the node given has address within tree range
     assert(libff::log2(address) <= depth);
 
-    // Compute node address on tree
-    size_t idx = address + (1ul << depth) - 1;
+    // The path is made of the siblings of the nodes from the leaf (first) to
+    // the root (excluded)
+    std::vector<FieldT> result;
+    result.reserve(depth);
 
-    // For each layer
+    size_t pos = address;
     for (size_t layer = depth; layer > 0; --layer) {
-        // Compute the sibling node address and retrieve it
-        size_t sibling_idx = ((idx + 1) ^ 1) - 1;
-        auto it = hashes.find(sibling_idx);
-
-        // If last layer, retrieve sibling node value from vector values, else
-        // from vector hashes
-        if (layer == depth) {
-            auto it2 = values.find(sibling_idx - ((1ul << depth) - 1));
-            result[layer - 1] =
-                (it2 == values.end() ? FieldT("0") : it2->second);
-        } else {
-            result[layer - 1] =
-                (it == hashes.end() ? hash_defaults[layer] : it->second);
-        }
-
-        idx = (idx - 1) / 2;
+        result.push_back(nodes.get(layer, pos ^ 1));
+        pos = pos / 2;
     }
 
-    std::reverse(result.begin(), result.end());
     return result;
 }
 
-template<typename FieldT, typename HashTreeT>
-void merkle_tree_field<FieldT, HashTreeT>::dump() const
+template<typename FieldT, typename HashTreeT, typename StorageT>
+void merkle_tree_field<FieldT, HashTreeT, StorageT>::dump() const
 {
     // `1ul << depth`  returns the total number of leaves in the merkle tree of
-    // depth `depth` Print the tree leaves (stored in the `values` map)
+    // depth `depth`
     std::cout << "* Merkle Tree Leaves" << std::endl;
     for (size_t i = 0; i < 1ul << depth; ++i) {
-        auto it = values.find(i);
-        const FieldT value = (it == values.end() ? FieldT("0") : it->second);
-        std::cout << "[" << i << "] -> " << value << std::endl;
+        std::cout << "[" << i << "] -> " << get_value(i) << std::endl;
     }
 
     // We also dump the updated merkle path (after the insertion of the leaves)
     // and the value of the values in `hash_defaults` for a
     // debugging/information purpose To remove if this is useless.
     //
-    // Print the inner nodes of the tree
+    // Print the inner nodes of the tree, indexed by their position in the
+    // flattened tree (the children of node i are 2i+1 and 2i+2)
     std::cout << "* Merkle Tree Inner Nodes (Debug)" << std::endl;
-    for (auto it = hashes.cbegin(); it != hashes.cend(); ++it) {
-        std::cout << "[" << it->first << "] -> " << it->second << std::endl;
-    }
+    const size_t tree_depth = depth;
+    nodes.for_each(
+        [tree_depth](size_t layer, size_t pos, const FieldT &value) {
+            if (layer < tree_depth) {
+                const size_t idx = pos + (1ul << layer) - 1;
+                std::cout << "[" << idx << "] -> " << value << std::endl;
+            }
+        });
     std::cout << "* Merkle Tree `hash_defaults` (Debug)" << std::endl;
     for (size_t i = 0; i < hash_defaults.size(); i++) {
         std::cout << hash_defaults[i] << std::endl;
     }
 }
 
+template<typename FieldT, typename HashTreeT, typename StorageT>
+std::vector<FieldT> merkle_tree_field<FieldT, HashTreeT, StorageT>::
+    compute_hash_defaults(const size_t depth)
+{
+    assert(depth < sizeof(size_t) * 8);
+
+    // Value of the leaves when initializing the merkle tree
+    FieldT last = FieldT::zero();
+
+    // Length of a merkle path = depth + 1
+    // `hash_defaults` contains the default value of a merkle path
+    // ie: The recursive hash of the zero valued leaves
+    std::vector<FieldT> hash_defaults;
+    hash_defaults.reserve(depth + 1);
+    hash_defaults.emplace_back(last);
+    for (size_t i = 0; i < depth; ++i) {
+        last = HashTreeT::get_hash(last, last);
+        hash_defaults.push_back(last);
+    }
+
+    std::reverse(hash_defaults.begin(), hash_defaults.end());
+    return hash_defaults;
+}
+
+template<typename FieldT, typename HashTreeT, typename StorageT>
+void merkle_tree_field<FieldT, HashTreeT, StorageT>::update_ancestors(
+    std::vector<size_t> positions)
+{
+    for (size_t layer = depth; layer > 0; --layer) {
+        // Parents of the dirty nodes of this layer, each listed once (even
+        // when both of its children are dirty)
+        std::vector<size_t> parents;
+        parents.reserve(positions.size());
+        for (const size_t pos : positions) {
+            const size_t parent = pos / 2;
+            if (parents.empty() || parents.back() != parent) {
+                parents.push_back(parent);
+            }
+        }
+
+        // The storage is only read while hashing, and written afterwards
+        std::vector<FieldT> parent_nodes(parents.size());
+#ifdef MULTICORE
+#pragma omp parallel for
+#endif
+        for (size_t i = 0; i < parents.size(); ++i) {
+            parent_nodes[i] = HashTreeT::get_hash(
+                nodes.get(layer, 2 * parents[i]),
+                nodes.get(layer, 2 * parents[i] + 1));
+        }
+
+        for (size_t i = 0; i < parents.size(); ++i) {
+            nodes.set(layer - 1, parents[i], parent_nodes[i]);
+        }
+
+        positions.swap(parents);
+    }
+}
+
 } // namespace libzeth
 
 #endif // __ZETH_TYPES_MERKLE_TREE_FIELD_TCC__
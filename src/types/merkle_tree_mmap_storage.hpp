@@ -0,0 +1,103 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_TYPES_MERKLE_TREE_MMAP_STORAGE_HPP__
+#define __ZETH_TYPES_MERKLE_TREE_MMAP_STORAGE_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace libzeth
+{
+
+// Persistent storage policy for merkle_tree_field (see
+// merkle_tree_storage.hpp), backed by a memory-mapped file.
+//
+// File layout:
+// - a header holding the depth, the size of the field elements, the
+//   `defaults` (hash_defaults of the tree) and two commit slots,
+// - the nodes, one dense array per layer (layer l holds 2^l nodes). The file
+//   is created sparse, so that only the pages of populated nodes use disk
+//   space.
+//
+// Reopening an existing file maps it in O(1): nothing is rehashed.
+//
+// Crash safety: nodes are written in place, and `flush` makes the current
+// state durable by syncing the nodes and then writing a commit record (the
+// number of leaves and the right-most node of each layer) to the oldest of the
+// two header slots. After a crash, the tree is restored to the last commit:
+// nodes past the committed frontier are ignored, and the right-most node of
+// each layer (the only committed nodes that appending leaves overwrites) is
+// taken from the commit record. This holds for trees that are filled from the
+// left, such as the commitment tree. Overwriting committed leaves is not
+// crash-safe.
+//
+// Field elements are stored as their in-memory representation, so files are
+// not portable across architectures or field implementations (the size of
+// the elements and the defaults are checked when opening a file).
+template<typename FieldT> class merkle_tree_mmap_storage
+{
+private:
+    std::string filename;
+    int fd;
+    uint8_t *data;
+    size_t data_size;
+
+    size_t depth;
+    size_t header_size;
+    std::vector<FieldT> defaults;
+    // Number of nodes (from position 0) of each layer which may differ from
+    // the default value
+    std::vector<size_t> layer_sizes;
+    // Generation and number of leaves of the last commit
+    uint64_t generation;
+    uint64_t committed;
+
+    FieldT *layer_data(const size_t layer) const;
+    uint8_t *slot_data(const size_t slot) const;
+    size_t slot_size() const;
+
+    void map_file(const size_t depth);
+    void create(const std::vector<FieldT> &defaults);
+    void open_existing();
+    bool read_slot(
+        const size_t slot,
+        uint64_t &slot_generation,
+        uint64_t &num_leaves,
+        std::vector<FieldT> &border) const;
+    void recover();
+    void unmap();
+
+public:
+    // Open the file `filename` if it exists (checking that it matches
+    // `defaults`), or create it.
+    merkle_tree_mmap_storage(
+        const std::string &filename, const std::vector<FieldT> &defaults);
+    // Open the existing file `filename`, reading the defaults from its header
+    merkle_tree_mmap_storage(const std::string &filename);
+    merkle_tree_mmap_storage(merkle_tree_mmap_storage &&other);
+    merkle_tree_mmap_storage(const merkle_tree_mmap_storage &other) = delete;
+    merkle_tree_mmap_storage &operator=(const merkle_tree_mmap_storage &other) =
+        delete;
+    // Flushes the tree before unmapping the file
+    ~merkle_tree_mmap_storage();
+
+    const std::vector<FieldT> &get_defaults() const;
+    const FieldT &get(const size_t layer, const size_t pos) const;
+    void set(const size_t layer, const size_t pos, const FieldT &value);
+    void set_layer(const size_t layer, std::vector<FieldT> &&values);
+    template<typename FunctionT> void for_each(FunctionT f) const;
+
+    // Number of leaves in the last commit
+    size_t committed_leaves() const;
+    // Make the current state of the tree durable
+    void flush();
+};
+
+} // namespace libzeth
+#include "merkle_tree_mmap_storage.tcc"
+
+#endif // __ZETH_TYPES_MERKLE_TREE_MMAP_STORAGE_HPP__
@@ -0,0 +1,417 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_TYPES_MERKLE_TREE_MMAP_STORAGE_TCC__
+#define __ZETH_TYPES_MERKLE_TREE_MMAP_STORAGE_TCC__
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace libzeth
+{
+
+const char merkle_tree_mmap_magic[8] = {'Z', 'E', 'T', 'H', 'M', 'K', 'T', 0};
+const uint32_t merkle_tree_mmap_version = 1;
+// Size of the fixed part of the header (magic, version, field size, depth)
+const size_t merkle_tree_mmap_fixed_header_size = 24;
+// Size of the fixed part of a commit slot (generation, leaves, checksum)
+const size_t merkle_tree_mmap_fixed_slot_size = 24;
+// The nodes start on a page boundary
+const size_t merkle_tree_mmap_alignment = 4096;
+// Bound on the depth, to keep the (sparse) file size reasonable
+const size_t merkle_tree_mmap_max_depth = 40;
+
+static inline uint64_t merkle_tree_mmap_checksum(
+    const uint8_t *data, const size_t size, uint64_t hash = 0xcbf29ce484222325)
+{
+    // FNV-1a
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * 0x100000001b3;
+    }
+    return hash;
+}
+
+static inline std::runtime_error merkle_tree_mmap_error(
+    const std::string &what, const std::string &filename)
+{
+    return std::runtime_error(
+        what + " " + filename + ": " + std::string(strerror(errno)));
+}
+
+template<typename FieldT>
+merkle_tree_mmap_storage<FieldT>::merkle_tree_mmap_storage(
+    const std::string &filename, const std::vector<FieldT> &defaults)
+    : filename(filename), fd(-1), data(nullptr), data_size(0)
+{
+    try {
+        fd = ::open(filename.c_str(), O_RDWR);
+        if (fd >= 0) {
+            open_existing();
+            if (this->defaults != defaults) {
+                throw std::invalid_argument(
+                    "Merkle tree file " + filename +
+                    " does not match the tree parameters");
+            }
+        } else if (errno == ENOENT) {
+            create(defaults);
+        } else {
+            throw merkle_tree_mmap_error("Cannot open", filename);
+        }
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+template<typename FieldT>
+merkle_tree_mmap_storage<FieldT>::merkle_tree_mmap_storage(
+    const std::string &filename)
+    : filename(filename), fd(-1), data(nullptr), data_size(0)
+{
+    fd = ::open(filename.c_str(), O_RDWR);
+    if (fd < 0) {
+        throw merkle_tree_mmap_error("Cannot open", filename);
+    }
+
+    try {
+        open_existing();
+    } catch (...) {
+        unmap();
+        throw;
+    }
+}
+
+template<typename FieldT>
+merkle_tree_mmap_storage<FieldT>::merkle_tree_mmap_storage(
+    merkle_tree_mmap_storage &&other)
+    : filename(std::move(other.filename))
+    , fd(other.fd)
+    , data(other.data)
+    , data_size(other.data_size)
+    , depth(other.depth)
+    , header_size(other.header_size)
+    , defaults(std::move(other.defaults))
+    , layer_sizes(std::move(other.layer_sizes))
+    , generation(other.generation)
+    , committed(other.committed)
+{
+    other.fd = -1;
+    other.data = nullptr;
+}
+
+template<typename FieldT>
+merkle_tree_mmap_storage<FieldT>::~merkle_tree_mmap_storage()
+{
+    if (data != nullptr) {
+        try {
+            flush();
+        } catch (const std::exception &e) {
+            std::cerr << "[ERROR] Failed to flush " << filename << ": "
+                      << e.what() << std::endl;
+        }
+    }
+    unmap();
+}
+
+template<typename FieldT>
+const std::vector<FieldT> &merkle_tree_mmap_storage<FieldT>::get_defaults()
+    const
+{
+    return defaults;
+}
+
+template<typename FieldT>
+const FieldT &merkle_tree_mmap_storage<FieldT>::get(
+    const size_t layer, const size_t pos) const
+{
+    return (
+        pos < layer_sizes[layer] ? layer_data(layer)[pos] : defaults[layer]);
+}
+
+template<typename FieldT>
+void merkle_tree_mmap_storage<FieldT>::set(
+    const size_t layer, const size_t pos, const FieldT &value)
+{
+    assert(pos < (1ul << layer));
+
+    FieldT *nodes = layer_data(layer);
+    // Any gap left of `pos` is made of empty subtrees. The file may hold
+    // stale nodes there (written after the last commit).
+    for (size_t i = layer_sizes[layer]; i < pos; ++i) {
+        memcpy(&nodes[i], &defaults[layer], sizeof(FieldT));
+    }
+    memcpy(&nodes[pos], &value, sizeof(FieldT));
+
+    if (pos >= layer_sizes[layer]) {
+        layer_sizes[layer] = pos + 1;
+    }
+}
+
+template<typename FieldT>
+void merkle_tree_mmap_storage<FieldT>::set_layer(
+    const size_t layer, std::vector<FieldT> &&values)
+{
+    assert(values.size() <= (1ul << layer));
+
+    memcpy(layer_data(layer), values.data(), values.size() * sizeof(FieldT));
+    layer_sizes[layer] = values.size();
+}
+
+template<typename FieldT>
+template<typename FunctionT>
+void merkle_tree_mmap_storage<FieldT>::for_each(FunctionT f) const
+{
+    for (size_t layer = 0; layer <= depth; ++layer) {
+        const FieldT *nodes = layer_data(layer);
+        for (size_t pos = 0; pos < layer_sizes[layer]; ++pos) {
+            f(layer, pos, nodes[pos]);
+        }
+    }
+}
+
+template<typename FieldT>
+size_t merkle_tree_mmap_storage<FieldT>::committed_leaves() const
+{
+    return committed;
+}
+
+template<typename FieldT> void merkle_tree_mmap_storage<FieldT>::flush()
+{
+    // The nodes must be durable before the commit record refers to them
+    if (msync(data + header_size, data_size - header_size, MS_SYNC) != 0) {
+        throw merkle_tree_mmap_error("Cannot sync", filename);
+    }
+
+    // Write the commit record to the oldest slot
+    const uint64_t new_generation = generation + 1;
+    const uint64_t num_leaves = layer_sizes[depth];
+    uint8_t *slot = slot_data(new_generation % 2);
+    uint8_t *border = slot + merkle_tree_mmap_fixed_slot_size;
+    for (size_t layer = 0; layer <= depth; ++layer) {
+        const size_t size = layer_sizes[layer];
+        const FieldT &node =
+            (size == 0 ? defaults[layer] : layer_data(layer)[size - 1]);
+        memcpy(border + layer * sizeof(FieldT), &node, sizeof(FieldT));
+    }
+
+    uint64_t checksum = merkle_tree_mmap_checksum(
+        reinterpret_cast<const uint8_t *>(&new_generation), sizeof(uint64_t));
+    checksum = merkle_tree_mmap_checksum(
+        reinterpret_cast<const uint8_t *>(&num_leaves),
+        sizeof(uint64_t),
+        checksum);
+    checksum = merkle_tree_mmap_checksum(
+        border, (depth + 1) * sizeof(FieldT), checksum);
+
+    memcpy(slot, &new_generation, sizeof(uint64_t));
+    memcpy(slot + 8, &num_leaves, sizeof(uint64_t));
+    memcpy(slot + 16, &checksum, sizeof(uint64_t));
+
+    if (msync(data, header_size, MS_SYNC) != 0) {
+        throw merkle_tree_mmap_error("Cannot sync", filename);
+    }
+
+    generation = new_generation;
+    committed = num_leaves;
+}
+
+template<typename FieldT>
+FieldT *merkle_tree_mmap_storage<FieldT>::layer_data(const size_t layer) const
+{
+    // Layer l is preceded by the 2^l - 1 nodes of the layers above it
+    return reinterpret_cast<FieldT *>(
+        data + header_size + ((1ul << layer) - 1) * sizeof(FieldT));
+}
+
+template<typename FieldT>
+size_t merkle_tree_mmap_storage<FieldT>::slot_size() const
+{
+    return merkle_tree_mmap_fixed_slot_size + (depth + 1) * sizeof(FieldT);
+}
+
+template<typename FieldT>
+uint8_t *merkle_tree_mmap_storage<FieldT>::slot_data(const size_t slot) const
+{
+    return data + merkle_tree_mmap_fixed_header_size +
+           (depth + 1) * sizeof(FieldT) + slot * slot_size();
+}
+
+template<typename FieldT>
+void merkle_tree_mmap_storage<FieldT>::map_file(const size_t depth)
+{
+    if (depth > merkle_tree_mmap_max_depth) {
+        throw std::invalid_argument("Merkle tree too deep to be mapped");
+    }
+
+    this->depth = depth;
+    const size_t header_data_size = merkle_tree_mmap_fixed_header_size +
+                                    (depth + 1) * sizeof(FieldT) +
+                                    2 * slot_size();
+    header_size = (header_data_size + merkle_tree_mmap_alignment - 1) /
+                  merkle_tree_mmap_alignment * merkle_tree_mmap_alignment;
+    data_size = header_size + ((1ul << (depth + 1)) - 1) * sizeof(FieldT);
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        throw merkle_tree_mmap_error("Cannot stat", filename);
+    }
+    if (size_t(file_stat.st_size) < data_size &&
+        ftruncate(fd, data_size) != 0) {
+        throw merkle_tree_mmap_error("Cannot resize", filename);
+    }
+
+    void *mapping =
+        mmap(nullptr, data_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        throw merkle_tree_mmap_error("Cannot map", filename);
+    }
+    data = static_cast<uint8_t *>(mapping);
+}
+
+template<typename FieldT>
+void merkle_tree_mmap_storage<FieldT>::create(
+    const std::vector<FieldT> &defaults)
+{
+    fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        throw merkle_tree_mmap_error("Cannot create", filename);
+    }
+
+    // The file is extended with zeros (and is sparse)
+    map_file(defaults.size() - 1);
+
+    const uint32_t field_size = sizeof(FieldT);
+    const uint64_t depth_u64 = depth;
+    memcpy(data, merkle_tree_mmap_magic, 8);
+    memcpy(data + 8, &merkle_tree_mmap_version, sizeof(uint32_t));
+    memcpy(data + 12, &field_size, sizeof(uint32_t));
+    memcpy(data + 16, &depth_u64, sizeof(uint64_t));
+    memcpy(
+        data + merkle_tree_mmap_fixed_header_size,
+        defaults.data(),
+        defaults.size() * sizeof(FieldT));
+
+    this->defaults = defaults;
+    layer_sizes.assign(depth + 1, 0);
+    generation = 0;
+    committed = 0;
+
+    // Initial (empty) commit
+    flush();
+}
+
+template<typename FieldT> void merkle_tree_mmap_storage<FieldT>::open_existing()
+{
+    uint8_t header[merkle_tree_mmap_fixed_header_size];
+    if (pread(fd, header, sizeof(header), 0) != ssize_t(sizeof(header))) {
+        throw merkle_tree_mmap_error("Cannot read header of", filename);
+    }
+
+    uint32_t version;
+    uint32_t field_size;
+    uint64_t depth_u64;
+    memcpy(&version, header + 8, sizeof(uint32_t));
+    memcpy(&field_size, header + 12, sizeof(uint32_t));
+    memcpy(&depth_u64, header + 16, sizeof(uint64_t));
+    if (memcmp(header, merkle_tree_mmap_magic, 8) != 0 ||
+        version != merkle_tree_mmap_version || field_size != sizeof(FieldT)) {
+        throw std::invalid_argument(
+            "Invalid or incompatible Merkle tree file " + filename);
+    }
+
+    map_file(depth_u64);
+
+    const FieldT *header_defaults = reinterpret_cast<const FieldT *>(
+        data + merkle_tree_mmap_fixed_header_size);
+    defaults.assign(header_defaults, header_defaults + depth + 1);
+
+    recover();
+}
+
+template<typename FieldT>
+bool merkle_tree_mmap_storage<FieldT>::read_slot(
+    const size_t slot,
+    uint64_t &slot_generation,
+    uint64_t &num_leaves,
+    std::vector<FieldT> &border) const
+{
+    const uint8_t *slot_bytes = slot_data(slot);
+    const uint8_t *border_bytes = slot_bytes + merkle_tree_mmap_fixed_slot_size;
+    uint64_t checksum;
+    memcpy(&slot_generation, slot_bytes, sizeof(uint64_t));
+    memcpy(&num_leaves, slot_bytes + 8, sizeof(uint64_t));
+    memcpy(&checksum, slot_bytes + 16, sizeof(uint64_t));
+
+    uint64_t expected = merkle_tree_mmap_checksum(slot_bytes, 16);
+    expected = merkle_tree_mmap_checksum(
+        border_bytes, (depth + 1) * sizeof(FieldT), expected);
+    if (slot_generation == 0 || checksum != expected ||
+        num_leaves > (1ul << depth)) {
+        return false;
+    }
+
+    const FieldT *border_nodes =
+        reinterpret_cast<const FieldT *>(border_bytes);
+    border.assign(border_nodes, border_nodes + depth + 1);
+    return true;
+}
+
+// Restore the state of the last commit (see merkle_tree_mmap_storage.hpp)
+template<typename FieldT> void merkle_tree_mmap_storage<FieldT>::recover()
+{
+    uint64_t slot_generation[2];
+    uint64_t slot_leaves[2];
+    std::vector<FieldT> slot_border[2];
+    bool valid[2];
+    for (size_t slot = 0; slot < 2; ++slot) {
+        valid[slot] = read_slot(
+            slot, slot_generation[slot], slot_leaves[slot], slot_border[slot]);
+    }
+
+    if (!valid[0] && !valid[1]) {
+        throw std::runtime_error("No valid commit in " + filename);
+    }
+    const size_t last = (!valid[0] || (valid[1] && slot_generation[1] >
+                                                       slot_generation[0]))
+                            ? 1
+                            : 0;
+
+    generation = slot_generation[last];
+    committed = slot_leaves[last];
+    layer_sizes.resize(depth + 1);
+    for (size_t layer = 0; layer <= depth; ++layer) {
+        const size_t leaves_per_node = 1ul << (depth - layer);
+        layer_sizes[layer] =
+            (committed + leaves_per_node - 1) / leaves_per_node;
+        if (layer_sizes[layer] > 0) {
+            memcpy(
+                &layer_data(layer)[layer_sizes[layer] - 1],
+                &slot_border[last][layer],
+                sizeof(FieldT));
+        }
+    }
+}
+
+template<typename FieldT> void merkle_tree_mmap_storage<FieldT>::unmap()
+{
+    if (data != nullptr) {
+        munmap(data, data_size);
+        data = nullptr;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_TYPES_MERKLE_TREE_MMAP_STORAGE_TCC__
@@ -0,0 +1,82 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_TYPES_MERKLE_TREE_STORAGE_HPP__
+#define __ZETH_TYPES_MERKLE_TREE_STORAGE_HPP__
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace libzeth
+{
+
+// Storage policies for the nodes of merkle_tree_field.
+//
+// Nodes are addressed by (layer, position), where layer 0 holds the root and
+// layer `depth` holds the leaves. A storage policy is constructed from the
+// value of an empty node at each layer (`defaults`, with `defaults.size() ==
+// depth + 1`) and exposes:
+//
+// {
+//   const std::vector<FieldT> &get_defaults() const;
+//   const FieldT &get(const size_t layer, const size_t pos) const;
+//   void set(const size_t layer, const size_t pos, const FieldT &value);
+//   // Replace the whole layer by the nodes at positions 0..values.size()-1
+//   void set_layer(const size_t layer, std::vector<FieldT> &&values);
+//   // Call f(layer, pos, value) on every stored node, layer by layer and by
+//   // increasing position.
+//   template<typename FunctionT> void for_each(FunctionT f) const;
+// }
+//
+// `get` returns the default of the layer for nodes that were never set. See
+// also merkle_tree_mmap_storage.hpp for a persistent storage.
+
+// Sparse storage backed by one std::map per layer. Suitable for trees where
+// leaves are scattered over the whole address space.
+template<typename FieldT> class merkle_tree_map_storage
+{
+private:
+    std::vector<FieldT> defaults;
+    std::vector<std::map<size_t, FieldT>> layers;
+
+public:
+    merkle_tree_map_storage(const std::vector<FieldT> &defaults);
+
+    const std::vector<FieldT> &get_defaults() const;
+    const FieldT &get(const size_t layer, const size_t pos) const;
+    void set(const size_t layer, const size_t pos, const FieldT &value);
+    void set_layer(const size_t layer, std::vector<FieldT> &&values);
+    template<typename FunctionT> void for_each(FunctionT f) const;
+};
+
+// Dense storage backed by one contiguous array per layer, covering positions
+// from 0 to the right-most node set on that layer. Nodes past the end of the
+// array are empty subtrees and take the default value of the layer.
+//
+// This avoids the tree lookups and pointer chasing of the map storage, and
+// suits trees filled from the left (as is the case for the append-only
+// commitment tree), where the arrays only span the populated frontier. Memory
+// is proportional to the right-most address set, so this storage is not
+// adapted to sparse trees.
+template<typename FieldT> class merkle_tree_array_storage
+{
+private:
+    std::vector<FieldT> defaults;
+    std::vector<std::vector<FieldT>> layers;
+
+public:
+    merkle_tree_array_storage(const std::vector<FieldT> &defaults);
+
+    const std::vector<FieldT> &get_defaults() const;
+    const FieldT &get(const size_t layer, const size_t pos) const;
+    void set(const size_t layer, const size_t pos, const FieldT &value);
+    void set_layer(const size_t layer, std::vector<FieldT> &&values);
+    template<typename FunctionT> void for_each(FunctionT f) const;
+};
+
+} // namespace libzeth
+#include "merkle_tree_storage.tcc"
+
+#endif // __ZETH_TYPES_MERKLE_TREE_STORAGE_HPP__
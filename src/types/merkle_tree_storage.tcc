@@ -0,0 +1,116 @@
+// Copyright (c) 2015-2019 Clearmatics Technologies Ltd
+//
+// SPDX-License-Identifier: LGPL-3.0+
+
+#ifndef __ZETH_TYPES_MERKLE_TREE_STORAGE_TCC__
+#define __ZETH_TYPES_MERKLE_TREE_STORAGE_TCC__
+
+namespace libzeth
+{
+
+template<typename FieldT>
+merkle_tree_map_storage<FieldT>::merkle_tree_map_storage(
+    const std::vector<FieldT> &defaults)
+    : defaults(defaults), layers(defaults.size())
+{
+}
+
+template<typename FieldT>
+const std::vector<FieldT> &merkle_tree_map_storage<FieldT>::get_defaults()
+    const
+{
+    return defaults;
+}
+
+template<typename FieldT>
+const FieldT &merkle_tree_map_storage<FieldT>::get(
+    const size_t layer, const size_t pos) const
+{
+    auto it = layers[layer].find(pos);
+    return (it == layers[layer].end() ? defaults[layer] : it->second);
+}
+
+template<typename FieldT>
+void merkle_tree_map_storage<FieldT>::set(
+    const size_t layer, const size_t pos, const FieldT &value)
+{
+    layers[layer][pos] = value;
+}
+
+template<typename FieldT>
+void merkle_tree_map_storage<FieldT>::set_layer(
+    const size_t layer, std::vector<FieldT> &&values)
+{
+    std::map<size_t, FieldT> &nodes = layers[layer];
+    nodes.clear();
+    for (size_t pos = 0; pos < values.size(); ++pos) {
+        nodes.emplace_hint(nodes.end(), pos, values[pos]);
+    }
+}
+
+template<typename FieldT>
+template<typename FunctionT>
+void merkle_tree_map_storage<FieldT>::for_each(FunctionT f) const
+{
+    for (size_t layer = 0; layer < layers.size(); ++layer) {
+        for (const auto &node : layers[layer]) {
+            f(layer, node.first, node.second);
+        }
+    }
+}
+
+template<typename FieldT>
+merkle_tree_array_storage<FieldT>::merkle_tree_array_storage(
+    const std::vector<FieldT> &defaults)
+    : defaults(defaults), layers(defaults.size())
+{
+}
+
+template<typename FieldT>
+const std::vector<FieldT> &merkle_tree_array_storage<FieldT>::get_defaults()
+    const
+{
+    return defaults;
+}
+
+template<typename FieldT>
+const FieldT &merkle_tree_array_storage<FieldT>::get(
+    const size_t layer, const size_t pos) const
+{
+    const std::vector<FieldT> &nodes = layers[layer];
+    return (pos < nodes.size() ? nodes[pos] : defaults[layer]);
+}
+
+template<typename FieldT>
+void merkle_tree_array_storage<FieldT>::set(
+    const size_t layer, const size_t pos, const FieldT &value)
+{
+    std::vector<FieldT> &nodes = layers[layer];
+    if (pos >= nodes.size()) {
+        // Any gap left of `pos` is made of empty subtrees
+        nodes.resize(pos + 1, defaults[layer]);
+    }
+    nodes[pos] = value;
+}
+
+template<typename FieldT>
+void merkle_tree_array_storage<FieldT>::set_layer(
+    const size_t layer, std::vector<FieldT> &&values)
+{
+    layers[layer] = std::move(values);
+}
+
+template<typename FieldT>
+template<typename FunctionT>
+void merkle_tree_array_storage<FieldT>::for_each(FunctionT f) const
+{
+    for (size_t layer = 0; layer < layers.size(); ++layer) {
+        for (size_t pos = 0; pos < layers[layer].size(); ++pos) {
+            f(layer, pos, layers[layer][pos]);
+        }
+    }
+}
+
+} // namespace libzeth
+
+#endif // __ZETH_TYPES_MERKLE_TREE_STORAGE_TCC__
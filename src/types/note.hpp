@@ -18,7 +18,7 @@ protected:
     bits64 value_;
 
 public:
-    base_note() { value_.fill(false); }
+    base_note() : value_() {}
     base_note(bits64 value) : value_(value){};
     virtual ~base_note(){};
 
@@ -27,9 +27,7 @@ public:
     // Test if the note is a 0-valued note
     inline bool is_zero_valued() const
     {
-        bits64 zero;
-        zero.fill(false);
-        return value_ == zero;
+        return value_ == bits64();
     }
 };
 
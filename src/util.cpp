@@ -8,6 +8,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include <vector>
 
@@ -139,6 +140,43 @@ bits64 hex_value_to_bits64(std::string str)
     return get_bits64_from_vector(hex_to_binary_vector(str));
 }
 
+// Takes a string of bytes and converts it into a binary vector (most
+// significant bit of each byte first)
+std::vector<bool> bytes_to_binary_vector(const std::string &bytes)
+{
+    std::vector<bool> result;
+    result.reserve(bytes.size() * 8);
+    for (const char c : bytes) {
+        const uint8_t byte = (uint8_t)c;
+        for (int i = 7; i >= 0; --i) {
+            result.push_back((byte >> i) & 1);
+        }
+    }
+
+    return result;
+}
+
+bits256 bytes_digest_to_bits256(const std::string &bytes)
+{
+    if (bytes.size() != ZETH_DIGEST_BIT_SIZE / 8) {
+        throw std::length_error(
+            "Invalid byte length for the given digest (should be "
+            "ZETH_DIGEST_BIT_SIZE / 8)");
+    }
+
+    return bits256::from_bytes(bytes);
+}
+
+bits64 bytes_value_to_bits64(const std::string &bytes)
+{
+    if (bytes.size() != 8) {
+        throw std::length_error(
+            "Invalid byte length for the given value (should be 8)");
+    }
+
+    return bits64::from_bytes(bytes);
+}
+
 std::vector<bool> address_bits_from_address(int address, size_t tree_depth)
 {
     std::vector<bool> binary = convert_int_to_binary(address);
@@ -249,4 +287,18 @@ std::string binary_str_to_hexadecimal_str(const std::string &s)
     return out;
 }
 
+// Split a comma-separated list, skipping empty items
+std::vector<std::string> split_list(const std::string &list)
+{
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
 } // namespace libzeth
@@ -28,10 +28,26 @@ std::vector<bool> address_bits_from_address(int address, size_t tree_depth);
 
 template<typename FieldT> FieldT string_to_field(std::string input);
 
+// Binary counterparts of the hex conversions above, where digests, values and
+// field elements are given as fixed-size big-endian byte strings. These throw
+// std::length_error if the input does not have the expected size.
+std::vector<bool> bytes_to_binary_vector(const std::string &bytes);
+bits256 bytes_digest_to_bits256(const std::string &bytes);
+bits64 bytes_value_to_bits64(const std::string &bytes);
+
+// Convert a big-endian byte string of the size of the field modulus into a
+// FieldT element. Throws std::invalid_argument if the value is not smaller
+// than the modulus.
+template<typename FieldT> FieldT bytes_to_field(const std::string &bytes);
+template<typename FieldT> std::string field_to_bytes(const FieldT &element);
+
 std::string hexadecimal_str_to_binary_str(const std::string &s);
 std::string binary_str_to_hexadecimal_str(const void *s, const size_t size);
 std::string binary_str_to_hexadecimal_str(const std::string &s);
 
+// Split a comma-separated list, skipping empty items
+std::vector<std::string> split_list(const std::string &list);
+
 // interface for StructuredT typed below:
 // {
 //   bool is_well_formed() const;
@@ -47,10 +63,21 @@ void check_well_formed(const StructuredT &v, const char *name);
 template<typename StructuredT>
 void check_well_formed_(const StructuredT &v, const char *name);
 
-//  For some iterable container of objects comforming to StructuredT, throw if
-//  any entry is not well-formed.
+//  Call f(begin, end) on consecutive chunks of at most `chunk_size` indices
+//  covering [0, num_entries), where f returns false to signal a failure. When
+//  built with MULTICORE, chunks are distributed across threads. After the
+//  first failure, the chunks which have not started yet are skipped. Returns
+//  true if f succeeded on every chunk. f must not throw.
+template<typename FunctionT>
+bool parallel_for_chunks(
+    const size_t num_entries, const size_t chunk_size, FunctionT f);
+
+//  For some random-access container of objects comforming to StructuredT,
+//  return false if any entry is not well-formed. Entries are checked in
+//  parallel, by chunks of `chunk_size` entries (see parallel_for_chunks).
 template<typename StructuredTs>
-bool container_is_well_formed(const StructuredTs &values);
+bool container_is_well_formed(
+    const StructuredTs &values, const size_t chunk_size = 1 << 10);
 
 } // namespace libzeth
 #include "util.tcc"
@@ -7,6 +7,9 @@
 
 #include "util.hpp"
 
+#include <algorithm>
+#include <atomic>
+
 namespace libzeth
 {
 
@@ -95,16 +98,84 @@ template<typename FieldT> FieldT string_to_field(std::string input)
     return element;
 }
 
-template<typename StructuredTs>
-bool container_is_well_formed(const StructuredTs &values)
+template<typename FieldT> FieldT bytes_to_field(const std::string &bytes)
+{
+    const size_t limb_bytes = sizeof(mp_limb_t);
+    const size_t num_bytes = FieldT::num_limbs * limb_bytes;
+    if (bytes.size() != num_bytes) {
+        throw std::length_error(
+            "Invalid byte length for the given field element");
+    }
+
+    // The most significant limb comes first
+    libff::bigint<FieldT::num_limbs> value;
+    value.clear();
+    for (size_t i = 0; i < num_bytes; ++i) {
+        mp_limb_t &limb = value.data[FieldT::num_limbs - 1 - i / limb_bytes];
+        limb = (limb << 8) | (uint8_t)bytes[i];
+    }
+
+    if (mpn_cmp(value.data, FieldT::mod.data, FieldT::num_limbs) >= 0) {
+        throw std::invalid_argument("Field element out of range");
+    }
+
+    return FieldT(value);
+}
+
+template<typename FieldT> std::string field_to_bytes(const FieldT &element)
 {
-    for (const auto &v : values) {
-        if (!v.is_well_formed()) {
-            return false;
+    const size_t limb_bytes = sizeof(mp_limb_t);
+    const libff::bigint<FieldT::num_limbs> value = element.as_bigint();
+
+    std::string bytes(FieldT::num_limbs * limb_bytes, 0);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        const mp_limb_t limb =
+            value.data[FieldT::num_limbs - 1 - i / limb_bytes];
+        bytes[i] = (char)(limb >> (8 * (limb_bytes - 1 - i % limb_bytes)));
+    }
+
+    return bytes;
+}
+
+template<typename FunctionT>
+bool parallel_for_chunks(
+    const size_t num_entries, const size_t chunk_size, FunctionT f)
+{
+    const size_t num_chunks = (num_entries + chunk_size - 1) / chunk_size;
+    // Cleared by the first failing chunk
+    std::atomic<bool> success(true);
+
+#ifdef MULTICORE
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        if (!success.load(std::memory_order_relaxed)) {
+            continue;
+        }
+
+        const size_t begin = chunk * chunk_size;
+        const size_t end = std::min(begin + chunk_size, num_entries);
+        if (!f(begin, end)) {
+            success.store(false, std::memory_order_relaxed);
         }
     }
 
-    return true;
+    return success.load();
+}
+
+template<typename StructuredTs>
+bool container_is_well_formed(
+    const StructuredTs &values, const size_t chunk_size)
+{
+    return parallel_for_chunks(
+        values.size(), chunk_size, [&values](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                if (!values[i].is_well_formed()) {
+                    return false;
+                }
+            }
+            return true;
+        });
 }
 
 template<typename StructuredT>
@@ -20,6 +20,21 @@ zeth_note parse_zeth_note(const prover_proto::ZethNote &note)
     return zeth_note(note_apk, note_value, note_rho, note_trap_r);
 }
 
+zeth_note parse_zeth_note(const prover_proto::ZethNoteBinary &note)
+{
+    if (note.trap_r().size() != 48) {
+        throw std::length_error("Invalid byte length for trap_r");
+    }
+
+    bits256 note_apk = bytes_digest_to_bits256(note.apk());
+    bits64 note_value = bytes_value_to_bits64(note.value());
+    bits256 note_rho = bytes_digest_to_bits256(note.rho());
+    bits384 note_trap_r =
+        get_bits384_from_vector(bytes_to_binary_vector(note.trap_r()));
+
+    return zeth_note(note_apk, note_value, note_rho, note_trap_r);
+}
+
 prover_proto::HexPointBaseGroup1Affine format_hexPointBaseGroup1Affine(
     libff::alt_bn128_G1 point)
 {
@@ -58,4 +73,94 @@ prover_proto::HexPointBaseGroup2Affine format_hexPointBaseGroup2Affine(
     return res;
 }
 
+std::string format_binaryPointBaseGroup1Affine(libff::alt_bn128_G1 point)
+{
+    libff::alt_bn128_G1 aff = point;
+    aff.to_affine_coordinates();
+    return field_to_bytes(aff.X) + field_to_bytes(aff.Y);
+}
+
+std::string format_binaryPointBaseGroup2Affine(libff::alt_bn128_G2 point)
+{
+    libff::alt_bn128_G2 aff = point;
+    aff.to_affine_coordinates();
+    return field_to_bytes(aff.X.c1) + field_to_bytes(aff.X.c0) +
+           field_to_bytes(aff.Y.c1) + field_to_bytes(aff.Y.c0);
+}
+
+// Coordinates formatted by hex_from_libsnark_bigint, with a "0x" prefix
+static libff::alt_bn128_Fq parse_hex_coordinate(const std::string &coordinate)
+{
+    if (coordinate.compare(0, 2, "0x") == 0) {
+        return string_to_field<libff::alt_bn128_Fq>(coordinate.substr(2));
+    }
+    return string_to_field<libff::alt_bn128_Fq>(coordinate);
+}
+
+// The point at infinity is formatted with the affine coordinates (0, 1) (see
+// to_affine_coordinates)
+static libff::alt_bn128_G1 affine_G1(
+    const libff::alt_bn128_Fq &x, const libff::alt_bn128_Fq &y)
+{
+    if (x.is_zero() && y == libff::alt_bn128_Fq::one()) {
+        return libff::alt_bn128_G1::zero();
+    }
+    return libff::alt_bn128_G1(x, y, libff::alt_bn128_Fq::one());
+}
+
+static libff::alt_bn128_G2 affine_G2(
+    const libff::alt_bn128_Fq2 &x, const libff::alt_bn128_Fq2 &y)
+{
+    if (x.is_zero() && y == libff::alt_bn128_Fq2::one()) {
+        return libff::alt_bn128_G2::zero();
+    }
+    return libff::alt_bn128_G2(x, y, libff::alt_bn128_Fq2::one());
+}
+
+libff::alt_bn128_G1 parse_hexPointBaseGroup1Affine(
+    const prover_proto::HexPointBaseGroup1Affine &point)
+{
+    return affine_G1(
+        parse_hex_coordinate(point.x_coord()),
+        parse_hex_coordinate(point.y_coord()));
+}
+
+libff::alt_bn128_G2 parse_hexPointBaseGroup2Affine(
+    const prover_proto::HexPointBaseGroup2Affine &point)
+{
+    return affine_G2(
+        libff::alt_bn128_Fq2(
+            parse_hex_coordinate(point.x_c0_coord()),
+            parse_hex_coordinate(point.x_c1_coord())),
+        libff::alt_bn128_Fq2(
+            parse_hex_coordinate(point.y_c0_coord()),
+            parse_hex_coordinate(point.y_c1_coord())));
+}
+
+libff::alt_bn128_G1 parse_binaryPointBaseGroup1Affine(const std::string &point)
+{
+    if (point.size() != 64) {
+        throw std::length_error("Invalid byte length for a G1 point");
+    }
+
+    return affine_G1(
+        bytes_to_field<libff::alt_bn128_Fq>(point.substr(0, 32)),
+        bytes_to_field<libff::alt_bn128_Fq>(point.substr(32, 32)));
+}
+
+libff::alt_bn128_G2 parse_binaryPointBaseGroup2Affine(const std::string &point)
+{
+    if (point.size() != 128) {
+        throw std::length_error("Invalid byte length for a G2 point");
+    }
+
+    return affine_G2(
+        libff::alt_bn128_Fq2(
+            bytes_to_field<libff::alt_bn128_Fq>(point.substr(32, 32)),
+            bytes_to_field<libff::alt_bn128_Fq>(point.substr(0, 32))),
+        libff::alt_bn128_Fq2(
+            bytes_to_field<libff::alt_bn128_Fq>(point.substr(96, 32)),
+            bytes_to_field<libff::alt_bn128_Fq>(point.substr(64, 32))));
+}
+
 } // namespace libzeth
@@ -30,6 +30,27 @@ prover_proto::HexPointBaseGroup1Affine format_hexPointBaseGroup1Affine(
 prover_proto::HexPointBaseGroup2Affine format_hexPointBaseGroup2Affine(
     libff::alt_bn128_G2 point);
 
+// Binary encoding (see api/util.proto)
+zeth_note parse_zeth_note(const prover_proto::ZethNoteBinary &note);
+
+template<typename FieldT>
+joinsplit_input<FieldT> parse_joinsplit_input(
+    const prover_proto::JoinsplitInputBinary &input);
+
+// Affine coordinates as 32-byte big-endian integers: x || y for G1 points, and
+// x_c1 || x_c0 || y_c1 || y_c0 for G2 points.
+std::string format_binaryPointBaseGroup1Affine(libff::alt_bn128_G1 point);
+std::string format_binaryPointBaseGroup2Affine(libff::alt_bn128_G2 point);
+
+// Inverse of the format_* functions above (throw if the encoding is invalid).
+// The points are not checked to be on the curve.
+libff::alt_bn128_G1 parse_hexPointBaseGroup1Affine(
+    const prover_proto::HexPointBaseGroup1Affine &point);
+libff::alt_bn128_G2 parse_hexPointBaseGroup2Affine(
+    const prover_proto::HexPointBaseGroup2Affine &point);
+libff::alt_bn128_G1 parse_binaryPointBaseGroup1Affine(const std::string &point);
+libff::alt_bn128_G2 parse_binaryPointBaseGroup2Affine(const std::string &point);
+
 } // namespace libzeth
 #include "util_api.tcc"
 
@@ -42,6 +42,35 @@ joinsplit_input<FieldT> parse_joinsplit_input(
         input_nullifier);
 }
 
+template<typename FieldT>
+joinsplit_input<FieldT> parse_joinsplit_input(
+    const prover_proto::JoinsplitInputBinary &input)
+{
+    if (ZETH_MERKLE_TREE_DEPTH != input.merkle_path_size()) {
+        throw std::invalid_argument("Invalid merkle path length");
+    }
+
+    zeth_note input_note = parse_zeth_note(input.note());
+    size_t inputAddress = input.address();
+    bits_addr input_address_bits = get_bits_addr_from_vector(
+        address_bits_from_address(inputAddress, ZETH_MERKLE_TREE_DEPTH));
+    bits256 input_spending_ask = bytes_digest_to_bits256(input.spending_ask());
+    bits256 input_nullifier = bytes_digest_to_bits256(input.nullifier());
+
+    std::vector<FieldT> input_merkle_path;
+    for (int i = 0; i < ZETH_MERKLE_TREE_DEPTH; i++) {
+        input_merkle_path.push_back(
+            bytes_to_field<FieldT>(input.merkle_path(i)));
+    }
+
+    return joinsplit_input<FieldT>(
+        input_merkle_path,
+        input_address_bits,
+        input_note,
+        input_spending_ask,
+        input_nullifier);
+}
+
 } // namespace libzeth
 
 #endif // __ZETH_UTIL_API_TCC__
@@ -4,7 +4,10 @@
 #define ZETH_NUM_JS_INPUTS 2
 #define ZETH_NUM_JS_OUTPUTS 2
 
+// May be overridden at build time, see ZETH_MERKLE_TREE_DEPTH in CMakeLists.txt
+#ifndef ZETH_MERKLE_TREE_DEPTH
 #define ZETH_MERKLE_TREE_DEPTH 4
+#endif
 #define ZETH_MERKLE_TREE_DEPTH_TEST 4
 
 #define ZETH_V_SIZE 8 // 64 bits for the value